@@ -0,0 +1,569 @@
+/*
+Benchmark for the Adafruit_ImageCapture image_* postprocessing functions.
+No camera needed: each function is run over generated RGB565, YUV and
+raw Bayer frames at every OV7670 size (40x30 up to 640x480, memory
+permitting), and results are printed as CSV (lines starting with '#' are
+comments), one row per function/colorspace/image/size:
+
+  kernel,space,image,width,height,runs,ns_per_px,best_ns_per_px,mpix_per_s,
+  cycles_per_px
+
+'noise' images are uniform random pixels (worst case for branchy code),
+'scene' is a smooth synthetic picture with a few shapes and light noise,
+closer to camera output. Input is regenerated identically before every run
+and only the function itself is timed. mpix_per_s is derived from the mean.
+cycles_per_px is filled in on devices with a cycle counter (SAMD51 DWT),
+otherwise empty. For the Bayer demosaic, a '#' comment per size also gives
+the PSNR of its output against the full-color scene it was sampled from.
+JPEG encoding (Adafruit_iCap_JPEG) is timed with output discarded, and a
+comment per size and colorspace gives the compressed size of the scene at a
+few quality settings (see verify_image for its decode-back quality check).
+The lossless codec (Adafruit_iCap_QOI) is timed encoding alone, and
+encoding then decoding each row back in place (decode cost is the
+difference), with a comment giving compressed sizes for scene and noise.
+Image file output (Adafruit_iCap_writer) is timed to a counting sink, so
+it's conversion and buffering alone, without any storage.
+
+Also builds natively (Linux/macOS) against the simulated host backend,
+from the library folder:
+
+  g++ -O2 -pthread -Isrc -Isrc/arch/host -x c++
+      examples/benchmark_image/benchmark_image.ino -x none
+      $(find src -name '*.cpp') -o benchmark_image
+  ./benchmark_image > results.csv
+*/
+
+#include <Adafruit_ImageCapture.h>
+#include <Adafruit_iCap_JPEG.h>
+#include <Adafruit_iCap_QOI.h>
+#include <Adafruit_iCap_writer.h>
+#include <Arduino.h>
+#include <math.h>
+
+// TIMER BACKEND -----------------------------------------------------------
+
+#if defined(__SAMD51__)
+// Cortex-M4 DWT cycle counter, wraps every ~35 s at 120 MHz (plenty).
+#define BENCH_CYCLES
+typedef uint32_t bench_ticks;
+static void timer_begin(void) {
+  CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+  DWT->CYCCNT = 0;
+  DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+}
+static inline bench_ticks timer_read(void) { return DWT->CYCCNT; }
+static inline double ticks_to_ns(bench_ticks t) { return t * 1e9 / F_CPU; }
+#elif !defined(ARDUINO)
+// Host: monotonic nanosecond clock
+#include <time.h>
+typedef uint64_t bench_ticks;
+static void timer_begin(void) {}
+static inline bench_ticks timer_read(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+static inline double ticks_to_ns(bench_ticks t) { return (double)t; }
+#else
+// Anything else: micros(), coarse but runs are averaged
+typedef uint32_t bench_ticks;
+static void timer_begin(void) {}
+static inline bench_ticks timer_read(void) { return micros(); }
+static inline double ticks_to_ns(bench_ticks t) { return t * 1000.0; }
+#endif
+
+#define MIN_RUNS 3         // Always time at least this many runs...
+#define MAX_RUNS 100       // ...and at most this many...
+#define TARGET_NS 50000000 // ...stopping once this much time is spent
+
+// TEST IMAGES -------------------------------------------------------------
+
+// Small LCG so images are identical on every platform and every run
+static uint32_t rng_state;
+static inline uint32_t rng(void) {
+  rng_state = rng_state * 1664525 + 1013904223;
+  return rng_state >> 8;
+}
+
+static inline uint8_t clamp8(int v) { return v < 0 ? 0 : v > 255 ? 255 : v; }
+
+// Synthetic "scene" as 8-bit RGB: gradient sky, a darker ground plane, a
+// couple of discs, plus +/-4 noise so it's not unnaturally clean.
+static void scene_rgb(uint16_t x, uint16_t y, uint16_t w, uint16_t h,
+                      uint8_t *r, uint8_t *g, uint8_t *b) {
+  int rr, gg, bb;
+  if (y < h * 3 / 5) { // Sky
+    rr = 80 + 100 * y / h;
+    gg = 140 + 80 * y / h;
+    bb = 230 - 20 * x / w;
+  } else { // Ground
+    rr = 90 + 40 * x / w;
+    gg = 110 - 30 * (y - h * 3 / 5) / h;
+    bb = 50;
+  }
+  int32_t dx = x - w / 4, dy = y - h / 4;
+  if (dx * dx + dy * dy < (int32_t)(h / 8) * (h / 8)) { // Sun
+    rr = 250;
+    gg = 230;
+    bb = 120;
+  }
+  dx = x - w * 2 / 3;
+  dy = y - h * 3 / 5;
+  if (dx * dx + dy * dy < (int32_t)(h / 4) * (h / 4)) { // Bush
+    rr = 30 + (x & 15);
+    gg = 120 + (y & 31);
+    bb = 40;
+  }
+  int n = (int)(rng() & 7) - 4;
+  *r = clamp8(rr + n);
+  *g = clamp8(gg + n);
+  *b = clamp8(bb + n);
+}
+
+// Fill buffer with test image in camera-native big-endian format.
+static void make_image(uint16_t *buf, uint16_t w, uint16_t h,
+                       iCap_colorspace space, bool noise) {
+  rng_state = 12345;
+  uint8_t *p8 = (uint8_t *)buf;
+  for (uint16_t y = 0; y < h; y++) {
+    for (uint16_t x = 0; x < w; x += 2) { // Pixel pairs (for YUV422)
+      uint8_t r[2], g[2], b[2];
+      for (uint8_t i = 0; i < 2; i++) {
+        if (noise) {
+          uint32_t v = rng();
+          r[i] = v;
+          g[i] = v >> 8;
+          b[i] = v >> 16;
+        } else {
+          scene_rgb(x + i, y, w, h, &r[i], &g[i], &b[i]);
+        }
+      }
+      uint32_t idx = (y * w + x) * 2; // Byte index
+      if (space == ICAP_COLOR_BAYER) { // BGGR, one byte per pixel
+        for (uint8_t i = 0; i < 2; i++) {
+          p8[idx / 2 + i] = (y & 1) ? (i ? r[i] : g[i]) : (i ? g[i] : b[i]);
+        }
+      } else if (space == ICAP_COLOR_RGB565) {
+        for (uint8_t i = 0; i < 2; i++) {
+          uint16_t rgb = ((r[i] & 0xF8) << 8) | ((g[i] & 0xFC) << 3) |
+                         (b[i] >> 3);
+          p8[idx + i * 2] = rgb >> 8; // Big-endian
+          p8[idx + i * 2 + 1] = rgb;
+        }
+      } else { // YUV422, bytes Y0 U Y1 V (BT.601, full range)
+        int ra = (r[0] + r[1]) / 2, ga = (g[0] + g[1]) / 2,
+            ba = (b[0] + b[1]) / 2;
+        p8[idx] = clamp8((77 * r[0] + 150 * g[0] + 29 * b[0]) >> 8);
+        p8[idx + 1] = clamp8(((-43 * ra - 85 * ga + 128 * ba) >> 8) + 128);
+        p8[idx + 2] = clamp8((77 * r[1] + 150 * g[1] + 29 * b[1]) >> 8);
+        p8[idx + 3] = clamp8(((128 * ra - 107 * ga - 21 * ba) >> 8) + 128);
+      }
+    }
+  }
+}
+
+// KERNELS -----------------------------------------------------------------
+
+typedef struct {
+  const char *name;
+  void (*run)(Adafruit_ImageCapture &img);
+  bool rgb;   // Run on RGB565 images
+  bool yuv;   // Run on YUV images (false where YUV is a no-op)
+  bool bayer; // Run on raw Bayer images (only the demosaic)
+} kernel;
+
+// Y8 view of the first width * height bytes of the (YUV) test image, for
+// timing the Y8 variants without the compaction pass. Content is just the
+// interleaved YUV bytes, which is fine for timing.
+static iCap_view y8(Adafruit_ImageCapture &img) {
+  iCap_view view = {(uint8_t *)img.getBuffer(), img.width(), img.height(),
+                    ICAP_COLOR_Y8};
+  return view;
+}
+
+// RGB565 output of demosaicRGB565(), allocated per size in setup()
+static uint16_t *demosaic_dst = NULL;
+
+// JPEG encoder; output is only counted, as if sent on to SD or I2C
+static Adafruit_iCap_JPEG jpeg;
+static uint32_t jpeg_bytes;
+static uint32_t jpeg_count(void *, const uint8_t *, uint32_t len) {
+  jpeg_bytes += len;
+  return len;
+}
+static void jpeg_encode(const iCap_view &view, uint8_t quality,
+                        iCap_jpeg_sampling sampling) {
+  jpeg_bytes = 0;
+  jpeg.encode(view, jpeg_count, NULL, quality, sampling);
+}
+static iCap_view frame(Adafruit_ImageCapture &img) {
+  iCap_view view = {(uint8_t *)img.getBuffer(), img.width(), img.height(),
+                    img.getColorspace()};
+  return view;
+}
+
+// Lossless codec, output counted like JPEG's. Round trip decodes each row
+// over its source as soon as it's encoded.
+static Adafruit_iCap_QOI qoi, qoi_dec;
+static uint8_t qoi_row[640 * 3]; // maxRowBytes() at the largest size
+static void qoi_encode(Adafruit_ImageCapture &img) {
+  jpeg_bytes = 0;
+  qoi.encode(frame(img), jpeg_count, NULL, qoi_row);
+}
+static void qoi_round_trip(Adafruit_ImageCapture &img) {
+  uint8_t *pixels = (uint8_t *)img.getBuffer();
+  qoi.begin(img.width(), img.height(), img.getColorspace());
+  qoi_dec.begin(img.width(), img.height(), img.getColorspace());
+  for (uint16_t y = 0; y < img.height(); y++, pixels += img.width() * 2) {
+    uint32_t len = qoi.encodeRow(pixels, qoi_row);
+    qoi_dec.decodeRow(qoi_row, len, pixels);
+  }
+}
+
+// Image file writer, output counted like JPEG's
+static Adafruit_iCap_writer writer;
+static void write_file(Adafruit_ImageCapture &img, iCap_file_format format,
+                       iCap_rotation rotation) {
+  jpeg_bytes = 0;
+  writer.write(frame(img), format, jpeg_count, NULL, rotation);
+}
+
+static const kernel kernels[] = {
+    {"negative", [](Adafruit_ImageCapture &img) { img.image_negative(); },
+     true, true, false},
+    {"threshold", [](Adafruit_ImageCapture &img) { img.image_threshold(128); },
+     true, true, false},
+    {"posterize", [](Adafruit_ImageCapture &img) { img.image_posterize(4); },
+     true, true, false},
+    {"mosaic", [](Adafruit_ImageCapture &img) { img.image_mosaic(8, 8); },
+     true, true, false},
+    // Mosaic vs. original tile-at-a-time version, small and large tiles
+    {"mosaic_reference",
+     [](Adafruit_ImageCapture &img) { img.image_mosaic_reference(8, 8); },
+     true, false, false},
+    {"mosaic_2x2", [](Adafruit_ImageCapture &img) { img.image_mosaic(2, 2); },
+     true, true, false},
+    {"mosaic_2x2_reference",
+     [](Adafruit_ImageCapture &img) { img.image_mosaic_reference(2, 2); },
+     true, false, false},
+    {"mosaic_32x32",
+     [](Adafruit_ImageCapture &img) { img.image_mosaic(32, 32); }, true,
+     true, false},
+    {"mosaic_32x32_reference",
+     [](Adafruit_ImageCapture &img) { img.image_mosaic_reference(32, 32); },
+     true, false, false},
+    {"median", [](Adafruit_ImageCapture &img) { img.image_median(); }, true,
+     true, false},
+    {"edges", [](Adafruit_ImageCapture &img) { img.image_edges(7); }, true,
+     true, false},
+    {"Y2RGB565", [](Adafruit_ImageCapture &img) { img.Y2RGB565(); }, false,
+     true, false},
+    {"YUV2RGB565", [](Adafruit_ImageCapture &img) { img.YUV2RGB565(); },
+     false, true, false},
+    // Y8 compaction, and Y8 variants (rows marked YUV, but Y8 data)
+    {"compactY8", [](Adafruit_ImageCapture &img) { img.compactY8(); }, true,
+     true, false},
+    {"y8_threshold",
+     [](Adafruit_ImageCapture &img) { img.image_threshold(y8(img), 128); },
+     false, true, false},
+    {"y8_posterize",
+     [](Adafruit_ImageCapture &img) { img.image_posterize(y8(img), 4); },
+     false, true, false},
+    {"y8_mosaic",
+     [](Adafruit_ImageCapture &img) { img.image_mosaic(y8(img), 8, 8); },
+     false, true, false},
+    {"y8_median",
+     [](Adafruit_ImageCapture &img) { img.image_median(y8(img)); }, false,
+     true, false},
+    {"y8_edges",
+     [](Adafruit_ImageCapture &img) { img.image_edges(y8(img), 7); }, false,
+     true, false},
+    // A typical effect chain, as separate calls and as one image_pipeline()
+    {"chain_separate",
+     [](Adafruit_ImageCapture &img) {
+       img.image_median();
+       img.image_threshold(128);
+       img.image_posterize(4);
+       img.Y2RGB565();
+     },
+     true, true, false},
+    {"chain_pipeline",
+     [](Adafruit_ImageCapture &img) {
+       static const iCap_pipeline_stage stages[] = {{ICAP_OP_MEDIAN, 0},
+                                                    {ICAP_OP_THRESHOLD, 128},
+                                                    {ICAP_OP_POSTERIZE, 4},
+                                                    {ICAP_OP_Y2RGB565, 0}};
+       img.image_pipeline(stages, sizeof stages / sizeof stages[0]);
+     },
+     true, true, false},
+    {"points_separate",
+     [](Adafruit_ImageCapture &img) {
+       img.image_negative();
+       img.image_threshold(128);
+       img.image_posterize(4);
+     },
+     true, true, false},
+    {"points_pipeline",
+     [](Adafruit_ImageCapture &img) {
+       static const iCap_pipeline_stage stages[] = {{ICAP_OP_NEGATIVE, 0},
+                                                    {ICAP_OP_THRESHOLD, 128},
+                                                    {ICAP_OP_POSTERIZE, 4}};
+       img.image_pipeline(stages, sizeof stages / sizeof stages[0]);
+     },
+     true, true, false},
+    // Raw Bayer demosaic, to a separate RGB565 buffer and in-place to Y8
+    {"demosaicRGB565",
+     [](Adafruit_ImageCapture &img) { img.demosaicRGB565(demosaic_dst); },
+     false, false, true},
+    {"demosaicY8", [](Adafruit_ImageCapture &img) { img.demosaicY8(); },
+     false, false, true},
+    // JPEG encoding at the default quality, both subsamplings, and Y8
+    {"jpeg_420",
+     [](Adafruit_ImageCapture &img) {
+       jpeg_encode(frame(img), 75, ICAP_JPEG_420);
+     },
+     true, true, false},
+    {"jpeg_422",
+     [](Adafruit_ImageCapture &img) {
+       jpeg_encode(frame(img), 75, ICAP_JPEG_422);
+     },
+     true, true, false},
+    {"y8_jpeg",
+     [](Adafruit_ImageCapture &img) {
+       jpeg_encode(y8(img), 75, ICAP_JPEG_420);
+     },
+     false, true, false},
+    // Lossless encoding, and encode + decode
+    {"qoi_encode", qoi_encode, true, true, false},
+    {"qoi_round_trip", qoi_round_trip, true, true, false},
+    // Image files: BMP as-is and turned (column-wise reads), PPM
+    {"write_bmp",
+     [](Adafruit_ImageCapture &img) {
+       write_file(img, ICAP_FILE_BMP, ICAP_ROTATE_0);
+     },
+     true, true, false},
+    {"write_bmp_rotate90",
+     [](Adafruit_ImageCapture &img) {
+       write_file(img, ICAP_FILE_BMP, ICAP_ROTATE_90);
+     },
+     true, true, false},
+    {"write_ppm",
+     [](Adafruit_ImageCapture &img) {
+       write_file(img, ICAP_FILE_PPM, ICAP_ROTATE_0);
+     },
+     true, true, false},
+};
+
+static const struct {
+  uint16_t width;
+  uint16_t height;
+} sizes[] = {{640, 480}, {320, 240}, {160, 120}, {80, 60}, {40, 30}};
+
+// BENCHMARK ---------------------------------------------------------------
+
+Adafruit_ImageCapture img(NULL, NULL, 0); // No camera, just the buffer
+
+static void bench(const kernel &k, iCap_colorspace space, bool noise,
+                  uint16_t w, uint16_t h) {
+  uint16_t *buf = img.getBuffer();
+  double total_ns = 0, best_ns = 1e30;
+  uint32_t runs = 0;
+  while ((runs < MIN_RUNS) || ((runs < MAX_RUNS) && (total_ns < TARGET_NS))) {
+    make_image(buf, w, h, space, noise);
+    bench_ticks t0 = timer_read();
+    k.run(img);
+    double ns = ticks_to_ns(timer_read() - t0);
+    total_ns += ns;
+    if (ns < best_ns) {
+      best_ns = ns;
+    }
+    runs++;
+  }
+
+  uint32_t num_pixels = (uint32_t)w * h;
+  double mean_ns = total_ns / runs;
+  Serial.print(k.name);
+  Serial.print((space == ICAP_COLOR_RGB565) ? ",RGB565,"
+               : (space == ICAP_COLOR_YUV)  ? ",YUV,"
+                                            : ",BAYER,");
+  Serial.print(noise ? "noise," : "scene,");
+  Serial.print(w);
+  Serial.print(',');
+  Serial.print(h);
+  Serial.print(',');
+  Serial.print(runs);
+  Serial.print(',');
+  Serial.print(mean_ns / num_pixels, 3);
+  Serial.print(',');
+  Serial.print(best_ns / num_pixels, 3);
+  Serial.print(',');
+  Serial.print(num_pixels * 1000.0 / mean_ns, 3);
+  Serial.print(',');
+#if defined(BENCH_CYCLES)
+  Serial.print(mean_ns * (F_CPU / 1e9) / num_pixels, 2);
+#endif
+  Serial.println();
+}
+
+static double psnr(double sum_sq, uint32_t count) {
+  return sum_sq ? 10.0 * log10(255.0 * 255.0 * count / sum_sq) : INFINITY;
+}
+
+// Demosaic quality: the scene image is sampled to Bayer, demosaiced, and
+// compared against the original full-color scene (regenerated with the same
+// noise) as RGB (565 output expanded to 8 bits/channel) and as luma.
+static void demosaic_quality(uint16_t w, uint16_t h) {
+  uint16_t *buf = img.getBuffer();
+  make_image(buf, w, h, ICAP_COLOR_BAYER, false);
+  img.demosaicRGB565(demosaic_dst);
+  iCap_view view;
+  img.demosaicY8(&view);
+
+  const uint8_t *rgb = (const uint8_t *)demosaic_dst;
+  double rgb_sq = 0, y8_sq = 0;
+  rng_state = 12345;
+  for (uint32_t i = 0; i < (uint32_t)w * h; i++) {
+    uint8_t r, g, b;
+    scene_rgb(i % w, i / w, w, h, &r, &g, &b);
+    uint16_t c = (rgb[i * 2] << 8) | rgb[i * 2 + 1]; // Big-endian
+    int dr = (((c >> 8) & 0xF8) | (c >> 13)) - r;
+    int dg = (((c >> 3) & 0xFC) | ((c >> 9) & 3)) - g;
+    int db = (((c << 3) & 0xF8) | ((c >> 2) & 7)) - b;
+    int dy = view.pixels[i] - ((77 * r + 150 * g + 29 * b) >> 8);
+    rgb_sq += dr * dr + dg * dg + db * db;
+    y8_sq += dy * dy;
+  }
+  Serial.print("# demosaic PSNR ");
+  Serial.print(w);
+  Serial.print('x');
+  Serial.print(h);
+  Serial.print(": RGB565 ");
+  Serial.print(psnr(rgb_sq, (uint32_t)w * h * 3), 2);
+  Serial.print(" dB, Y8 ");
+  Serial.print(psnr(y8_sq, (uint32_t)w * h), 2);
+  Serial.println(" dB");
+}
+
+// JPEG compressed size of the scene image at a few quality settings, 4:2:0
+// and 4:2:2 (or Y8 alone, from a YUV image), with bits/pixel (raw is 16).
+static void jpeg_sizes(iCap_colorspace space, uint16_t w, uint16_t h) {
+  static const uint8_t qualities[] = {50, 75, 90};
+  for (uint8_t s = 0; s < 3; s++) {
+    Serial.print("# jpeg size ");
+    Serial.print(w);
+    Serial.print('x');
+    Serial.print(h);
+    Serial.print((s == 2)                    ? " Y8:"
+                 : (space == ICAP_COLOR_YUV) ? " YUV"
+                                             : " RGB565");
+    Serial.print((s == 2) ? "" : s ? " 4:2:2:" : " 4:2:0:");
+    for (uint8_t q = 0; q < sizeof qualities; q++) {
+      make_image(img.getBuffer(), w, h, space, false);
+      if (s == 2) {
+        iCap_view view = y8(img);
+        for (uint32_t i = 0; i < (uint32_t)w * h; i++) { // Y bytes of YUV
+          view.pixels[i] = view.pixels[i * 2];
+        }
+        jpeg_encode(view, qualities[q], ICAP_JPEG_420);
+      } else {
+        jpeg_encode(frame(img), qualities[q],
+                    s ? ICAP_JPEG_422 : ICAP_JPEG_420);
+      }
+      Serial.print(" q");
+      Serial.print(qualities[q]);
+      Serial.print(' ');
+      Serial.print(jpeg_bytes);
+      Serial.print(" bytes (");
+      Serial.print(jpeg_bytes * 8.0 / ((uint32_t)w * h), 2);
+      Serial.print(" bits/px)");
+    }
+    Serial.println();
+    if ((s == 1) && (space != ICAP_COLOR_YUV)) {
+      break; // Y8 only from YUV
+    }
+  }
+}
+
+// Lossless compressed size of the scene and noise images, with bits/pixel
+// and ratio to raw.
+static void qoi_sizes(iCap_colorspace space, uint16_t w, uint16_t h) {
+  Serial.print("# qoi size ");
+  Serial.print(w);
+  Serial.print('x');
+  Serial.print(h);
+  Serial.print((space == ICAP_COLOR_YUV) ? " YUV:" : " RGB565:");
+  for (uint8_t noise = 0; noise < 2; noise++) {
+    make_image(img.getBuffer(), w, h, space, noise);
+    qoi_encode(img);
+    Serial.print(noise ? " noise " : " scene ");
+    Serial.print(jpeg_bytes);
+    Serial.print(" bytes (");
+    Serial.print(jpeg_bytes * 8.0 / ((uint32_t)w * h), 2);
+    Serial.print(" bits/px, ");
+    Serial.print((uint32_t)w * h * 2.0 / jpeg_bytes, 2);
+    Serial.print(":1)");
+  }
+  Serial.println();
+}
+
+void setup() {
+  Serial.begin(115200);
+#if defined(ARDUINO)
+  while (!Serial)
+    delay(10);
+#endif
+  timer_begin();
+
+  Serial.println("# Adafruit_ImageCapture image_* benchmark");
+  Serial.println("kernel,space,image,width,height,runs,ns_per_px,"
+                 "best_ns_per_px,mpix_per_s,cycles_per_px");
+
+  for (uint8_t s = 0; s < sizeof sizes / sizeof sizes[0]; s++) {
+    uint16_t w = sizes[s].width, h = sizes[s].height;
+    for (uint8_t c = 0; c < 3; c++) {
+      static const iCap_colorspace spaces[] = {
+          ICAP_COLOR_RGB565, ICAP_COLOR_YUV, ICAP_COLOR_BAYER};
+      iCap_colorspace space = spaces[c];
+      if ((img.bufferConfig(w, h, space, 1, ICAP_REALLOC_CHANGE) !=
+           ICAP_STATUS_OK) ||
+          ((space == ICAP_COLOR_BAYER) &&
+           !(demosaic_dst = (uint16_t *)malloc((uint32_t)w * h * 2)))) {
+        Serial.print("# skipped, not enough RAM: ");
+        Serial.print(w);
+        Serial.print('x');
+        Serial.println(h);
+        break;
+      }
+      for (uint8_t k = 0; k < sizeof kernels / sizeof kernels[0]; k++) {
+        bool run = (c == 0)   ? kernels[k].rgb
+                   : (c == 1) ? kernels[k].yuv
+                              : kernels[k].bayer;
+        if (run) {
+          bench(kernels[k], space, true, w, h);
+          bench(kernels[k], space, false, w, h);
+        }
+      }
+      if (space != ICAP_COLOR_BAYER) {
+        jpeg_sizes(space, w, h);
+        qoi_sizes(space, w, h);
+      } else {
+        demosaic_quality(w, h);
+        free(demosaic_dst);
+        demosaic_dst = NULL;
+      }
+    }
+  }
+  Serial.print("# scratch arena high-water: ");
+  Serial.print(img.scratchPeak());
+  Serial.println(" bytes");
+  Serial.println("# done");
+}
+
+void loop() {}
+
+#if !defined(ARDUINO)
+int main(void) {
+  setup();
+  return 0;
+}
+#endif
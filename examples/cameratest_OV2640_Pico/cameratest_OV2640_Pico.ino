@@ -84,6 +84,11 @@ void setup() {
                   cam.readRegister(OV2640_REG1_PIDL);
   Serial.println(mid, HEX);
   Serial.println(pid, HEX);
+
+  // Time spent sending register lists (not counting power-up, reset and
+  // settling waits), to compare I2C settings, e.g. a constructor delay_us.
+  Serial.print("Config time (us): ");
+  Serial.println(cam.configTime());
 }
 
 // MAIN LOOP - RUNS REPEATEDLY UNTIL RESET OR POWER OFF --------------------
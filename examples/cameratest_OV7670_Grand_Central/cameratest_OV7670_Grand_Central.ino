@@ -68,6 +68,11 @@ void setup() {
   uint8_t ver = cam.readRegister(OV7670_REG_VER); // Should be 0x73
   Serial.println(pid, HEX);
   Serial.println(ver, HEX);
+
+  // Time spent sending register lists (not counting power-up, reset and
+  // settling waits), to compare I2C settings, e.g. a constructor delay_us.
+  Serial.print("Config time (us): ");
+  Serial.println(cam.configTime());
 }
 
 // MAIN LOOP - RUNS REPEATEDLY UNTIL RESET OR POWER OFF --------------------
@@ -93,11 +98,20 @@ void loop() {
     cam.frameControl(CAM_SIZE, vstart, hstart, edge_offset, pclk_delay);
   }
 
-  if (++frame >= KEYFRAME) { // Time to sync up a fresh address window?
-    frame = 0;
+  // Wait for the next complete frame and hold it, to avoid tearing. A QVGA
+  // frame only fits in RAM once, so capture pauses while it's held. With
+  // smaller frames, passing nbuf=2 to begin() lets the camera keep loading
+  // the other buffer meanwhile.
 #if defined(USE_SPI_DMA)
-    tft.dmaWait(); // Wait for prior transfer to complete
+  tft.dmaWait(); // Prior frame must finish sending before it's released
 #endif
+  uint16_t *buf = cam.waitFrame(100);
+  if (!buf) {
+    return; // Timeout, no frame
+  }
+
+  if (++frame >= KEYFRAME) { // Time to sync up a fresh address window?
+    frame = 0;
     tft.endWrite();   // Close out prior transfer
     tft.startWrite(); // and start a fresh one (required)
     // Address window centers QVGA image on screen. NO CLIPPING IS
@@ -108,9 +122,6 @@ void loop() {
                       cam.width(), cam.height());
   }
 
-  // Pause the camera DMA - hold buffer steady to avoid tearing
-  cam.suspend();
-
   // Postprocessing effects. These modify a previously-captured
   // image in memory, they are NOT in-camera effects.
   // Most only work in RGB mode (not YUV).
@@ -127,10 +138,6 @@ void loop() {
 
   // Camera data arrives in big-endian order...same as the TFT,
   // so data can just be issued directly, no byte-swap needed.
-#if defined(USE_SPI_DMA)
-  tft.dmaWait(); // Wait for prior transfer to complete
-#endif
-  tft.writePixels(cam.getBuffer(), cam.width() * cam.height(), false, true);
-
-  cam.resume(); // Resume DMA to camera buffer
+  tft.writePixels(buf, cam.width() * cam.height(), false, true);
+  // Frame is released implicitly on the next waitFrame()
 }
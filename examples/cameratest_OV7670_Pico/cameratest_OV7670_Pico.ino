@@ -70,8 +70,9 @@ void setup() {
   tft.println("Howdy");
   tft.setRotation(3);
   // Once started, the camera continually fills a frame buffer
-  // automagically; no need to request a frame.
-  iCap_status status = cam.begin(CAM_SIZE, CAM_MODE, 30.0);
+  // automagically; no need to request a frame. Two buffers are used
+  // here, so one frame can be shown while the next one loads.
+  iCap_status status = cam.begin(CAM_SIZE, CAM_MODE, 30.0, 2);
   if (status != ICAP_STATUS_OK) {
     Serial.println("Camera begin() fail");
     for(;;);
@@ -81,6 +82,11 @@ void setup() {
   uint8_t ver = cam.readRegister(OV7670_REG_VER); // Should be 0x73
   Serial.println(pid, HEX);
   Serial.println(ver, HEX);
+
+  // Time spent sending register lists (not counting power-up, reset and
+  // settling waits), to compare I2C settings, e.g. a constructor delay_us.
+  Serial.print("Config time (us): ");
+  Serial.println(cam.configTime());
 }
 
 // MAIN LOOP - RUNS REPEATEDLY UNTIL RESET OR POWER OFF --------------------
@@ -96,8 +102,6 @@ uint16_t frame = KEYFRAME; // Force 1st frame as keyframe
 
 void loop() {
 
-  gpio_xor_mask(1 << 25); // Toggle LED each frame
-
   // This was for empirically testing window settings in src/arch/ov7670.c.
   // Your code doesn't need this. Just keeping around for future reference.
   if(Serial.available()) {
@@ -110,6 +114,17 @@ void loop() {
                      edge_offset, pclk_delay);
   }
 
+  // Claim the newest complete frame. The camera continues loading into the
+  // other buffer meanwhile, so there's no tearing and no waiting on
+  // suspend(). Returns NULL if no new frame has arrived since the last.
+  tft.dmaWait(); // Prior frame must finish sending before it's released
+  uint16_t *buf = cam.acquireFrame();
+  if (!buf) {
+    return;
+  }
+
+  gpio_xor_mask(1 << 25); // Toggle LED each frame
+
   if (++frame >= KEYFRAME) { // Time to sync up a fresh address window?
     frame = 0;
 
@@ -123,16 +138,12 @@ void loop() {
                       cam.width(), cam.height());
   }
 
-  // Pause the camera DMA - hold buffer steady to avoid tearing
-  //cam.suspend();
-
   if(CAM_MODE == ICAP_COLOR_YUV) {
-    cam.Y2RGB565(); // Convert grayscale for TFT preview
+    cam.Y2RGB565(); // Convert grayscale for TFT preview (acquired frame)
   }
 
-  tft.writePixels(cam.getBuffer(), cam.width() * cam.height(), false, true);
-
-  //cam.resume(); // Resume DMA into camera buffer
+  tft.writePixels(buf, cam.width() * cam.height(), false, true);
+  // Frame is released implicitly on the next acquireFrame()
 }
 #else
 // Empty code to make this pass CI for now
@@ -261,7 +261,7 @@ memcpy(camSettings, (void *)i2cBuf, 3);
         Serial.println("started");
         camState = CAM_REQ_PAUSE;
         capturedImagePtr = (uint8_t *)cam.getBuffer();
-        capturedBytesRemaining = cam.width() * cam.height() * 2;
+        capturedBytesRemaining = cam.frameInfo()->bytes;
         // Tell host how many bytes to expect
         i2cBuf[0] =  capturedBytesRemaining        & 0xFF;
         i2cBuf[1] = (capturedBytesRemaining >>  8) & 0xFF;
@@ -0,0 +1,195 @@
+#if defined(ADAFRUIT_GRAND_CENTRAL_M4)
+/*
+Example for Adafruit_iCap_OV7670 library: record clips to SD card while
+the preview keeps running. Tap "A" button to start recording, again to
+stop. Use card slot on Grand Central, not the TFT shield!
+
+The camera is double-buffered, so each frame is written to the card
+straight from its buffer while the next one loads; there's no pause in
+capture and no change of camera settings. Frames go to a raw container
+(see Adafruit_iCap_recorder.h) in the 'CLIPS' folder, numbered from
+#0001, existing files WILL be overwritten. When a clip ends, the frame
+rate actually sustained and write statistics are printed to Serial.
+
+HARDWARE REQUIRED:
+- Adafruit Grand Central board
+- Adafruit 1.8" TFT shield V2
+- OV7670 camera w/10K pullups to SDA+SCL, 3.3V+GND wires to shield
+- microSD card (in card slot on Grand Central, not shield)
+
+Board/shield is held as in the selfie example; the preview is rotated
+180 degrees to suit, the recording is left as the camera sees it.
+*/
+
+#include <Wire.h>                   // I2C comm to camera
+#include <SD.h>                     // SD card support
+#include "Adafruit_iCap_OV7670.h"   // Camera library
+#include "Adafruit_iCap_recorder.h" // Clip recording
+#include "Adafruit_ST7735.h"        // TFT display library
+#include "Adafruit_seesaw.h"        // For TFT shield
+#include "Adafruit_TFTShield18.h"   // More TFT shield
+
+// SD CARD CONFIG ----------------------------------------------------------
+
+#define SD_CS SDCARD_SS_PIN // Grand Central onboard SD card select
+
+// CAMERA CONFIG -----------------------------------------------------------
+
+iCap_arch arch = {.timer = TCC1, .xclk_pdec = false};
+OV7670_pins pins = {.enable = PIN_PCC_D8, .reset = PIN_PCC_D9,
+                    .xclk = PIN_PCC_XCLK};
+#define CAM_I2C  Wire1 // Second I2C bus next to PCC pins
+#define CAM_SIZE OV7670_SIZE_DIV4  // QQVGA (160x120 pixels)
+#define CAM_MODE ICAP_COLOR_RGB565 // RGB plz
+#define CAM_NBUF 2                 // Double-buffered
+
+// Static buffer with room for both 160x120 frames.
+uint16_t camBuffer[160 * 120 * CAM_NBUF];
+
+Adafruit_iCap_OV7670 cam(pins, &arch, CAM_I2C, camBuffer, sizeof camBuffer);
+
+// SHIELD AND DISPLAY CONFIG -----------------------------------------------
+
+Adafruit_TFTShield18 shield;
+
+#define TFT_CS   10  // Chip select for TFT on shield
+#define TFT_DC    8  // Data/command line for TFT on Shield
+#define TFT_RST  -1  // TFT reset is handled by seesaw
+
+Adafruit_ST7735 tft(TFT_CS, TFT_DC, TFT_RST);
+
+// RECORDER CONFIG ---------------------------------------------------------
+
+#define MAX_FRAMES 1800 // Clip length limit, 21 KB of index RAM
+
+// Recorder, writing the card in 512-byte blocks
+Adafruit_iCap_recorder recorder;
+File clip;
+uint16_t clip_num = 1; // Clip number increments with each file
+
+// The recorder rewrites its file header when done, so needs to seek.
+bool file_seek(void *context, uint32_t position) {
+  return ((File *)context)->seek(position);
+}
+
+// SETUP - RUNS ONCE ON STARTUP --------------------------------------------
+
+void setup() {
+  pinMode(SD_CS, OUTPUT);
+  digitalWrite(SD_CS, HIGH); // Disable SD card select during setup
+  pinMode(4, OUTPUT);
+  digitalWrite(4, HIGH);     // Disable shield SD card select just in case
+
+  Serial.begin(9600);
+  //while (!Serial);
+
+  if (!SD.begin(SD_CS)) {
+    Serial.println("SD begin() fail (continuing without)");
+  }
+  SD.mkdir("/clips");
+
+  if (!shield.begin()) { // Start seesaw helper chip on shield
+    Serial.println("seesaw begin() fail");
+    for(;;);
+  }
+  shield.setBacklight(TFTSHIELD_BACKLIGHT_OFF);
+  shield.tftReset();
+
+  tft.initR(INITR_BLACKTAB);    // Initialize TFT on shield
+  tft.setRotation(3);           // See notes earlier re: orientation
+  tft.fillScreen(ST77XX_BLACK); // Clear background
+
+  iCap_status status = cam.begin(CAM_SIZE, CAM_MODE, 30.0, CAM_NBUF);
+  if (status != ICAP_STATUS_OK) {
+    Serial.println("Camera begin() fail");
+    for(;;);
+  }
+
+  shield.setBacklight(TFTSHIELD_BACKLIGHT_ON);
+}
+
+// MAIN LOOP - RUNS REPEATEDLY UNTIL RESET OR POWER OFF --------------------
+
+void show(uint16_t *pixels) {
+  tft.dmaWait(); // Wait for prior transfer to complete
+  tft.endWrite();
+  tft.startWrite();
+  tft.setAddrWindow((tft.width() - cam.width()) / 2,
+                    (tft.height() - cam.height()) / 2, cam.width(),
+                    cam.height());
+  // Camera data is big-endian, same as the TFT, no byte-swap needed.
+  tft.writePixels(pixels, cam.width() * cam.height(), false, true);
+}
+
+bool button_was_up = true;
+
+void loop() {
+  bool button_up = shield.readButtons() & TFTSHIELD_BUTTON_1;
+  if (!button_up && button_was_up) { // Tapped
+    if (recorder.recording()) {
+      stop_clip();
+    } else {
+      start_clip();
+    }
+  }
+  button_was_up = button_up;
+
+  if (recorder.recording()) {
+    uint32_t frames = recorder.stats().frames;
+    iCap_status status = recorder.update();
+    if ((status != ICAP_STATUS_OK) || recorder.full()) {
+      stop_clip(); // Card trouble, or limit reached
+    } else if (recorder.stats().frames != frames) {
+      // Preview the frame just written. It's been released to DMA, so
+      // the preview (not the file) may tear slightly.
+      show(cam.getBuffer());
+    }
+  } else {
+    uint16_t *frame = cam.acquireFrame();
+    if (frame) {
+      show(frame);
+      tft.dmaWait(); // Hold the frame until the TFT has it
+      cam.releaseFrame();
+    }
+  }
+}
+
+void start_clip() {
+  char filename[50];
+  sprintf(filename, "/clips/clip%04d.icr", clip_num++);
+  SD.remove(filename); // Delete existing file, if any
+  clip = SD.open(filename, FILE_WRITE);
+  if (clip) {
+    if (recorder.begin(&cam, iCap_print_sink, file_seek, &clip,
+                       MAX_FRAMES) == ICAP_STATUS_OK) {
+      Serial.print("Recording ");
+      Serial.println(filename);
+    } else {
+      clip.close();
+    }
+  }
+}
+
+void stop_clip() {
+  iCap_status status = recorder.end();
+  clip.close();
+  iCap_record_stats stats = recorder.stats();
+  Serial.print(status == ICAP_STATUS_OK ? "Saved " : "Write error, ");
+  Serial.print(stats.frames);
+  Serial.print(" frames, ");
+  Serial.print(recorder.fps());
+  Serial.print(" fps, ");
+  Serial.print(stats.skipped);
+  Serial.print(" skipped in ");
+  Serial.print(stats.stalls);
+  Serial.print(" stalls; write avg ");
+  Serial.print(stats.frames ? stats.write_us / stats.frames : 0);
+  Serial.print(" us, max ");
+  Serial.print(stats.write_max_us);
+  Serial.println(" us");
+}
+#else
+// Empty code to make this pass CI for now
+void setup() {}
+void loop() {}
+#endif // ADAFRUIT_GRAND_CENTRAL_M4
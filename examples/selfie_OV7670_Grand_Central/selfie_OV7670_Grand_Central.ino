@@ -26,6 +26,7 @@ and BMP writing 180 degrees.
 #include <Wire.h>                 // I2C comm to camera
 #include <SD.h>                   // SD card support
 #include "Adafruit_iCap_OV7670.h" // Camera library
+#include "Adafruit_iCap_writer.h" // BMP file output
 #include "Adafruit_ST7735.h"      // TFT display library
 #include "Adafruit_seesaw.h"      // For TFT shield
 #include "Adafruit_TFTShield18.h" // More TFT shield
@@ -171,7 +172,7 @@ void loop() {
     tft.setRotation(3); // Go back to 180 degree screen rotation
     frame = 999;        // Force keyframe on next update
     cam.suspend();
-    write_bmp(filename, cam.getBuffer(), cam.width(), cam.height());
+    write_bmp(filename);
     // Restore the original preview size from camera.
     cam.config(CAM_SIZE, CAM_MODE, 30.0);
   }
@@ -179,79 +180,22 @@ void loop() {
   cam.resume(); // Resume DMA into camera buffer
 }
 
-// Write 16-bit value to BMP file in little-endian order
-void writeLE16(File *file, uint16_t value) {
-#if(__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__)
-  file->write((char *)&value, sizeof value);
-#else
-  file->write( value       & 0xFF);
-  file->write((value >> 8) & 0xFF);
-#endif
-}
+// File writer converts rows into a buffer and writes the card in 512-byte
+// blocks rather than a write() call per pixel.
+Adafruit_iCap_writer writer;
 
-// Write 32-bit value to BMP file in little-endian order
-void writeLE32(File *file, uint32_t value) {
-#if(__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__)
-  file->write((char *)&value, sizeof value);
-#else
-  file->write( value        & 0xFF);
-  file->write((value >>  8) & 0xFF);
-  file->write((value >> 16) & 0xFF);
-  file->write((value >> 24) & 0xFF);
-#endif
-}
-
-// Minimalist RGB565 BMP-writing function.
-void write_bmp(char *filename, uint16_t *addr,
-               uint16_t width, uint16_t height) {
+// Save camera image as RGB565 BMP (YUV mode is converted to color).
+void write_bmp(char *filename) {
   SD.remove(filename); // Delete existing file, if any
   File file = SD.open(filename, FILE_WRITE);
   if(file) {
-    // BMP header, 14 bytes:
-    file.write(0x42);                               // Windows BMP signature
-    file.write(0x4D);                               // "
-    writeLE32(&file, 14 + 56 + width * height * 2); // File size in bytes
-    writeLE32(&file, 0);                            // Creator bytes (ignored)
-    writeLE32(&file, 14 + 56);                      // Offset to pixel data
-  
-    // DIB header, 56 bytes "BITMAPV3INFOHEADER" type (for RGB565):
-    writeLE32(&file, 56);                 // Header size in bytes
-    writeLE32(&file, width);              // Width in pixels
-    writeLE32(&file, height);             // Height in pixels (bottom-to-top)
-    writeLE16(&file, 1);                  // Planes = 1
-    writeLE16(&file, 16);                 // Bits = 16
-    writeLE32(&file, 3);                  // Compression = bitfields
-    writeLE32(&file, width * height);     // Bitmap size (adobe adds 2 here also)
-    writeLE32(&file, 2835);               // Horiz resolution (72dpi)
-    writeLE32(&file, 2835);               // Vert resolution (72dpi)
-    writeLE32(&file, 0);                  // Default # colors in palette
-    writeLE32(&file, 0);                  // Default # "important" colors
-    writeLE32(&file, 0b1111100000000000); // Red mask
-    writeLE32(&file, 0b0000011111100000); // Green mask
-    writeLE32(&file, 0b0000000000011111); // Blue mask
-    writeLE32(&file, 0);                  // Alpha mask
-
+    iCap_view view = {(uint8_t *)cam.getBuffer(), cam.width(), cam.height(),
+                      cam.getColorspace()};
     // As mentioned in beginning, the camera is upside-down when board is
-    // held at the intended orientation. BMPs are normally stored bottom-
-    // to-top, so walking through rows incrementally takes care of this
-    // axis, and horizontal axis is manually flipped.
-    for(int y=0; y<height; y++) {
-      uint16_t *row = &addr[y * width];
-      for(int x=width-1;x >= 0; x--) { // Flip X
-        // Raw data from camera is big-endian, BMP needs little-endian
-        uint16_t pixel = __builtin_bswap16(row[x]);
-        file.write((char *)&pixel, 2);
-        // I mean yeah, since we're flipping both the X axis and endian-
-        // swapping, we COULD just write out the individual row bytes in
-        // reverse order. Handling pixels & bytes separately here so
-        // there's no confusion if this code gets used elsewhere and
-        // changed with X in the + direction.
-      }
-      // No scanline pad is added. We know the OV7670 library image sizes
-      // are always an even width (4 bytes). Something to keep in mind if
-      // flexible sizing and/or cropping options are added later.
-    }
-
+    // held at the intended orientation, so the image is rotated 180
+    // degrees on its way to the file.
+    writer.write(view, ICAP_FILE_BMP, iCap_print_sink, &file,
+                 ICAP_ROTATE_180);
     file.close();
   }
 }
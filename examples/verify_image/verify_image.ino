@@ -0,0 +1,2087 @@
+/*
+Bit-exact check of optimized Adafruit_ImageCapture postprocessing
+functions against their reference implementations. No camera needed:
+each pair is run over identical random and flat frames at several sizes,
+and outputs are compared byte-for-byte. The lossless (QOI-style) codec must
+give back its input exactly, and image files (BMP, PPM, PGM, in every
+orientation) must match a pixel-by-pixel reference, and recordings
+(raw or AVI) must parse back to exactly the frames captured. The JPEG
+encoder, being lossy, is instead decoded back and held to a minimum PSNR.
+Prints one PASS/FAIL line per function and size, then a summary. The
+host build also checks frame buffer rotation and handling of frames cut
+short on simulated capture, and camera register list writes against its
+mock I2C bus.
+
+Also builds natively (Linux/macOS) against the simulated host backend,
+from the library folder; exit status is nonzero if anything fails:
+
+  g++ -O2 -pthread -Isrc -Isrc/arch/host -x c++
+      examples/verify_image/verify_image.ino -x none
+      $(find src -name '*.cpp') -o verify_image && ./verify_image
+*/
+
+#include <Adafruit_ImageCapture.h>
+#include <Adafruit_iCap_JPEG.h>
+#include <Adafruit_iCap_QOI.h>
+#include <Adafruit_iCap_parallel.h>
+#include <Adafruit_iCap_recorder.h>
+#include <Adafruit_iCap_writer.h>
+#include <Arduino.h>
+#include <math.h>
+
+// REFERENCE IMPLEMENTATIONS -----------------------------------------------
+
+// Straightforward one-pixel-at-a-time versions of functions that the
+// library implements with packed (SWAR) arithmetic. Image width and
+// height here may be odd and the buffer only 16-bit aligned.
+
+static void threshold_ref(Adafruit_ImageCapture &img, uint8_t threshold) {
+  uint16_t *pixels = img.getBuffer();
+  uint32_t i, num_pixels = img.width() * img.height();
+  if (img.getColorspace() == ICAP_COLOR_RGB565) {
+    uint16_t rlimit = (threshold >> 3) << 11;
+    uint16_t glimit = (threshold >> 2) << 5;
+    uint16_t blimit = (threshold >> 3);
+    for (i = 0; i < num_pixels; i++) {
+      uint16_t in = __builtin_bswap16(pixels[i]), out = 0;
+      if ((in & 0xF800) >= rlimit)
+        out |= 0xF800;
+      if ((in & 0x07E0) >= glimit)
+        out |= 0x07E0;
+      if ((in & 0x001F) >= blimit)
+        out |= 0x001F;
+      pixels[i] = __builtin_bswap16(out);
+    }
+  } else {
+    // Y to black or white; U/V to full color, or neutral if weaker than
+    // threshold / 2 either side of 128
+    uint8_t *p8 = (uint8_t *)pixels;
+    for (i = 0; i < num_pixels * 2; i += 2)
+      p8[i] = (p8[i] >= threshold) ? 255 : 0;
+    for (i = 1; i < num_pixels * 2; i += 2) {
+      int16_t c = p8[i] - 128;
+      p8[i] = (c >= threshold / 2) ? 255 : (c < -(threshold / 2)) ? 0 : 128;
+    }
+  }
+}
+
+static void posterize_ref(Adafruit_ImageCapture &img, uint8_t levels) {
+  uint16_t *pixels = img.getBuffer();
+  uint32_t i, num_pixels = img.width() * img.height();
+  uint8_t lm1 = levels - 1, lm1d2 = lm1 / 2;
+  if (img.getColorspace() == ICAP_COLOR_RGB565) {
+    uint16_t rtable[32], gtable[32], rgb;
+    uint8_t btable[32];
+    for (i = 0; i < 32; i++) {
+      btable[i] = (((i * levels + lm1d2) / 32) * 31 + lm1d2) / lm1;
+      rtable[i] = btable[i] << 11;
+      gtable[i] = (btable[i] << 6) | ((btable[i] & 0x10) << 1);
+    }
+    for (i = 0; i < num_pixels; i++) {
+      rgb = __builtin_bswap16(pixels[i]);
+      rgb = rtable[rgb >> 11] | gtable[(rgb >> 6) & 31] | btable[rgb & 31];
+      pixels[i] = __builtin_bswap16(rgb);
+    }
+  } else {
+    // Y over the full range; U/V magnitude from 128, each side separately
+    // over 0-127 (so 128 stays neutral), sign restored after
+    uint8_t table[256], ctable[128], *p8 = (uint8_t *)pixels;
+    for (i = 0; i < 256; i++)
+      table[i] = (((i * levels + lm1d2) / 256) * 255 + lm1d2) / lm1;
+    for (i = 0; i < 128; i++)
+      ctable[i] = (((i * levels + lm1d2) / 128) * 127 + lm1d2) / lm1;
+    for (i = 0; i < num_pixels * 2; i += 2) {
+      int16_t c = p8[i + 1] - 128;
+      p8[i] = table[p8[i]];
+      uint8_t m = (c >= 0) ? c : (c > -128) ? -c : 127;
+      p8[i + 1] = (c >= 0) ? 128 + ctable[m] : 128 - ctable[m];
+    }
+  }
+}
+
+static void y2rgb565_ref(Adafruit_ImageCapture &img) {
+  uint16_t *pixels = img.getBuffer();
+  uint32_t len = img.width() * img.height();
+  while (len--) {
+    uint8_t y = *pixels & 0xFF;
+    uint16_t rgb = ((y >> 3) * 0x801) | ((y & 0xFC) << 3);
+    *pixels++ = __builtin_bswap16(rgb);
+  }
+}
+
+// Color YUV to RGB565, pixel by pixel: each pixel takes U from the even
+// pixel of its pair and V from the odd one (neutral if there's none).
+static void yuv2rgb565_ref(Adafruit_ImageCapture &img) {
+  uint16_t w = img.width(), h = img.height();
+  uint8_t *p8 = (uint8_t *)img.getBuffer();
+  uint8_t *src = (uint8_t *)malloc(w * h * 2);
+  memcpy(src, p8, w * h * 2);
+  for (uint32_t i = 0; i < (uint32_t)w * h; i++) {
+    uint32_t x = i % w, pair = i - (x & 1);
+    int32_t yy = src[i * 2], u = src[pair * 2 + 1] - 128;
+    int32_t v = ((x | 1) < w) ? src[pair * 2 + 3] - 128 : 0;
+    int32_t rgb[3] = {yy + ((91881 * v + 32768) >> 16),
+                      yy + ((-22554 * u + 32768) >> 16) +
+                          ((-46802 * v + 32768) >> 16),
+                      yy + ((116130 * u + 32768) >> 16)};
+    for (uint8_t c = 0; c < 3; c++)
+      rgb[c] = (rgb[c] < 0) ? 0 : (rgb[c] > 255) ? 255 : rgb[c];
+    uint16_t out = ((rgb[0] >> 3) << 11) | ((rgb[1] >> 2) << 5) | (rgb[2] >> 3);
+    p8[i * 2] = out >> 8;
+    p8[i * 2 + 1] = out;
+  }
+  free(src);
+}
+
+// YUV2RGB565() into a separate buffer (in place if there's no RAM for
+// one), then copied back to the image for comparison.
+static void yuv2rgb565_copy(Adafruit_ImageCapture &img) {
+  uint32_t num_bytes = (uint32_t)img.width() * img.height() * 2;
+  uint16_t *out = (uint16_t *)malloc(num_bytes);
+  img.YUV2RGB565(out);
+  if (out) {
+    memcpy(img.getBuffer(), out, num_bytes);
+    free(out);
+  }
+}
+
+// Negative of any colorspace, byte by byte over the frame
+static void negative_ref(Adafruit_ImageCapture &img) {
+  uint8_t *p8 = (uint8_t *)img.getBuffer();
+  uint32_t len = Adafruit_ImageCapture::frameBytes(img.width(), img.height(),
+                                                   img.getColorspace());
+  while (len--)
+    *p8++ ^= 0xFF;
+}
+
+// YUV 3x3 filters, sample by sample from a copy of the image. Y neighbors
+// are adjacent pixels; U and V neighbors are the nearest samples of the
+// same kind, two pixels apart. Edges clamp to the image (and, for U/V,
+// to the last sample of that kind).
+static void yuv3x3_ref(Adafruit_ImageCapture &img, bool edges,
+                       uint8_t sensitivity) {
+  uint16_t w = img.width(), h = img.height();
+  uint8_t *dst = (uint8_t *)img.getBuffer();
+  uint8_t *src = (uint8_t *)malloc(w * h * 2);
+  memcpy(src, dst, w * h * 2);
+  uint16_t s = sensitivity * 8;
+  if (s > 255)
+    s = 255;
+  for (int32_t y = 0; y < h; y++) {
+    for (int32_t x = 0; x < w; x++) {
+      for (uint8_t chroma = 0; chroma < 2; chroma++) {
+        // Sample column & count in units of this kind of sample
+        int32_t parity = chroma ? (x & 1) : 0, step = chroma ? 2 : 1;
+        int32_t count = chroma ? (w + 1 - parity) / 2 : w, col = x / step;
+        uint8_t list[9], n = 0;
+        for (int32_t dy = -1; dy <= 1; dy++) {
+          int32_t yy = y + dy;
+          yy = (yy < 0) ? 0 : (yy >= h) ? h - 1 : yy;
+          for (int32_t dx = -1; dx <= 1; dx++) {
+            int32_t cc = col + dx;
+            cc = (cc < 0) ? 0 : (cc >= count) ? count - 1 : cc;
+            list[n++] = src[(yy * w + cc * step + parity) * 2 + chroma];
+          }
+        }
+        uint8_t *out = &dst[(y * w + x) * 2 + chroma];
+        if (edges) {
+          int16_t center = list[4];
+          *out = chroma ? 128
+                        : ((abs(center - list[1]) >= s) ||
+                           (abs(center - list[3]) >= s) ||
+                           (abs(center - list[5]) >= s) ||
+                           (abs(center - list[7]) >= s))
+                              ? 255
+                              : 0;
+        } else {
+          for (uint8_t i = 1; i < 9; i++) { // Insertion sort
+            for (uint8_t j = i; j && (list[j - 1] > list[j]); j--) {
+              uint8_t t = list[j];
+              list[j] = list[j - 1];
+              list[j - 1] = t;
+            }
+          }
+          *out = list[4];
+        }
+      }
+    }
+  }
+  free(src);
+}
+
+// YUV mosaic, tile by tile. Tile width is rounded up to even (so even a
+// 1x1 tile averages a U/V pair); Y, U and V are averaged separately over
+// the samples of each kind in the tile.
+static void mosaic_yuv_ref(Adafruit_ImageCapture &img, uint8_t tw,
+                           uint8_t th) {
+  uint16_t w = img.width(), h = img.height(), tile_w = (tw + 1) & ~1;
+  uint8_t *p8 = (uint8_t *)img.getBuffer();
+  if (tile_w < 2)
+    tile_w = 2;
+  if (th < 1)
+    th = 1;
+  for (uint32_t y1 = 0; y1 < h; y1 += th) {
+    for (uint32_t x1 = 0; x1 < w; x1 += tile_w) {
+      uint32_t sum[3] = {0, 0, 0}, count[3] = {0, 0, 0};
+      for (uint32_t y = y1; (y < y1 + th) && (y < h); y++) {
+        for (uint32_t x = x1; (x < x1 + tile_w) && (x < w); x++) {
+          sum[0] += p8[(y * w + x) * 2];
+          count[0]++;
+          sum[1 + (x & 1)] += p8[(y * w + x) * 2 + 1];
+          count[1 + (x & 1)]++;
+        }
+      }
+      for (uint32_t y = y1; (y < y1 + th) && (y < h); y++) {
+        for (uint32_t x = x1; (x < x1 + tile_w) && (x < w); x++) {
+          p8[(y * w + x) * 2] = sum[0] / count[0];
+          p8[(y * w + x) * 2 + 1] = sum[1 + (x & 1)] / count[1 + (x & 1)];
+        }
+      }
+    }
+  }
+}
+
+// Y8 compaction: luma bytes packed at start of buffer, rest unchanged.
+// YUV keeps Y; RGB565 fields are weighted 630/608/240 (8.8 fixed point).
+// Other formats (a Y8 capture, or demosaicY8() output) are left as-is.
+static uint8_t *compact_y8_ref(Adafruit_ImageCapture &img) {
+  uint8_t *p8 = (uint8_t *)img.getBuffer();
+  if (Adafruit_ImageCapture::bitsPerPixel(img.getColorspace()) < 16) {
+    return p8;
+  }
+  for (uint32_t i = 0; i < (uint32_t)img.width() * img.height(); i++) {
+    if (img.getColorspace() == ICAP_COLOR_YUV) {
+      p8[i] = p8[i * 2];
+    } else {
+      uint16_t rgb = (p8[i * 2] << 8) | p8[i * 2 + 1];
+      p8[i] = ((rgb >> 11) * 630 + ((rgb >> 5) & 63) * 608 +
+               (rgb & 31) * 240 + 128) >>
+              8;
+    }
+  }
+  return p8;
+}
+
+// Y8 3x3 median or edges, from a copy, edges clamped to the image
+static void y8_3x3_ref(Adafruit_ImageCapture &img, bool edges,
+                       uint8_t sensitivity) {
+  int32_t w = img.width(), h = img.height();
+  uint8_t *dst = compact_y8_ref(img), *src = (uint8_t *)malloc(w * h);
+  memcpy(src, dst, w * h);
+  int16_t s = (sensitivity * 8 > 255) ? 255 : sensitivity * 8;
+  for (int32_t y = 0; y < h; y++) {
+    for (int32_t x = 0; x < w; x++) {
+      uint8_t list[9], n = 0;
+      for (int32_t dx = -1; dx <= 1; dx++) {
+        for (int32_t dy = -1; dy <= 1; dy++) {
+          int32_t xx = x + dx, yy = y + dy;
+          xx = (xx < 0) ? 0 : (xx >= w) ? w - 1 : xx;
+          yy = (yy < 0) ? 0 : (yy >= h) ? h - 1 : yy;
+          list[n++] = src[yy * w + xx];
+        }
+      }
+      if (edges) {
+        int16_t c = list[4];
+        dst[y * w + x] = ((abs(c - list[1]) >= s) || (abs(c - list[3]) >= s) ||
+                          (abs(c - list[5]) >= s) || (abs(c - list[7]) >= s))
+                             ? 255
+                             : 0;
+      } else {
+        for (uint8_t i = 1; i < 9; i++) { // Insertion sort
+          for (uint8_t j = i; j && (list[j - 1] > list[j]); j--) {
+            uint8_t t = list[j];
+            list[j] = list[j - 1];
+            list[j - 1] = t;
+          }
+        }
+        dst[y * w + x] = list[4];
+      }
+    }
+  }
+  free(src);
+}
+
+// Bilinear BGGR demosaic, pixel by pixel from a copy, edges mirrored.
+// Writes RGB565 to dst565 if non-NULL, else Y8 over the image.
+static void demosaic_ref(Adafruit_ImageCapture &img, uint16_t *dst565) {
+  int32_t w = img.width(), h = img.height();
+  uint8_t *p8 = (uint8_t *)img.getBuffer(), *src = (uint8_t *)malloc(w * h);
+  memcpy(src, p8, w * h);
+  auto at = [&](int32_t x, int32_t y) {
+    x = (x < 0) ? -x : (x >= w) ? 2 * w - 2 - x : x;
+    y = (y < 0) ? -y : (y >= h) ? 2 * h - 2 - y : y;
+    return (int)src[y * w + x];
+  };
+  for (int32_t y = 0; y < h; y++) {
+    for (int32_t x = 0; x < w; x++) {
+      int c = at(x, y), r, g, b;
+      int orth = (at(x - 1, y) + at(x + 1, y) + at(x, y - 1) + at(x, y + 1) +
+                  2) >> 2;
+      int diag = (at(x - 1, y - 1) + at(x + 1, y - 1) + at(x - 1, y + 1) +
+                  at(x + 1, y + 1) + 2) >> 2;
+      int hz = (at(x - 1, y) + at(x + 1, y) + 1) >> 1;
+      int vt = (at(x, y - 1) + at(x, y + 1) + 1) >> 1;
+      if (!(y & 1) && !(x & 1)) { // B
+        r = diag, g = orth, b = c;
+      } else if (!(y & 1)) { // G on B row
+        r = vt, g = c, b = hz;
+      } else if (!(x & 1)) { // G on R row
+        r = hz, g = c, b = vt;
+      } else { // R
+        r = c, g = orth, b = diag;
+      }
+      if (dst565) {
+        uint16_t rgb = ((r & 0xF8) << 8) | ((g & 0xFC) << 3) | (b >> 3);
+        ((uint8_t *)&dst565[y * w + x])[0] = rgb >> 8; // Big-endian
+        ((uint8_t *)&dst565[y * w + x])[1] = rgb;
+      } else {
+        p8[y * w + x] = (r * 77 + g * 150 + b * 29 + 128) >> 8;
+      }
+    }
+  }
+  free(src);
+}
+
+// Y8 mosaic, tile by tile
+static void y8_mosaic_ref(Adafruit_ImageCapture &img, uint8_t tw,
+                          uint8_t th) {
+  uint32_t w = img.width(), h = img.height();
+  uint8_t *p8 = compact_y8_ref(img);
+  for (uint32_t y1 = 0; y1 < h; y1 += th) {
+    for (uint32_t x1 = 0; x1 < w; x1 += tw) {
+      uint32_t sum = 0, count = 0, x, y;
+      for (y = y1; (y < y1 + th) && (y < h); y++) {
+        for (x = x1; (x < x1 + tw) && (x < w); x++, count++)
+          sum += p8[y * w + x];
+      }
+      for (y = y1; (y < y1 + th) && (y < h); y++) {
+        for (x = x1; (x < x1 + tw) && (x < w); x++)
+          p8[y * w + x] = sum / count;
+      }
+    }
+  }
+}
+
+// Y8 point operations, byte by byte. With 'odd' set, only over the span
+// of y8_odd_view(). Posterize uses the same interpolation as for YUV.
+static void y8_point_ref(Adafruit_ImageCapture &img, iCap_op op,
+                         uint8_t param, bool odd = false) {
+  uint32_t i = 0, end = (uint32_t)img.width() * img.height();
+  uint8_t *p8 = compact_y8_ref(img), lm1 = param - 1, lm1d2 = lm1 / 2;
+  if (odd) {
+    i = 1;
+    end = (end - 1 > 65535) ? 65536 : end;
+  }
+  for (; i < end; i++) {
+    if (op == ICAP_OP_NEGATIVE)
+      p8[i] = 255 - p8[i];
+    else if (op == ICAP_OP_THRESHOLD)
+      p8[i] = (p8[i] >= param) ? 255 : 0;
+    else
+      p8[i] = (((p8[i] * param + lm1d2) / 256) * 255 + lm1d2) / lm1;
+  }
+}
+
+// View of a compacted Y8 image, as a single row (of up to 65535 pixels)
+// starting one pixel in, at an odd address, for the unaligned path of
+// point operations.
+static iCap_view y8_odd_view(Adafruit_ImageCapture &img) {
+  iCap_view view = img.compactY8();
+  uint32_t num_pixels = (uint32_t)view.width * view.height - 1;
+  view.pixels++;
+  view.width = (num_pixels > 65535) ? 65535 : num_pixels;
+  view.height = 1;
+  return view;
+}
+
+// Run a pipeline and the same stages as individual calls, for comparison.
+static void pipeline_seq(Adafruit_ImageCapture &img,
+                         const iCap_pipeline_stage *stages, uint8_t n) {
+  for (uint8_t i = 0; i < n; i++) {
+    switch (stages[i].op) {
+    case ICAP_OP_NEGATIVE:
+      img.image_negative();
+      break;
+    case ICAP_OP_THRESHOLD:
+      img.image_threshold(stages[i].param);
+      break;
+    case ICAP_OP_POSTERIZE:
+      img.image_posterize(stages[i].param);
+      break;
+    case ICAP_OP_MEDIAN:
+      img.image_median();
+      break;
+    case ICAP_OP_EDGES:
+      img.image_edges(stages[i].param);
+      break;
+    case ICAP_OP_Y2RGB565:
+      img.Y2RGB565();
+      break;
+    }
+  }
+}
+
+#define PIPELINE_CHECK(name, space, ...)                                       \
+  {name, space,                                                                \
+   [](cam img) {                                                               \
+     static const iCap_pipeline_stage s[] = {__VA_ARGS__};                     \
+     img.image_pipeline(s, sizeof s / sizeof s[0]);                            \
+   },                                                                          \
+   [](cam img) {                                                               \
+     static const iCap_pipeline_stage s[] = {__VA_ARGS__};                     \
+     pipeline_seq(img, s, sizeof s / sizeof s[0]);                             \
+   }}
+
+// JPEG DECODER ------------------------------------------------------------
+
+// Minimal baseline JPEG decoder, just enough to read back what
+// Adafruit_iCap_JPEG writes (8-bit, Huffman, one scan, no restart markers).
+// Output is separate Y, Cb and Cr planes at full resolution, subsampled
+// chroma repeated over its pixels. The IDCT is floating-point so the
+// decoder adds nothing beyond rounding to the encoder's own error.
+
+static const uint8_t jpeg_zigzag[64] = {
+    0,  1,  8,  16, 9,  2,  3,  10, 17, 24, 32, 25, 18, 11, 4,  5,
+    12, 19, 26, 33, 40, 48, 41, 34, 27, 20, 13, 6,  7,  14, 21, 28,
+    35, 42, 49, 56, 57, 50, 43, 36, 29, 22, 15, 23, 30, 37, 44, 51,
+    58, 59, 52, 45, 38, 31, 39, 46, 53, 60, 61, 54, 47, 55, 62, 63};
+
+typedef struct {
+  const uint8_t *data; // Entropy-coded data...
+  uint32_t len;        // ...through end of file
+  uint32_t pos;        // Next byte
+  uint8_t bits;        // Current byte
+  uint8_t num_bits;    // Bits left in current byte
+  bool error;          // Ran off end, or hit a marker
+} jpeg_reader;
+
+typedef struct {
+  uint8_t counts[16];   // Number of codes of each length
+  uint8_t symbols[256]; // Symbols in code order
+} jpeg_table;
+
+static uint8_t jpeg_bit(jpeg_reader &r) {
+  if (!r.num_bits) {
+    if (r.pos >= r.len) {
+      r.error = true;
+      return 0;
+    }
+    r.bits = r.data[r.pos++];
+    if (r.bits == 0xFF) { // Must be stuffed, not a marker
+      if ((r.pos >= r.len) || r.data[r.pos]) {
+        r.error = true;
+        return 0;
+      }
+      r.pos++;
+    }
+    r.num_bits = 8;
+  }
+  return (r.bits >> --r.num_bits) & 1;
+}
+
+// Value of the next n bits, negative if the first is 0
+static int32_t jpeg_value(jpeg_reader &r, uint8_t n) {
+  int32_t v = 0;
+  for (uint8_t i = 0; i < n; i++) {
+    v = (v << 1) | jpeg_bit(r);
+  }
+  return (n && (v < (1 << (n - 1)))) ? v - (1 << n) + 1 : v;
+}
+
+static uint8_t jpeg_symbol(jpeg_reader &r, const jpeg_table &t) {
+  int32_t code = 0, first = 0, index = 0;
+  for (uint8_t len = 0; len < 16; len++) {
+    code |= jpeg_bit(r);
+    if (code - first < t.counts[len]) {
+      return t.symbols[index + code - first];
+    }
+    index += t.counts[len];
+    first = (first + t.counts[len]) << 1;
+    code <<= 1;
+  }
+  r.error = true;
+  return 0;
+}
+
+static void jpeg_idct(const float *in, uint8_t *out) {
+  static float c[8][8]; // [x][u]
+  if (c[0][0] == 0) {
+    for (uint8_t x = 0; x < 8; x++) {
+      for (uint8_t u = 0; u < 8; u++) {
+        c[x][u] = (u ? 0.5 : 0.5 * M_SQRT1_2) *
+                  cos((2 * x + 1) * u * M_PI / 16);
+      }
+    }
+  }
+  float tmp[64];
+  for (uint8_t v = 0; v < 8; v++) {
+    for (uint8_t x = 0; x < 8; x++) {
+      float sum = 0;
+      for (uint8_t u = 0; u < 8; u++) {
+        sum += c[x][u] * in[v * 8 + u];
+      }
+      tmp[v * 8 + x] = sum;
+    }
+  }
+  for (uint8_t y = 0; y < 8; y++) {
+    for (uint8_t x = 0; x < 8; x++) {
+      float sum = 128.5;
+      for (uint8_t v = 0; v < 8; v++) {
+        sum += c[y][v] * tmp[v * 8 + x];
+      }
+      out[y * 8 + x] = (sum < 0) ? 0 : (sum > 255) ? 255 : (uint8_t)sum;
+    }
+  }
+}
+
+// Decode a w x h JPEG to planes[] (1 or 3, each w * h bytes). Returns
+// number of components, or 0 if the file is malformed, a different size,
+// or has anything after its EOI marker.
+static uint8_t jpeg_decode(const uint8_t *data, uint32_t len, uint16_t w,
+                           uint16_t h, uint8_t *planes[3]) {
+  uint8_t quant[4][64], num_comps = 0, hs[3], vs[3], tq[3], td[3], ta[3];
+  static jpeg_table tables[2][4]; // [DC, AC][ID]
+  uint32_t pos = 2;
+  if ((len < 4) || (data[0] != 0xFF) || (data[1] != 0xD8)) {
+    return 0;
+  }
+  for (;;) { // Marker segments up to start of scan
+    if ((pos + 4 > len) || (data[pos] != 0xFF)) {
+      return 0;
+    }
+    uint8_t marker = data[pos + 1];
+    uint32_t end = pos + 2 + ((data[pos + 2] << 8) | data[pos + 3]);
+    const uint8_t *p = &data[pos + 4];
+    if (end > len) {
+      return 0;
+    }
+    if (marker == 0xDB) { // DQT, 8-bit tables in zigzag order
+      for (; p < &data[end]; p += 65) {
+        memcpy(quant[p[0] & 3], p + 1, 64);
+      }
+    } else if (marker == 0xC0) { // SOF0
+      num_comps = p[5];
+      if ((p[0] != 8) || (((p[1] << 8) | p[2]) != h) ||
+          (((p[3] << 8) | p[4]) != w) || !num_comps || (num_comps > 3)) {
+        return 0;
+      }
+      for (uint8_t c = 0; c < num_comps; c++) {
+        hs[c] = p[7 + c * 3] >> 4;
+        vs[c] = p[7 + c * 3] & 15;
+        tq[c] = p[8 + c * 3] & 3;
+      }
+    } else if (marker == 0xC4) { // DHT
+      while (p < &data[end]) {
+        jpeg_table &t = tables[(p[0] >> 4) & 1][p[0] & 3];
+        uint16_t n = 0;
+        for (uint8_t i = 0; i < 16; i++) {
+          n += t.counts[i] = p[1 + i];
+        }
+        memcpy(t.symbols, p + 17, n);
+        p += 17 + n;
+      }
+    } else if (marker == 0xDA) { // SOS, components in frame order
+      if (p[0] != num_comps) {
+        return 0;
+      }
+      for (uint8_t c = 0; c < num_comps; c++) {
+        td[c] = p[2 + c * 2] >> 4;
+        ta[c] = p[2 + c * 2] & 15;
+      }
+      pos = end;
+      break;
+    } else if ((marker < 0xE0) || (marker > 0xEF)) { // Only APPn skipped
+      return 0;
+    }
+    pos = end;
+  }
+
+  uint8_t hmax = 1, vmax = 1;
+  for (uint8_t c = 0; c < num_comps; c++) {
+    hmax = (hs[c] > hmax) ? hs[c] : hmax;
+    vmax = (vs[c] > vmax) ? vs[c] : vmax;
+  }
+  jpeg_reader r = {data, len, pos, 0, 0, false};
+  int32_t dc[3] = {0, 0, 0};
+  for (uint16_t my = 0; my < h; my += vmax * 8) {
+    for (uint16_t mx = 0; mx < w; mx += hmax * 8) {
+      for (uint8_t c = 0; c < num_comps; c++) {
+        uint8_t sx = hmax / hs[c], sy = vmax / vs[c]; // Pixels per sample
+        for (uint8_t bv = 0; bv < vs[c]; bv++) {
+          for (uint8_t bh = 0; bh < hs[c]; bh++) {
+            float coef[64] = {0};
+            dc[c] += jpeg_value(r, jpeg_symbol(r, tables[0][td[c]]));
+            coef[0] = dc[c] * quant[tq[c]][0];
+            for (uint8_t k = 1; k < 64;) {
+              uint8_t s = jpeg_symbol(r, tables[1][ta[c]]);
+              if (!s) {
+                break; // EOB
+              }
+              if (s == 0xF0) { // ZRL, 16 zeros
+                k += 16;
+                continue;
+              }
+              k += s >> 4; // Zero run
+              if (k > 63) {
+                return 0;
+              }
+              coef[jpeg_zigzag[k]] = jpeg_value(r, s & 15) * quant[tq[c]][k];
+              k++;
+            }
+            if (r.error) {
+              return 0;
+            }
+            uint8_t out[64];
+            jpeg_idct(coef, out);
+            for (uint16_t y = 0; y < 8 * sy; y++) {
+              uint16_t py = my + (bv * 8 * sy) + y;
+              for (uint16_t x = 0; (x < 8 * sx) && (py < h); x++) {
+                uint16_t px = mx + (bh * 8 * sx) + x;
+                if (px < w) {
+                  planes[c][py * w + px] = out[(y / sy) * 8 + x / sx];
+                }
+              }
+            }
+          }
+        }
+      }
+    }
+  }
+  // Padding bits end the last byte, then EOI and nothing more
+  return ((r.pos + 2 == len) && (data[r.pos] == 0xFF) &&
+          (data[r.pos + 1] == 0xD9))
+             ? num_comps
+             : 0;
+}
+
+// CHECKS ------------------------------------------------------------------
+
+typedef struct {
+  const char *name;
+  iCap_colorspace space;
+  void (*run)(Adafruit_ImageCapture &img);       // Optimized
+  void (*reference)(Adafruit_ImageCapture &img); // Known-good
+} check;
+
+#define ICAP_RGB ICAP_COLOR_RGB565
+#define ICAP_YUV ICAP_COLOR_YUV
+#define ICAP_Y8 ICAP_COLOR_Y8
+#define ICAP_RGB332 ICAP_COLOR_RGB332
+#define ICAP_RGB444 ICAP_COLOR_RGB444
+#define ICAP_BAYER ICAP_COLOR_BAYER
+#define ICAP_JPEG ICAP_COLOR_JPEG
+typedef Adafruit_ImageCapture &cam;
+
+static const check checks[] = {
+    {"median", ICAP_RGB, [](cam img) { img.image_median(); },
+     [](cam img) { img.image_median_reference(); }},
+    {"median_yuv", ICAP_YUV, [](cam img) { img.image_median(); },
+     [](cam img) { yuv3x3_ref(img, false, 0); }},
+    {"edges_yuv_2", ICAP_YUV, [](cam img) { img.image_edges(2); },
+     [](cam img) { yuv3x3_ref(img, true, 2); }},
+    {"edges_yuv_40", ICAP_YUV, [](cam img) { img.image_edges(40); },
+     [](cam img) { yuv3x3_ref(img, true, 40); }},
+    {"mosaic_8x8", ICAP_RGB, [](cam img) { img.image_mosaic(8, 8); },
+     [](cam img) { img.image_mosaic_reference(8, 8); }},
+    {"mosaic_2x2", ICAP_RGB, [](cam img) { img.image_mosaic(2, 2); },
+     [](cam img) { img.image_mosaic_reference(2, 2); }},
+    {"mosaic_1x7", ICAP_RGB, [](cam img) { img.image_mosaic(1, 7); },
+     [](cam img) { img.image_mosaic_reference(1, 7); }},
+    {"mosaic_3x1", ICAP_RGB, [](cam img) { img.image_mosaic(3, 1); },
+     [](cam img) { img.image_mosaic_reference(3, 1); }},
+    {"mosaic_255", ICAP_RGB, [](cam img) { img.image_mosaic(255, 255); },
+     [](cam img) { img.image_mosaic_reference(255, 255); }},
+    {"mosaic_yuv_8x8", ICAP_YUV, [](cam img) { img.image_mosaic(8, 8); },
+     [](cam img) { mosaic_yuv_ref(img, 8, 8); }},
+    {"mosaic_yuv_3x5", ICAP_YUV, [](cam img) { img.image_mosaic(3, 5); },
+     [](cam img) { mosaic_yuv_ref(img, 3, 5); }},
+    {"mosaic_yuv_1x1", ICAP_YUV, [](cam img) { img.image_mosaic(1, 1); },
+     [](cam img) { mosaic_yuv_ref(img, 1, 1); }},
+    {"mosaic_yuv_1x4", ICAP_YUV, [](cam img) { img.image_mosaic(1, 4); },
+     [](cam img) { mosaic_yuv_ref(img, 1, 4); }},
+    {"mosaic_yuv_255", ICAP_YUV, [](cam img) { img.image_mosaic(255, 255); },
+     [](cam img) { mosaic_yuv_ref(img, 255, 255); }},
+    {"negative", ICAP_RGB, [](cam img) { img.image_negative(); },
+     [](cam img) { negative_ref(img); }},
+    {"threshold_rgb_0", ICAP_RGB, [](cam img) { img.image_threshold(0); },
+     [](cam img) { threshold_ref(img, 0); }},
+    {"threshold_rgb_100", ICAP_RGB, [](cam img) { img.image_threshold(100); },
+     [](cam img) { threshold_ref(img, 100); }},
+    {"threshold_rgb_255", ICAP_RGB, [](cam img) { img.image_threshold(255); },
+     [](cam img) { threshold_ref(img, 255); }},
+    {"threshold_yuv_0", ICAP_YUV, [](cam img) { img.image_threshold(0); },
+     [](cam img) { threshold_ref(img, 0); }},
+    {"threshold_yuv_100", ICAP_YUV, [](cam img) { img.image_threshold(100); },
+     [](cam img) { threshold_ref(img, 100); }},
+    {"threshold_yuv_200", ICAP_YUV, [](cam img) { img.image_threshold(200); },
+     [](cam img) { threshold_ref(img, 200); }},
+    {"posterize_rgb_2", ICAP_RGB, [](cam img) { img.image_posterize(2); },
+     [](cam img) { posterize_ref(img, 2); }},
+    {"posterize_rgb_5", ICAP_RGB, [](cam img) { img.image_posterize(5); },
+     [](cam img) { posterize_ref(img, 5); }},
+    {"posterize_yuv_3", ICAP_YUV, [](cam img) { img.image_posterize(3); },
+     [](cam img) { posterize_ref(img, 3); }},
+    {"posterize_yuv_16", ICAP_YUV, [](cam img) { img.image_posterize(16); },
+     [](cam img) { posterize_ref(img, 16); }},
+    {"Y2RGB565", ICAP_YUV, [](cam img) { img.Y2RGB565(); },
+     [](cam img) { y2rgb565_ref(img); }},
+    {"YUV2RGB565", ICAP_YUV, [](cam img) { img.YUV2RGB565(); },
+     [](cam img) { yuv2rgb565_ref(img); }},
+    {"YUV2RGB565_copy", ICAP_YUV, [](cam img) { yuv2rgb565_copy(img); },
+     [](cam img) { yuv2rgb565_ref(img); }},
+    {"YUV2RGB565_rgb", ICAP_RGB,
+     [](cam img) { // Refused, image unchanged
+       if (img.YUV2RGB565() != ICAP_STATUS_ERR_PERIPHERAL) {
+         img.image_negative();
+       }
+     },
+     [](cam) {}},
+    {"y8_compact_rgb", ICAP_RGB, [](cam img) { img.compactY8(); },
+     [](cam img) { compact_y8_ref(img); }},
+    {"y8_compact_yuv", ICAP_YUV, [](cam img) { img.compactY8(); },
+     [](cam img) { compact_y8_ref(img); }},
+    {"y8_negative", ICAP_YUV,
+     [](cam img) { img.image_negative(img.compactY8()); },
+     [](cam img) { y8_point_ref(img, ICAP_OP_NEGATIVE, 0); }},
+    {"y8_negative_odd", ICAP_YUV,
+     [](cam img) { img.image_negative(y8_odd_view(img)); },
+     [](cam img) { y8_point_ref(img, ICAP_OP_NEGATIVE, 0, true); }},
+    {"y8_threshold_100", ICAP_RGB,
+     [](cam img) { img.image_threshold(img.compactY8(), 100); },
+     [](cam img) { y8_point_ref(img, ICAP_OP_THRESHOLD, 100); }},
+    {"y8_threshold_odd", ICAP_YUV,
+     [](cam img) { img.image_threshold(y8_odd_view(img), 60); },
+     [](cam img) { y8_point_ref(img, ICAP_OP_THRESHOLD, 60, true); }},
+    {"y8_posterize_5", ICAP_YUV,
+     [](cam img) { img.image_posterize(img.compactY8(), 5); },
+     [](cam img) { y8_point_ref(img, ICAP_OP_POSTERIZE, 5); }},
+    {"y8_mosaic_3x5", ICAP_YUV,
+     [](cam img) { img.image_mosaic(img.compactY8(), 3, 5); },
+     [](cam img) { y8_mosaic_ref(img, 3, 5); }},
+    {"y8_median", ICAP_RGB, [](cam img) { img.image_median(img.compactY8()); },
+     [](cam img) { y8_3x3_ref(img, false, 0); }},
+    {"y8_edges_2", ICAP_YUV,
+     [](cam img) { img.image_edges(img.compactY8(), 2); },
+     [](cam img) { y8_3x3_ref(img, true, 2); }},
+    {"y8_capture_negative", ICAP_Y8, [](cam img) { img.image_negative(); },
+     [](cam img) { y8_point_ref(img, ICAP_OP_NEGATIVE, 0); }},
+    {"y8_capture_threshold", ICAP_Y8,
+     [](cam img) { img.image_threshold(100); },
+     [](cam img) { y8_point_ref(img, ICAP_OP_THRESHOLD, 100); }},
+    {"y8_capture_posterize", ICAP_Y8, [](cam img) { img.image_posterize(5); },
+     [](cam img) { y8_point_ref(img, ICAP_OP_POSTERIZE, 5); }},
+    {"y8_capture_mosaic", ICAP_Y8, [](cam img) { img.image_mosaic(3, 5); },
+     [](cam img) { y8_mosaic_ref(img, 3, 5); }},
+    {"y8_capture_median", ICAP_Y8, [](cam img) { img.image_median(); },
+     [](cam img) { y8_3x3_ref(img, false, 0); }},
+    {"y8_capture_edges", ICAP_Y8, [](cam img) { img.image_edges(2); },
+     [](cam img) { y8_3x3_ref(img, true, 2); }},
+    {"y8_capture_YUV2RGB565", ICAP_Y8,
+     [](cam img) { // In place refused, image unchanged
+       if (img.YUV2RGB565() != ICAP_STATUS_ERR_PERIPHERAL) {
+         img.image_negative();
+       }
+     },
+     [](cam) {}},
+    {"negative_rgb332", ICAP_RGB332, [](cam img) { img.image_negative(); },
+     [](cam img) { negative_ref(img); }},
+    {"negative_rgb444", ICAP_RGB444, [](cam img) { img.image_negative(); },
+     [](cam img) { negative_ref(img); }},
+    {"negative_bayer", ICAP_BAYER, [](cam img) { img.image_negative(); },
+     [](cam img) { negative_ref(img); }},
+    // Functions without support for a format must leave it untouched
+    {"unsupported_rgb332", ICAP_RGB332,
+     [](cam img) {
+       img.image_threshold(100);
+       img.image_median();
+       img.Y2RGB565();
+     },
+     [](cam) {}},
+    {"unsupported_rgb444", ICAP_RGB444,
+     [](cam img) {
+       img.image_posterize(3);
+       img.image_mosaic(4, 4);
+       img.compactY8();
+     },
+     [](cam) {}},
+    {"unsupported_bayer", ICAP_BAYER,
+     [](cam img) {
+       img.image_edges(4);
+       img.YUV2RGB565();
+       img.image_median(img.compactY8());
+     },
+     [](cam) {}},
+    {"unsupported_jpeg", ICAP_JPEG,
+     [](cam img) {
+       static const iCap_pipeline_stage stages[] = {{ICAP_OP_MEDIAN, 0},
+                                                    {ICAP_OP_NEGATIVE, 0}};
+       img.image_negative();
+       img.image_threshold(100);
+       img.image_mosaic(4, 4);
+       img.image_edges(4);
+       img.YUV2RGB565();
+       img.image_pipeline(stages, sizeof stages / sizeof stages[0]);
+       img.image_median(img.compactY8());
+       img.demosaicY8();
+     },
+     [](cam) {}},
+    {"demosaic_y8", ICAP_BAYER, [](cam img) { img.demosaicY8(); },
+     [](cam img) { demosaic_ref(img, NULL); }},
+    {"demosaic_y8_median", ICAP_BAYER,
+     [](cam img) {
+       iCap_view view;
+       img.demosaicY8(&view);
+       img.image_median(view);
+     },
+     [](cam img) {
+       demosaic_ref(img, NULL);
+       y8_3x3_ref(img, false, 0);
+     }},
+    PIPELINE_CHECK("pipeline_median", ICAP_RGB, {ICAP_OP_MEDIAN, 0}),
+    PIPELINE_CHECK("pipeline_edges", ICAP_RGB, {ICAP_OP_EDGES, 5}),
+    PIPELINE_CHECK("pipeline_point_rgb", ICAP_RGB, {ICAP_OP_THRESHOLD, 100},
+                   {ICAP_OP_POSTERIZE, 3}, {ICAP_OP_NEGATIVE, 0}),
+    PIPELINE_CHECK("pipeline_3x3_rgb", ICAP_RGB, {ICAP_OP_MEDIAN, 0},
+                   {ICAP_OP_NEGATIVE, 0}, {ICAP_OP_EDGES, 7}),
+    PIPELINE_CHECK("pipeline_mixed_rgb", ICAP_RGB, {ICAP_OP_POSTERIZE, 4},
+                   {ICAP_OP_MEDIAN, 0}, {ICAP_OP_MEDIAN, 0},
+                   {ICAP_OP_Y2RGB565, 0}, {ICAP_OP_THRESHOLD, 90}),
+    PIPELINE_CHECK("pipeline_yuv", ICAP_YUV, {ICAP_OP_NEGATIVE, 0},
+                   {ICAP_OP_POSTERIZE, 6}, {ICAP_OP_MEDIAN, 0},
+                   {ICAP_OP_Y2RGB565, 0}, {ICAP_OP_EDGES, 4}),
+};
+
+static const struct {
+  uint16_t width;
+  uint16_t height;
+} sizes[] = {{320, 240}, {160, 120}, {80, 60}, {40, 30}, {5, 3}, {2, 2}};
+
+#define NUM_SEEDS 4 // Random frames per size (plus flat black & white)
+
+// Checks run on two image objects: one with a library-allocated (aligned)
+// buffer, the other a static buffer deliberately offset by one pixel, to
+// exercise the unaligned paths. The latter is limited to 160x120.
+Adafruit_ImageCapture img_aligned(NULL, NULL, 0);
+static uint16_t static_buf[160 * 120 + 4];
+Adafruit_ImageCapture img_unaligned(NULL, &static_buf[1],
+                                    sizeof static_buf - 2);
+
+// Small LCG so frames are identical on every platform
+static uint32_t rng_state;
+static inline uint32_t rng(void) {
+  rng_state = rng_state * 1664525 + 1013904223;
+  return rng_state >> 8;
+}
+
+// Seeds 0 and 1 are flat black and white, others random.
+static void make_frame(uint8_t *dst, uint32_t num_bytes, uint32_t seed) {
+  rng_state = seed;
+  for (uint32_t i = 0; i < num_bytes; i++) {
+    dst[i] = (seed < 2) ? -seed : rng();
+  }
+}
+
+// Run one check at one size on one image object. Returns 1 if passed,
+// 0 if failed, -1 if skipped (not enough RAM).
+static int run_check(const check &c, Adafruit_ImageCapture &img, uint16_t w,
+                     uint16_t h) {
+  uint32_t num_bytes = Adafruit_ImageCapture::frameBytes(w, h, c.space);
+  uint8_t *expected;
+  if ((img.bufferConfig(w, h, c.space) != ICAP_STATUS_OK) ||
+      !(expected = (uint8_t *)malloc(num_bytes))) {
+    return -1;
+  }
+  uint8_t *buf = (uint8_t *)img.getBuffer();
+  bool ok = true;
+  for (uint32_t seed = 0; ok && (seed < NUM_SEEDS + 2); seed++) {
+    make_frame(buf, num_bytes, seed);
+    c.reference(img);
+    memcpy(expected, buf, num_bytes);
+    make_frame(buf, num_bytes, seed);
+    c.run(img);
+    ok = !memcmp(expected, buf, num_bytes);
+  }
+  free(expected);
+  return ok;
+}
+
+// Scratch arena: a static arena of exactly scratchPeak() bytes must suffice
+// for the same filters, while one byte less must fail cleanly, leaving the
+// image untouched. Returns 1 if passed, 0 if failed, -1 if skipped.
+static int check_scratch(Adafruit_ImageCapture &img, uint16_t w, uint16_t h) {
+  static const iCap_pipeline_stage stages[] = {
+      {ICAP_OP_MEDIAN, 0}, {ICAP_OP_NEGATIVE, 0}, {ICAP_OP_EDGES, 7}};
+  uint32_t num_bytes = (uint32_t)w * h * 2;
+  uint8_t *expected, *arena;
+  if (img.bufferConfig(w, h, ICAP_RGB) != ICAP_STATUS_OK) {
+    return -1;
+  }
+  uint8_t *buf = (uint8_t *)img.getBuffer();
+  img.scratchConfig(0); // Library-allocated, on demand
+  img.image_median();
+  img.image_edges();
+  img.image_pipeline(stages, sizeof stages / sizeof stages[0]);
+  uint32_t peak = img.scratchPeak();
+  if (!(expected = (uint8_t *)malloc(num_bytes))) {
+    return -1;
+  }
+  if (!(arena = (uint8_t *)malloc(peak))) {
+    free(expected);
+    return -1;
+  }
+  // One byte short: pipeline must fail with the image unchanged
+  img.scratchConfig(peak - 1, arena);
+  make_frame(buf, num_bytes, 2);
+  bool ok = (img.image_pipeline(stages, sizeof stages / sizeof stages[0]) ==
+             ICAP_STATUS_ERR_MALLOC);
+  make_frame(expected, num_bytes, 2);
+  ok = ok && !memcmp(expected, buf, num_bytes);
+
+  // Exact size: pipeline (and median) must work, same result as before
+  img.scratchConfig(0);
+  make_frame(buf, num_bytes, 2);
+  img.image_pipeline(stages, sizeof stages / sizeof stages[0]);
+  memcpy(expected, buf, num_bytes);
+  img.scratchConfig(peak, arena);
+  make_frame(buf, num_bytes, 2);
+  ok = ok &&
+       (img.image_pipeline(stages, sizeof stages / sizeof stages[0]) ==
+        ICAP_STATUS_OK) &&
+       !memcmp(expected, buf, num_bytes) &&
+       (img.image_median() == ICAP_STATUS_OK) && (img.scratchPeak() <= peak);
+  img.scratchConfig(0);
+  free(arena);
+  free(expected);
+  return ok;
+}
+
+// Bayer to RGB565 can't be done in place, so it's compared here directly
+// rather than through run_check(): every size, both image objects, the
+// usual seeds. Bayer image must also be left intact. Returns 1 if passed,
+// 0 if failed, -1 if skipped.
+static int check_demosaic(Adafruit_ImageCapture &img, uint16_t w,
+                          uint16_t h) {
+  uint32_t num_bytes = (uint32_t)w * h;
+  if (img.bufferConfig(w, h, ICAP_BAYER) != ICAP_STATUS_OK) {
+    return -1;
+  }
+  uint16_t *out = (uint16_t *)malloc(num_bytes * 2);
+  uint16_t *expected = (uint16_t *)malloc(num_bytes * 2);
+  uint8_t *bayer = (uint8_t *)malloc(num_bytes);
+  bool ok = out && expected && bayer;
+  uint8_t *buf = (uint8_t *)img.getBuffer();
+  for (uint32_t seed = 0; ok && (seed < NUM_SEEDS + 2); seed++) {
+    make_frame(buf, num_bytes, seed);
+    memcpy(bayer, buf, num_bytes);
+    demosaic_ref(img, expected);
+    ok = (img.demosaicRGB565(out) == ICAP_STATUS_OK) &&
+         !memcmp(expected, out, num_bytes * 2) &&
+         !memcmp(bayer, buf, num_bytes);
+  }
+  free(bayer);
+  free(expected);
+  free(out);
+  return (out && expected && bayer) ? ok : -1;
+}
+
+// Variable-length (JPEG) frames as the arch code would deliver them:
+// frameStart(), the camera's bytes, then frameEnd() with the count received
+// (or 0, unknown). Only a whole SOI...EOI image may be published, with its
+// length in frameInfo()->bytes; padding and stale data after the EOI, or
+// 0xFF bytes within the data, mustn't confuse it. A frame missing its EOI
+// is one that overflowed, so its count is always known. Returns 1 if
+// passed, 0 if failed, -1 if skipped.
+static int check_jpeg_frames(Adafruit_ImageCapture &img) {
+  if (img.bufferConfig(80, 60, ICAP_JPEG, 2) != ICAP_STATUS_OK) {
+    return -1;
+  }
+  uint32_t max = Adafruit_ImageCapture::frameBytes(80, 60, ICAP_JPEG);
+  img.resetFrameStats();
+  bool ok = true;
+  for (uint8_t t = 0; t < 6; t++) {
+    uint32_t len = 100 + t * 300; // Image length (SOI to EOI)
+    bool whole = (t < 4), known = (t & 1) || (t == 4);
+    uint8_t *buf = (uint8_t *)img.frameStart(micros());
+    for (uint32_t i = 0; i < max; i++) { // Stale data, older EOIs
+      buf[i] = (i % 97 == 1) ? 0xD9 : (i % 97) ? i : 0xFF;
+    }
+    buf[0] = 0xFF; // SOI
+    buf[1] = (t == 5) ? 0x00 : 0xD8;
+    for (uint32_t i = 2; i < len - 2; i++) { // Stuffed 0xFF data
+      buf[i] = (i & 1) ? i : (i & 2) ? 0xFF : 0;
+    }
+    if (whole) {
+      buf[len - 2] = 0xFF; // EOI
+      buf[len - 1] = 0xD9;
+    }
+    img.frameEnd(known ? len + t * 2 : 0); // Some padding if known
+    uint16_t *frame = img.acquireFrame();
+    ok = ok && (whole ? (frame && (img.frameInfo()->bytes == len)) : !frame);
+    img.releaseFrame();
+  }
+  iCap_frame_stats stats = img.frameStats();
+  return ok && (stats.captured == 4) && (stats.dropped == 2);
+}
+
+// Encoder sink into RAM. Every call but the last must pass a full
+// ICAP_JPEG_OUTBUF bytes (for sector-sized SD writes); 'limit' makes it
+// fail partway, accepting only that much in total.
+typedef struct {
+  uint8_t *data;   // Compressed image...
+  uint32_t len;    // ...and its length so far
+  uint32_t limit;  // Bytes accepted before failing
+  bool short_call; // Last call was less than ICAP_JPEG_OUTBUF
+  bool bad;        // Short call wasn't the last
+} jpeg_sink;
+
+static uint32_t jpeg_sink_write(void *context, const uint8_t *data,
+                                uint32_t len) {
+  jpeg_sink *sink = (jpeg_sink *)context;
+  sink->bad |= sink->short_call;
+  sink->short_call = (len != ICAP_JPEG_OUTBUF);
+  if (sink->len + len > sink->limit) {
+    len = sink->limit - sink->len;
+  }
+  memcpy(sink->data + sink->len, data, len);
+  sink->len += len;
+  return len;
+}
+
+// Smooth test picture for the JPEG checks (random frames say little about
+// compression quality): color ramps of a few levels per pixel, whatever
+// the image size, and light noise, in the image's own format. YUV takes U
+// and V from the pixel where each lands.
+static void make_picture(Adafruit_ImageCapture &img) {
+  auto tri = [](uint32_t v) { // Triangle wave, 0-170
+    return (int)((v & 256) ? 255 - (v & 255) : v & 255) * 2 / 3;
+  };
+  uint16_t w = img.width(), h = img.height();
+  uint8_t *p8 = (uint8_t *)img.getBuffer();
+  rng_state = 1;
+  for (uint32_t y = 0; y < h; y++) {
+    for (uint32_t x = 0; x < w; x++) {
+      int n = (int)(rng() & 7) - 4;
+      int r = 40 + tri(x * 3) + n, g = 40 + tri(y * 3) + n;
+      int b = 40 + tri(x + y * 2) + n;
+      uint32_t i = y * w + x;
+      uint8_t luma = (77 * r + 150 * g + 29 * b + 128) >> 8;
+      if (img.getColorspace() == ICAP_RGB) {
+        uint16_t rgb = ((r & 0xF8) << 8) | ((g & 0xFC) << 3) | (b >> 3);
+        p8[i * 2] = rgb >> 8; // Big-endian
+        p8[i * 2 + 1] = rgb;
+      } else if (img.getColorspace() == ICAP_YUV) {
+        p8[i * 2] = luma;
+        p8[i * 2 + 1] = (x & 1) ? ((128 * r - 107 * g - 21 * b) >> 8) + 128
+                                : ((-43 * r - 85 * g + 128 * b) >> 8) + 128;
+      } else {
+        p8[i] = luma;
+      }
+    }
+  }
+}
+
+static Adafruit_iCap_JPEG jpeg; // Several K, kept off the stack
+
+// JPEG encoder, decoded back: a smooth picture at quality 90 must come
+// back with at least 38 dB PSNR against what went in, for Y and (color)
+// for Cb and Cr against the source's own chroma. It's fed band by band with
+// writeBand(), the sink must see whole chunks, and a sink failing partway
+// through an encode() must be reported with nothing sent after. Returns 1
+// if passed, 0 if failed, -1 if skipped.
+static int check_jpeg_encode(Adafruit_ImageCapture &img, uint16_t w,
+                             uint16_t h, iCap_colorspace space,
+                             iCap_jpeg_sampling sampling) {
+  if (img.bufferConfig(w, h, space) != ICAP_STATUS_OK) {
+    return -1;
+  }
+  uint32_t num_pixels = (uint32_t)w * h, max = num_pixels * 3 + 1024;
+  jpeg_sink sink = {(uint8_t *)malloc(max), 0, max, false, false};
+  uint8_t *planes[3] = {(uint8_t *)malloc(num_pixels),
+                        (uint8_t *)malloc(num_pixels),
+                        (uint8_t *)malloc(num_pixels)};
+  bool ok = sink.data && planes[0] && planes[1] && planes[2];
+  if (ok) {
+    make_picture(img);
+    const uint8_t *src = (const uint8_t *)img.getBuffer();
+    uint32_t stride = w * ((space == ICAP_Y8) ? 1 : 2);
+    ok = jpeg.begin(w, h, space, jpeg_sink_write, &sink, 90, sampling) ==
+         ICAP_STATUS_OK;
+    for (uint16_t y = 0; ok && (y < h); y += jpeg.bandRows()) {
+      ok = jpeg.writeBand(src + y * stride) == ICAP_STATUS_OK;
+    }
+    uint8_t num_comps = (space == ICAP_Y8) ? 1 : 3;
+    ok = ok && (jpeg.bytesWritten() == sink.len) && !sink.bad &&
+         (jpeg_decode(sink.data, sink.len, w, h, planes) == num_comps);
+
+    double y_sq = 0, c_sq = 0;
+    for (uint32_t i = 0; ok && (i < num_pixels); i++) {
+      double ry, rcb = 128, rcr = 128; // Reference Y, Cb, Cr
+      if (space == ICAP_RGB) {
+        uint16_t c = (src[i * 2] << 8) | src[i * 2 + 1];
+        double r = ((c >> 8) & 0xF8) | (c >> 13);
+        double g = ((c >> 3) & 0xFC) | ((c >> 9) & 3);
+        double b = ((c << 3) & 0xF8) | ((c >> 2) & 7);
+        ry = 0.299 * r + 0.587 * g + 0.114 * b;
+        rcb = 128 - 0.168736 * r - 0.331264 * g + 0.5 * b;
+        rcr = 128 + 0.5 * r - 0.418688 * g - 0.081312 * b;
+      } else if (space == ICAP_YUV) {
+        uint32_t pair = i - ((i % w) & 1);
+        ry = src[i * 2];
+        rcb = src[pair * 2 + 1];
+        rcr = ((i % w) | 1) < w ? src[pair * 2 + 3] : 128;
+      } else {
+        ry = src[i];
+      }
+      double dy = planes[0][i] - ry;
+      y_sq += dy * dy;
+      if (num_comps == 3) {
+        double dcb = planes[1][i] - rcb, dcr = planes[2][i] - rcr;
+        c_sq += dcb * dcb + dcr * dcr;
+      }
+    }
+    double y_psnr = 10 * log10(65025.0 * num_pixels / (y_sq + 1e-9));
+    double c_psnr = 10 * log10(65025.0 * num_pixels * 2 / (c_sq + 1e-9));
+    ok = ok && (y_psnr >= 38) && (c_psnr >= 38);
+
+    uint32_t len = sink.len;
+    sink.len = 0;
+    sink.limit = len / 2;
+    iCap_view view = {(uint8_t *)src, w, h, space};
+    ok = ok &&
+         (jpeg.encode(view, jpeg_sink_write, &sink, 90, sampling) ==
+          ICAP_STATUS_ERR_WRITE) &&
+         (sink.len == len / 2) &&
+         (jpeg.writeBand(src) == ICAP_STATUS_ERR_WRITE);
+  }
+  free(planes[2]);
+  free(planes[1]);
+  free(planes[0]);
+  free(sink.data);
+  return (sink.data && planes[0] && planes[1] && planes[2]) ? ok : -1;
+}
+
+static Adafruit_iCap_QOI qoi, qoi_dec; // Encoder and separate decoder
+
+// Lossless codec: a frame encoded row by row, no row over maxRowBytes(),
+// must come back bit for bit when decoded row by row by another object
+// set up from the header -- for flat, random and picture frames. A stream
+// cut short must fail to decode, and encode() must send the sink the same
+// stream, stopping when the sink fails. Returns 1 if passed, 0 if failed,
+// -1 if skipped.
+static int check_qoi(Adafruit_ImageCapture &img, uint16_t w, uint16_t h,
+                     iCap_colorspace space) {
+  if (img.bufferConfig(w, h, space) != ICAP_STATUS_OK) {
+    return -1;
+  }
+  uint32_t num_bytes = (uint32_t)w * h * 2, stride = w * 2;
+  uint32_t row_max = Adafruit_iCap_QOI::maxRowBytes(w);
+  uint32_t max = ICAP_QOI_HEADER + row_max * h;
+  uint8_t *stream = (uint8_t *)malloc(max);
+  uint8_t *decoded = (uint8_t *)malloc(num_bytes);
+  uint8_t *row_buf = (uint8_t *)malloc(row_max);
+  jpeg_sink sink = {(uint8_t *)malloc(max), 0, max, false, false};
+  bool ok = stream && decoded && row_buf && sink.data;
+  uint8_t *buf = (uint8_t *)img.getBuffer();
+  ok = ok && (qoi.begin(w, h, ICAP_Y8) == ICAP_STATUS_ERR_PERIPHERAL);
+  for (uint32_t seed = 0; ok && (seed < NUM_SEEDS + 3); seed++) {
+    if (seed < NUM_SEEDS + 2) {
+      make_frame(buf, num_bytes, seed);
+    } else {
+      make_picture(img);
+    }
+    ok = qoi.begin(w, h, space) == ICAP_STATUS_OK;
+    uint32_t len = qoi.writeHeader(stream);
+    for (uint16_t y = 0; ok && (y < h); y++) {
+      uint32_t n = qoi.encodeRow(buf + y * stride, stream + len);
+      ok = n && (n <= row_max);
+      len += n;
+    }
+    ok = ok && (qoi.bytesWritten() == len) &&
+         (qoi_dec.readHeader(stream) == ICAP_STATUS_OK) &&
+         (qoi_dec.width() == w) && (qoi_dec.height() == h) &&
+         (qoi_dec.getColorspace() == space);
+    uint32_t pos = ICAP_QOI_HEADER;
+    for (uint16_t y = 0; ok && (y < h); y++) {
+      uint32_t n = qoi_dec.decodeRow(stream + pos, len - pos,
+                                     decoded + y * stride);
+      ok = n;
+      pos += n;
+    }
+    ok = ok && (pos == len) && !memcmp(decoded, buf, num_bytes);
+
+    qoi_dec.readHeader(stream);
+    pos = ICAP_QOI_HEADER;
+    for (uint16_t y = 0; ok && (y < h - 1); y++) {
+      pos += qoi_dec.decodeRow(stream + pos, len - pos, decoded);
+    }
+    ok = ok && !qoi_dec.decodeRow(stream + pos, len - pos - 1, decoded);
+
+    iCap_view view = {buf, w, h, space};
+    sink.len = 0;
+    sink.limit = max;
+    ok = ok &&
+         (qoi.encode(view, jpeg_sink_write, &sink, row_buf) ==
+          ICAP_STATUS_OK) &&
+         (sink.len == len) && !memcmp(sink.data, stream, len);
+    sink.len = 0;
+    sink.limit = len / 2;
+    ok = ok &&
+         (qoi.encode(view, jpeg_sink_write, &sink, row_buf) ==
+          ICAP_STATUS_ERR_WRITE) &&
+         (sink.len == len / 2);
+  }
+  bool alloc = stream && decoded && row_buf && sink.data;
+  free(sink.data);
+  free(row_buf);
+  free(decoded);
+  free(stream);
+  return alloc ? ok : -1;
+}
+
+// Little-endian field for reference BMP headers
+static uint8_t *put_le(uint8_t *dst, uint32_t value, uint8_t size) {
+  while (size--) {
+    *dst++ = value;
+    value >>= 8;
+  }
+  return dst;
+}
+
+// Reference image file, built whole in RAM. Each file pixel is found in
+// the source by undoing the mirror, then the rotation (clockwise), and
+// converted on its own. Returns file size.
+static uint32_t file_ref(const iCap_view &v, iCap_file_format format,
+                         iCap_rotation rotation, bool mirror, uint8_t *dst) {
+  uint16_t w = v.width, h = v.height;
+  uint16_t fw = (rotation & 1) ? h : w, fh = (rotation & 1) ? w : h;
+  uint8_t *start = dst, bytes = (format == ICAP_FILE_PPM)   ? 3
+                               : (format == ICAP_FILE_PGM) ? 1
+                               : (v.space == ICAP_Y8)      ? 1
+                                                           : 2;
+  uint32_t row = fw * bytes, pad = 0;
+  if (format == ICAP_FILE_BMP) {
+    pad = (4 - row % 4) % 4;
+    uint32_t offset = (bytes == 1) ? 14 + 40 + 1024 : 14 + 56;
+    uint32_t fields[] = {offset + (row + pad) * fh, 0, offset,
+                         (bytes == 1) ? 40u : 56u, fw, fh};
+    *dst++ = 'B';
+    *dst++ = 'M';
+    for (uint8_t i = 0; i < 6; i++) {
+      dst = put_le(dst, fields[i], 4);
+    }
+    dst = put_le(dst, 1, 2);
+    dst = put_le(dst, bytes * 8, 2);
+    uint32_t more[] = {(bytes == 1) ? 0u : 3u, (row + pad) * fh, 2835, 2835,
+                       (bytes == 1) ? 256u : 0u, 0};
+    for (uint8_t i = 0; i < 6; i++) {
+      dst = put_le(dst, more[i], 4);
+    }
+    if (bytes == 1) {
+      for (uint16_t i = 0; i < 256; i++) {
+        dst = put_le(dst, i * 0x010101, 4);
+      }
+    } else {
+      uint32_t masks[] = {0xF800, 0x07E0, 0x001F, 0};
+      for (uint8_t i = 0; i < 4; i++) {
+        dst = put_le(dst, masks[i], 4);
+      }
+    }
+  } else {
+    dst += sprintf((char *)dst, "P%c\n%u %u\n255\n",
+                   (format == ICAP_FILE_PPM) ? '6' : '5', fw, fh);
+  }
+  for (uint16_t r = 0; r < fh; r++) {
+    uint16_t fy = (format == ICAP_FILE_BMP) ? fh - 1 - r : r; // Bottom-up
+    for (uint16_t fx = 0; fx < fw; fx++) {
+      uint16_t mx = mirror ? fw - 1 - fx : fx, sx, sy;
+      switch (rotation) {
+      case ICAP_ROTATE_90: // Source's left column is the file's top row
+        sx = fy;
+        sy = h - 1 - mx;
+        break;
+      case ICAP_ROTATE_180:
+        sx = w - 1 - mx;
+        sy = h - 1 - fy;
+        break;
+      case ICAP_ROTATE_270: // Source's right column is the file's top row
+        sx = w - 1 - fy;
+        sy = mx;
+        break;
+      default:
+        sx = mx;
+        sy = fy;
+        break;
+      }
+      uint32_t i = sy * w + sx;
+      int32_t rgb[3], gray;
+      if (v.space == ICAP_RGB) {
+        uint16_t c = (v.pixels[i * 2] << 8) | v.pixels[i * 2 + 1];
+        rgb[0] = ((c >> 8) & 0xF8) | (c >> 13);
+        rgb[1] = ((c >> 3) & 0xFC) | ((c >> 9) & 3);
+        rgb[2] = ((c << 3) & 0xF8) | ((c >> 2) & 7);
+        gray = ((c >> 11) * 630 + ((c >> 5) & 63) * 608 + (c & 31) * 240 +
+                128) >>
+               8;
+      } else if (v.space == ICAP_YUV) {
+        uint32_t pair = i - (sx & 1);
+        int32_t u = v.pixels[pair * 2 + 1] - 128;
+        int32_t vv = ((sx | 1) < w) ? v.pixels[pair * 2 + 3] - 128 : 0;
+        gray = v.pixels[i * 2];
+        rgb[0] = gray + ((91881 * vv + 32768) >> 16);
+        rgb[1] = gray + ((-22554 * u + 32768) >> 16) +
+                 ((-46802 * vv + 32768) >> 16);
+        rgb[2] = gray + ((116130 * u + 32768) >> 16);
+        for (uint8_t c = 0; c < 3; c++)
+          rgb[c] = (rgb[c] < 0) ? 0 : (rgb[c] > 255) ? 255 : rgb[c];
+      } else {
+        gray = rgb[0] = rgb[1] = rgb[2] = v.pixels[i];
+      }
+      if (bytes == 3) {
+        for (uint8_t c = 0; c < 3; c++)
+          *dst++ = rgb[c];
+      } else if (bytes == 1) {
+        *dst++ = gray;
+      } else {
+        uint16_t c = (v.space == ICAP_RGB)
+                         ? (v.pixels[i * 2] << 8) | v.pixels[i * 2 + 1]
+                         : ((rgb[0] >> 3) << 11) | ((rgb[1] >> 2) << 5) |
+                               (rgb[2] >> 3);
+        dst = put_le(dst, c, 2);
+      }
+    }
+    for (uint32_t p = 0; p < pad; p++) {
+      *dst++ = 0;
+    }
+  }
+  return dst - start;
+}
+
+// Image file writer sink: every call but the last must be a full
+// ICAP_WRITER_OUTBUF block. On the host, data goes to a real file through
+// iCap_host_file_sink() and is read back after; on a device, into RAM.
+typedef struct {
+  uint8_t *data;   // File contents...
+  uint32_t len;    // ...and length
+  bool short_call; // Last call was less than ICAP_WRITER_OUTBUF
+  bool bad;        // Short call wasn't the last
+#if !defined(ARDUINO)
+  FILE *file;
+#endif
+} file_sink;
+
+static uint32_t file_sink_write(void *context, const uint8_t *data,
+                                uint32_t len) {
+  file_sink *sink = (file_sink *)context;
+  sink->bad |= sink->short_call;
+  sink->short_call = (len != ICAP_WRITER_OUTBUF);
+#if defined(ARDUINO)
+  memcpy(sink->data + sink->len, data, len);
+#else
+  len = iCap_host_file_sink(sink->file, data, len);
+#endif
+  sink->len += len;
+  return len;
+}
+
+static Adafruit_iCap_writer writer;
+
+// Image file writer, every rotation with and without mirroring, must
+// produce exactly the reference file, in full blocks, over flat and random
+// frames; a sink failing partway must be reported with nothing sent after.
+// Returns 1 if passed, 0 if failed, -1 if skipped.
+static int check_writer(Adafruit_ImageCapture &img, uint16_t w, uint16_t h,
+                        iCap_colorspace space, iCap_file_format format) {
+  if (img.bufferConfig(w, h, space) != ICAP_STATUS_OK) {
+    return -1;
+  }
+  uint32_t max = 14 + 40 + 1024 + (w * 3 + 3) * (h + 3);
+  uint8_t *expected = (uint8_t *)malloc(max);
+  file_sink sink = {};
+  sink.data = (uint8_t *)malloc(max);
+  jpeg_sink fail = {(uint8_t *)malloc(max), 0, 0, false, false};
+  bool ok = expected && sink.data && fail.data;
+  uint32_t num_bytes = Adafruit_ImageCapture::frameBytes(w, h, space);
+  iCap_view view = {(uint8_t *)img.getBuffer(), w, h, space};
+  for (uint32_t seed = 0; ok && (seed < NUM_SEEDS + 2); seed++) {
+    make_frame(view.pixels, num_bytes, seed);
+    for (uint8_t o = 0; ok && (o < 8); o++) {
+      iCap_rotation rotation = (iCap_rotation)(o / 2);
+      uint32_t len = file_ref(view, format, rotation, o & 1, expected);
+      sink.len = 0;
+      sink.short_call = sink.bad = false;
+#if !defined(ARDUINO)
+      ok = (sink.file = tmpfile());
+#endif
+      ok = ok &&
+           (writer.write(view, format, file_sink_write, &sink, rotation,
+                         o & 1) == ICAP_STATUS_OK) &&
+           (writer.bytesWritten() == len) && (sink.len == len) && !sink.bad;
+#if !defined(ARDUINO)
+      if (sink.file) {
+        rewind(sink.file);
+        ok = ok && (fread(sink.data, 1, max, sink.file) == len);
+        fclose(sink.file);
+      }
+#endif
+      ok = ok && !memcmp(sink.data, expected, len);
+
+      fail.len = 0;
+      fail.limit = len / 2;
+      ok = ok &&
+           (writer.write(view, format, jpeg_sink_write, &fail, rotation,
+                         o & 1) == ICAP_STATUS_ERR_WRITE) &&
+           (fail.len == len / 2) && !memcmp(fail.data, expected, len / 2);
+    }
+  }
+  bool alloc = expected && sink.data && fail.data;
+  free(fail.data);
+  free(sink.data);
+  free(expected);
+  return alloc ? ok : -1;
+}
+
+// Recorder sink: a host file standing in for the SD card, or RAM on a
+// device. Each write of a frame (from the camera buffer) 'takes' long
+// enough for 'overlap' more frames to arrive, delivered from within the
+// call as DMA would; 'limit' makes it fail partway.
+typedef struct {
+  Adafruit_ImageCapture *img; // Camera being recorded
+  uint8_t *data;              // File contents (host: once read back)
+  uint32_t pos;               // Write position...
+  uint32_t len;               // ...and file length
+  uint32_t limit;             // Bytes accepted before failing
+  uint8_t overlap;            // Frames arriving during each frame write
+#if !defined(ARDUINO)
+  FILE *file;
+#endif
+} record_sink;
+
+#define RECORD_FRAMES 6      // Frames per recording
+#define RECORD_PERIOD 33333  // Simulated frame period (us)
+static uint32_t record_time; // Simulated VSYNC timestamp
+
+// Contents of the simulated frame captured at time t, seeded by t. JPEG is
+// SOI, marker-free data and EOI, its length (odd or even) varying with t.
+// Returns frame length.
+static uint32_t record_fill(uint8_t *buf, uint32_t t, iCap_colorspace space,
+                            uint32_t max) {
+  if (space != ICAP_JPEG) {
+    make_frame(buf, max, t);
+    return max;
+  }
+  uint32_t len = 100 + t % (max / 2);
+  make_frame(buf, len, t);
+  for (uint32_t i = 2; i < len - 2; i++) {
+    buf[i] &= 0x7F;
+  }
+  buf[0] = buf[len - 2] = 0xFF;
+  buf[1] = 0xD8;       // SOI
+  buf[len - 1] = 0xD9; // EOI
+  return len;
+}
+
+// One frame from the simulated camera, as the arch code would deliver it
+static void record_frame(Adafruit_ImageCapture &img) {
+  record_time += RECORD_PERIOD;
+  uint8_t *buf = (uint8_t *)img.frameStart(record_time);
+  if (buf) {
+    iCap_colorspace space = img.getColorspace();
+    uint32_t len = record_fill(
+        buf, record_time, space,
+        Adafruit_ImageCapture::frameBytes(img.width(), img.height(), space));
+    if (space == ICAP_JPEG) {
+      img.frameEnd(len);
+    } else {
+      img.frameDone(img.width() * img.height());
+    }
+  }
+}
+
+static uint32_t record_sink_write(void *context, const uint8_t *data,
+                                  uint32_t len) {
+  record_sink *sink = (record_sink *)context;
+  if (data == (const uint8_t *)sink->img->getBuffer()) { // Held frame
+    for (uint8_t i = 0; i < sink->overlap; i++) {
+      record_frame(*sink->img);
+    }
+  }
+  if (sink->pos + len > sink->limit) {
+    len = (sink->pos < sink->limit) ? sink->limit - sink->pos : 0;
+  }
+#if defined(ARDUINO)
+  memcpy(sink->data + sink->pos, data, len);
+#else
+  len = iCap_host_file_sink(sink->file, data, len);
+#endif
+  sink->pos += len;
+  if (sink->pos > sink->len) {
+    sink->len = sink->pos;
+  }
+  return len;
+}
+
+static bool record_sink_seek(void *context, uint32_t position) {
+  record_sink *sink = (record_sink *)context;
+  sink->pos = position;
+#if defined(ARDUINO)
+  return position <= sink->len;
+#else
+  return iCap_host_file_seek(sink->file, position);
+#endif
+}
+
+// Little-endian field from a recorded file
+static uint32_t get_le(const uint8_t *src, uint8_t size) {
+  uint32_t value = 0;
+  while (size--) {
+    value = (value << 8) | src[size];
+  }
+  return value;
+}
+
+static Adafruit_iCap_recorder recorder;
+static iCap_record_entry record_index[RECORD_FRAMES]; // Static index test
+
+// Recorder, double-buffered, with 0 to 2 frames arriving during each
+// frame write. The file is parsed back (raw container, or AVI for JPEG):
+// header totals, index and frame data must all match the frames expected
+// -- every one with overlap 0 or 1, every other one with 2 (the camera
+// recycles the unclaimed frame), which stats() must count as gaps. The
+// frame waiting before begin() mustn't be recorded, nor one past the
+// limit (left waiting, full() then true). With overlap 0, a sink failing
+// partway must be reported by update() and end(), with nothing written
+// after the failure. Returns 1 if passed, 0 if failed, -1 if skipped.
+static int check_recorder(Adafruit_ImageCapture &img, uint16_t w, uint16_t h,
+                          iCap_colorspace space, uint8_t overlap) {
+  if (img.bufferConfig(w, h, space, 2) != ICAP_STATUS_OK) {
+    return -1;
+  }
+  bool avi = (space == ICAP_JPEG);
+  uint32_t max = Adafruit_ImageCapture::frameBytes(w, h, space);
+  uint32_t file_max = ICAP_RECORDER_AVI_HEADER + RECORD_FRAMES * 16 +
+                      RECORD_FRAMES * (max + ICAP_RECORDER_ALIGN + 16);
+  record_sink sink = {};
+  sink.img = &img;
+  sink.data = (uint8_t *)malloc(file_max);
+  sink.limit = file_max;
+  sink.overlap = overlap;
+  uint8_t *expected = (uint8_t *)malloc(max);
+  bool ok = sink.data && expected;
+#if !defined(ARDUINO)
+  ok = ok && (sink.file = tmpfile());
+#endif
+
+  record_time = 1000000;
+  record_frame(img); // Predates recording
+  uint32_t t0 = record_time + RECORD_PERIOD;
+  ok = ok && (recorder.begin(&img, record_sink_write, record_sink_seek,
+                             &sink, RECORD_FRAMES,
+                             avi ? record_index : NULL) == ICAP_STATUS_OK);
+  for (uint8_t i = 0; ok && (i < RECORD_FRAMES); i++) {
+    if (!img.pollFrame()) {
+      record_frame(img);
+    }
+    ok = (recorder.update() == ICAP_STATUS_OK);
+  }
+  if (!img.pollFrame()) {
+    record_frame(img);
+  }
+  ok = ok && recorder.full() && (recorder.update() == ICAP_STATUS_OK) &&
+       img.pollFrame() && (recorder.end() == ICAP_STATUS_OK) &&
+       !recorder.recording() && !recorder.full();
+#if !defined(ARDUINO)
+  if (sink.file) {
+    rewind(sink.file);
+    ok = ok && (fread(sink.data, 1, file_max, sink.file) == sink.len);
+  }
+#endif
+
+  iCap_record_stats stats = recorder.stats();
+  uint32_t step = (overlap > 1) ? RECORD_PERIOD * 2 : RECORD_PERIOD;
+  uint32_t gaps = (overlap > 1) ? RECORD_FRAMES - 1 : 0;
+  ok = ok && (stats.frames == RECORD_FRAMES) && (stats.skipped == gaps) &&
+       (stats.stalls == gaps) &&
+       (stats.elapsed_us == step * (RECORD_FRAMES - 1)) &&
+       (stats.write_max_us <= stats.write_us) &&
+       (recorder.bytesWritten() == sink.len) && (sink.pos == sink.len);
+
+  // Header, and where the index is
+  const uint8_t *d = sink.data, *entry = NULL;
+  if (ok && avi) {
+    uint32_t movi_end = 220 + get_le(&d[216], 4);
+    entry = &d[movi_end + 8];
+    ok = !memcmp(d, "RIFF", 4) && (get_le(&d[4], 4) == sink.len - 8) &&
+         !memcmp(&d[8], "AVI ", 4) && (get_le(&d[32], 4) == step) &&
+         (get_le(&d[48], 4) == RECORD_FRAMES) && (get_le(&d[64], 4) == w) &&
+         (get_le(&d[68], 4) == h) && !memcmp(&d[112], "MJPG", 4) &&
+         (get_le(&d[128], 4) == step) &&
+         (get_le(&d[140], 4) == RECORD_FRAMES) && !memcmp(&d[220], "movi", 4) &&
+         !memcmp(&d[movi_end], "idx1", 4) &&
+         (get_le(&d[movi_end + 4], 4) == RECORD_FRAMES * 16) &&
+         (movi_end + 8 + RECORD_FRAMES * 16 == sink.len);
+  } else if (ok) {
+    entry = &d[get_le(&d[16], 4)];
+    ok = !memcmp(d, "iCR1", 4) && (get_le(&d[4], 2) == w) &&
+         (get_le(&d[6], 2) == h) && (get_le(&d[8], 4) == space) &&
+         (get_le(&d[12], 4) == RECORD_FRAMES) &&
+         (get_le(&d[16], 4) + RECORD_FRAMES * 12 == sink.len);
+  }
+  // Each frame: aligned, and as captured
+  for (uint8_t i = 0; ok && (i < RECORD_FRAMES); i++) {
+    uint32_t len = record_fill(expected, t0 + step * i, space, max);
+    uint32_t offset;
+    if (avi) {
+      offset = 220 + get_le(&entry[8], 4) + 8;
+      ok = !memcmp(entry, "00dc", 4) && (get_le(&entry[4], 4) == 0x10) &&
+           (get_le(&entry[12], 4) == len) &&
+           !memcmp(&d[offset - 8], "00dc", 4) &&
+           (get_le(&d[offset - 4], 4) == len);
+      entry += 16;
+    } else {
+      offset = get_le(entry, 4);
+      ok = (get_le(&entry[4], 4) == len) &&
+           (get_le(&entry[8], 4) == step * i);
+      entry += 12;
+    }
+    ok = ok && !(offset % ICAP_RECORDER_ALIGN) &&
+         !memcmp(&d[offset], expected, len);
+  }
+
+  if (ok && !overlap) { // Sink failing partway
+    sink.limit = sink.len / 2;
+    sink.pos = sink.len = 0;
+#if !defined(ARDUINO)
+    rewind(sink.file);
+#endif
+    bool failed = false;
+    ok = (recorder.begin(&img, record_sink_write, record_sink_seek, &sink,
+                         RECORD_FRAMES) == ICAP_STATUS_OK);
+    for (uint8_t i = 0; ok && (i < RECORD_FRAMES); i++) {
+      record_frame(img);
+      iCap_status status = recorder.update();
+      failed |= (status == ICAP_STATUS_ERR_WRITE);
+      ok = (status == ICAP_STATUS_OK) || failed;
+    }
+    ok = ok && failed && (recorder.end() == ICAP_STATUS_ERR_WRITE) &&
+         (sink.len == sink.limit);
+  }
+
+#if !defined(ARDUINO)
+  if (sink.file) {
+    fclose(sink.file);
+  }
+#endif
+  bool alloc = sink.data && expected;
+  free(expected);
+  free(sink.data);
+  return alloc ? ok : -1;
+}
+
+#if !defined(ARDUINO)
+// Buffer rotation, driven through the host backend's simulated VSYNC/DMA
+// one frame at a time (ICAP_HOST_MANUAL, iCap_host_frame()). The frame
+// source logs each DMA destination, and fills frame f with pixel values
+// f * 251 + i, so a buffer mixing two frames (tearing) is detectable.
+#define RING_W 16     // Frame width...
+#define RING_H 8      // ...and height for these checks
+#define RING_LOG 32   // Most frames logged per check
+static uint16_t *ring_dest[RING_LOG]; // DMA destination of each frame
+static uint8_t ring_frames;           // Frames logged
+static uint16_t *ring_held;           // Buffer held by application
+static bool ring_bad;                 // DMA wrote to the held buffer
+
+static void ring_source(uint16_t *dest, uint32_t num_pixels, uint32_t frame) {
+  ring_bad |= (dest == ring_held);
+  if (ring_frames < RING_LOG) {
+    ring_dest[ring_frames++] = dest;
+  }
+  for (uint32_t i = 0; i < num_pixels; i++) {
+    dest[i] = frame * 251 + i;
+  }
+}
+
+// Frame number a buffer holds, or -1 if it's not one whole frame
+static int ring_frame(const uint16_t *buf) {
+  int frame = buf[0] / 251;
+  for (uint32_t i = 0; i < RING_W * RING_H; i++) {
+    if (buf[i] != (uint16_t)(frame * 251 + i)) {
+      return -1;
+    }
+  }
+  return frame;
+}
+
+// DMA destinations logged from 'first' on must cycle with this period
+// through that many different buffers, none of them 'held'.
+static bool ring_cycles(uint8_t first, uint8_t period, uint16_t *held) {
+  for (uint8_t i = first; i < ring_frames; i++) {
+    if (ring_dest[i] == held) {
+      return false;
+    }
+    for (uint8_t j = first; j < i; j++) {
+      if ((ring_dest[j] == ring_dest[i]) != !((i - j) % period)) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+static iCap_arch ring_arch = {ICAP_HOST_MANUAL, NULL, ring_source};
+
+// Bare parallel camera, its capture started as a camera subclass would
+// (without the I2C configuration) on the simulated frames above.
+class ring_camera : public Adafruit_iCap_parallel {
+public:
+  ring_camera(iCap_parallel_pins *pins)
+      : Adafruit_iCap_parallel(pins, &ring_arch, NULL, 0, &Wire, 0x21,
+                               100000, 0) {}
+  iCap_status start(iCap_colorspace space, uint8_t nbuf) {
+    iCap_status status = begin();
+    if (status == ICAP_STATUS_OK) {
+      status = bufferConfig(RING_W, RING_H, space, nbuf);
+    }
+    if (status == ICAP_STATUS_OK) {
+      status = dma_change(pixbuf[0], _width * _height);
+    }
+    if (status == ICAP_STATUS_OK) {
+      resume();
+    }
+    ring_frames = 0;
+    ring_held = NULL;
+    ring_bad = false;
+    return status;
+  }
+};
+
+static iCap_parallel_pins ring_pins = { // Nothing connected
+    -1, -1, -1, -1, -1, -1, {-1, -1, -1, -1, -1, -1, -1, -1}, -1, -1};
+static ring_camera ring_cam(&ring_pins);
+
+// With nothing held, DMA must cycle through all nbuf buffers in turn, and
+// the newest frame (only) be acquired, whole; unclaimed older frames are
+// recycled. While a frame is held, DMA must never write to it, and it
+// must stay intact: capture cycles through the other buffers (recycling
+// the one unclaimed frame if double-buffered), or if single-buffered,
+// frames are skipped and counted as dropped. Returns 1 if passed, 0 if
+// failed, -1 if skipped.
+static int check_frame_ring(uint8_t nbuf) {
+  if (ring_cam.start(ICAP_RGB, nbuf) != ICAP_STATUS_OK) {
+    return -1;
+  }
+  ring_cam.resetFrameStats();
+  uint8_t n = nbuf * 2; // Frames per phase
+  for (uint8_t i = 0; i < n; i++) {
+    iCap_host_frame();
+  }
+  uint16_t *frame = ring_cam.acquireFrame();
+  bool ok = (ring_frames == n) && ring_cycles(0, nbuf, NULL) &&
+            (frame == ring_dest[n - 1]) && (ring_frame(frame) == n - 1) &&
+            !ring_cam.pollFrame();
+  uint32_t sequence = ring_cam.frameInfo()->sequence; // VSYNC count
+
+  ring_held = frame; // Held from here on
+  for (uint8_t i = 0; i < n; i++) {
+    iCap_host_frame();
+  }
+  ok = ok && !ring_bad && (ring_frame(frame) == n - 1) &&
+       (ring_cam.getBuffer() == frame);
+  if (nbuf > 1) {
+    ok = ok && (ring_frames == n * 2) && ring_cycles(n, nbuf - 1, frame);
+    frame = ring_cam.acquireFrame(); // Newest, releasing the held one
+    ok = ok && (frame == ring_dest[n * 2 - 1]) &&
+         (ring_frame(frame) == n * 2 - 1) &&
+         (ring_cam.frameInfo()->dropped == 0);
+  } else {
+    ok = ok && (ring_frames == n) && !ring_cam.acquireFrame();
+    ring_cam.releaseFrame(); // Capture resumes...
+    ring_held = NULL;
+    iCap_host_frame();
+    frame = ring_cam.acquireFrame(); // ...with the skipped frames counted
+    ok = ok && (ring_frames == n + 1) && (ring_frame(frame) == n) &&
+         (ring_cam.frameInfo()->dropped == n);
+  }
+  ok = ok && (ring_cam.frameInfo()->sequence - sequence ==
+               (uint32_t)(n + (nbuf == 1)));
+  ring_cam.releaseFrame();
+  iCap_frame_stats stats = ring_cam.frameStats();
+  return ok && (stats.captured == ring_frames) &&
+         (stats.dropped == ((nbuf > 1) ? 0 : n));
+}
+
+// Frames cut short (iCap_host_short_frame(), as if VSYNC came before
+// end-of-DMA) must never be published: pollFrame() stays false, a held
+// or older complete frame is unaffected, and each is counted as dropped
+// and resynced, in frameStats() and the next frame's info. A short JPEG
+// frame is missing its EOI, so is dropped but not resynced (the transfer
+// ends at each VSYNC anyway). Returns 1 if passed, 0 if failed, -1 if
+// skipped.
+static int check_frame_faults(void) {
+  if (ring_cam.start(ICAP_RGB, 2) != ICAP_STATUS_OK) {
+    return -1;
+  }
+  ring_cam.resetFrameStats();
+  uint32_t half = RING_W * RING_H / 2;
+  iCap_host_frame();                         // Frame 0
+  uint16_t *frame = ring_cam.acquireFrame(); // Held
+  iCap_host_short_frame(half);               // Frame 1, into other buffer
+  iCap_frame_stats stats = ring_cam.frameStats();
+  bool ok = !ring_cam.pollFrame() && (ring_cam.getBuffer() == frame) &&
+            (ring_frame(frame) == 0) && (stats.captured == 1) &&
+            (stats.dropped == 1) && (stats.resynced == 1);
+
+  ring_cam.releaseFrame();
+  iCap_host_short_frame(half); // Frame 2, now into either buffer
+  ok = ok && !ring_cam.pollFrame();
+  iCap_host_frame(); // Frame 3, whole
+  frame = ring_cam.acquireFrame();
+  ok = ok && frame && (ring_frame(frame) == 3) &&
+       (ring_cam.frameInfo()->dropped == 2);
+
+  ring_cam.releaseFrame();
+  iCap_host_frame();           // Frame 4, left unclaimed
+  iCap_host_short_frame(half); // Frame 5, into the other buffer
+  frame = ring_cam.acquireFrame();
+  ok = ok && frame && (ring_frame(frame) == 4) && !ring_cam.pollFrame();
+  ring_cam.releaseFrame();
+  stats = ring_cam.frameStats();
+  ok = ok && (stats.captured == 3) && (stats.dropped == 3) &&
+       (stats.resynced == 3);
+
+  ring_arch.source = NULL; // Host's default JPEG stream
+  if (ring_cam.start(ICAP_JPEG, 2) == ICAP_STATUS_OK) {
+    ring_cam.resetFrameStats();
+    iCap_host_short_frame(1); // SOI only
+    ok = ok && !ring_cam.pollFrame();
+    iCap_host_frame();
+    ok = ok && ring_cam.acquireFrame() && (ring_cam.frameInfo()->dropped == 1);
+    ring_cam.releaseFrame();
+    stats = ring_cam.frameStats();
+    ok = ok && (stats.captured == 1) && (stats.dropped == 1) &&
+         (stats.resynced == 0);
+  }
+  ring_arch.source = ring_source;
+  return ok;
+}
+
+// Camera register lists, sent to the host's mock Wire register file: the
+// registers must end up the same with and without burst writes, with one
+// transaction per register without, and with, one per run of consecutive
+// addresses (at most ICAP_I2C_BURST long, not wrapping past 0xFF, cut by
+// a pause). Each transaction is followed by the constructor's delay_us,
+// and the pause by its milliseconds, all of which configTime() must
+// include. Without auto-increment in the device, one register per
+// transaction must still work, and bursts must not. Returns 1 if passed,
+// 0 if failed.
+static int check_write_list(void) {
+  static iCap_parallel_pins pins = { // Unused, never begin()
+      -1, -1, -1, -1, -1, -1, {-1, -1, -1, -1, -1, -1, -1, -1}, -1, -1};
+  const uint8_t addr = 0x42;
+  const uint32_t delay_us = 100;
+  const iCap_parallel_pause pause = {1, 2}; // 2 ms, mid-run
+  Adafruit_iCap_parallel cam(&pins, NULL, NULL, 0, &Wire, addr, 100000,
+                             delay_us);
+  iCap_parallel_config list[49];
+  uint8_t expected[256] = {0};
+  rng_state = 1;
+  for (uint8_t i = 0; i < 49; i++) { // Runs 2, pause, 2, 2, 1, 31, 9, 1, 1
+    list[i].reg = (i < 4)    ? 0x10 + i
+                  : (i < 6)  ? 0x12 + i - 4
+                  : (i < 7)  ? 0x30
+                  : (i < 47) ? 0x40 + i - 7
+                  : (i < 48) ? 0xFF
+                             : 0x00;
+    list[i].value = rng();
+    expected[list[i].reg] = list[i].value;
+  }
+
+  bool ok = true;
+  for (uint8_t mode = 0; mode < 4; mode++) {
+    bool burst = mode & 1;
+    Wire.auto_increment = (mode < 2);
+    for (uint16_t r = 0; r < 256; r++) {
+      Wire.setRegister(addr, r, 0);
+    }
+    cam.setBurstWrite(burst);
+    uint32_t writes = Wire.writes, transactions = Wire.transactions;
+    uint32_t time = cam.configTime();
+    cam.writeList(list, 49, &pause, 1);
+    transactions = Wire.transactions - transactions;
+    ok = ok && (Wire.writes - writes == 49) &&
+         (transactions == (burst ? 8 : 49)) &&
+         (cam.configTime() - time >= transactions * delay_us + pause.ms * 1000);
+    bool same = true;
+    for (uint16_t r = 0; r < 256; r++) {
+      same = same && (Wire.getRegister(addr, r) == expected[r]);
+    }
+    ok = ok && (same == (!burst || Wire.auto_increment));
+  }
+  Wire.auto_increment = true;
+  return ok;
+}
+#endif
+
+static uint16_t passed = 0, failed = 0; // Totals for report()
+
+// Print one check's result, "PASS name" or "FAIL name", then the image
+// size if given (and whether the unaligned image was used), and count it.
+// Skipped checks (result < 0) are neither printed nor counted.
+static void report(int result, const char *name, uint16_t w = 0,
+                   uint16_t h = 0, bool unaligned = false) {
+  if (result < 0) {
+    return; // Skipped, not enough RAM or too big for static buffer
+  }
+  Serial.print(result ? "PASS " : "FAIL ");
+  Serial.print(name);
+  if (w) {
+    Serial.print(' ');
+    Serial.print(w);
+    Serial.print('x');
+    Serial.print(h);
+  }
+  Serial.println(unaligned ? " unaligned" : "");
+  if (result) {
+    passed++;
+  } else {
+    failed++;
+  }
+}
+
+void setup() {
+  Serial.begin(115200);
+#if defined(ARDUINO)
+  while (!Serial)
+    delay(10);
+#endif
+
+  const uint8_t num_sizes = sizeof sizes / sizeof sizes[0];
+  for (uint8_t c = 0; c < sizeof checks / sizeof checks[0]; c++) {
+    for (uint8_t s = 0; s < num_sizes; s++) {
+      uint16_t w = sizes[s].width, h = sizes[s].height;
+      for (uint8_t a = 0; a < 2; a++) {
+        Adafruit_ImageCapture &img = a ? img_unaligned : img_aligned;
+        report(run_check(checks[c], img, w, h), checks[c].name, w, h, a);
+      }
+    }
+  }
+
+  for (uint8_t s = 0; s < num_sizes; s++) {
+    uint16_t w = sizes[s].width, h = sizes[s].height;
+    for (uint8_t a = 0; a < 2; a++) {
+      Adafruit_ImageCapture &img = a ? img_unaligned : img_aligned;
+      report(check_demosaic(img, w, h), "demosaic_rgb565", w, h, a);
+    }
+  }
+
+  static const struct {
+    const char *name;
+    iCap_colorspace space;
+    iCap_jpeg_sampling sampling;
+  } jpeg_checks[] = {{"jpeg_rgb565_420", ICAP_RGB, ICAP_JPEG_420},
+                     {"jpeg_rgb565_422", ICAP_RGB, ICAP_JPEG_422},
+                     {"jpeg_yuv_420", ICAP_YUV, ICAP_JPEG_420},
+                     {"jpeg_yuv_422", ICAP_YUV, ICAP_JPEG_422},
+                     {"jpeg_y8", ICAP_Y8, ICAP_JPEG_420}};
+  for (uint8_t c = 0; c < sizeof jpeg_checks / sizeof jpeg_checks[0]; c++) {
+    for (uint8_t s = 0; s < num_sizes; s++) {
+      uint16_t w = sizes[s].width, h = sizes[s].height;
+      for (uint8_t a = 0; a < 2; a++) {
+        Adafruit_ImageCapture &img = a ? img_unaligned : img_aligned;
+        report(check_jpeg_encode(img, w, h, jpeg_checks[c].space,
+                                 jpeg_checks[c].sampling),
+               jpeg_checks[c].name, w, h, a);
+      }
+    }
+  }
+
+  static const struct {
+    const char *name;
+    iCap_colorspace space;
+  } qoi_checks[] = {{"qoi_rgb565", ICAP_RGB}, {"qoi_yuv", ICAP_YUV}};
+  for (uint8_t c = 0; c < sizeof qoi_checks / sizeof qoi_checks[0]; c++) {
+    for (uint8_t s = 0; s < num_sizes; s++) {
+      uint16_t w = sizes[s].width, h = sizes[s].height;
+      for (uint8_t a = 0; a < 2; a++) {
+        Adafruit_ImageCapture &img = a ? img_unaligned : img_aligned;
+        report(check_qoi(img, w, h, qoi_checks[c].space), qoi_checks[c].name,
+               w, h, a);
+      }
+    }
+  }
+
+  static const struct {
+    const char *name;
+    iCap_colorspace space;
+    iCap_file_format format;
+  } writer_checks[] = {{"writer_bmp_rgb565", ICAP_RGB, ICAP_FILE_BMP},
+                       {"writer_bmp_yuv", ICAP_YUV, ICAP_FILE_BMP},
+                       {"writer_bmp_y8", ICAP_Y8, ICAP_FILE_BMP},
+                       {"writer_ppm_rgb565", ICAP_RGB, ICAP_FILE_PPM},
+                       {"writer_ppm_yuv", ICAP_YUV, ICAP_FILE_PPM},
+                       {"writer_ppm_y8", ICAP_Y8, ICAP_FILE_PPM},
+                       {"writer_pgm_rgb565", ICAP_RGB, ICAP_FILE_PGM},
+                       {"writer_pgm_yuv", ICAP_YUV, ICAP_FILE_PGM},
+                       {"writer_pgm_y8", ICAP_Y8, ICAP_FILE_PGM}};
+  for (uint8_t c = 0; c < sizeof writer_checks / sizeof writer_checks[0];
+       c++) {
+    for (uint8_t s = 0; s < num_sizes; s++) {
+      uint16_t w = sizes[s].width, h = sizes[s].height;
+      for (uint8_t a = 0; a < 2; a++) {
+        Adafruit_ImageCapture &img = a ? img_unaligned : img_aligned;
+        report(check_writer(img, w, h, writer_checks[c].space,
+                            writer_checks[c].format),
+               writer_checks[c].name, w, h, a);
+      }
+    }
+  }
+
+  static const struct {
+    const char *name;
+    iCap_colorspace space;
+    uint16_t width;
+    uint16_t height;
+  } recorder_checks[] = {{"recorder_rgb565", ICAP_RGB, 80, 60},
+                         {"recorder_y8", ICAP_Y8, 5, 3},
+                         {"recorder_jpeg", ICAP_JPEG, 80, 60}};
+  char name[40];
+  for (uint8_t c = 0; c < sizeof recorder_checks / sizeof recorder_checks[0];
+       c++) {
+    for (uint8_t overlap = 0; overlap < 3; overlap++) {
+      uint16_t w = recorder_checks[c].width, h = recorder_checks[c].height;
+      snprintf(name, sizeof name, "%s_overlap%d", recorder_checks[c].name,
+               overlap);
+      report(check_recorder(img_aligned, w, h, recorder_checks[c].space,
+                            overlap),
+             name, w, h);
+    }
+  }
+
+  report(check_scratch(img_aligned, 80, 60), "scratch_arena");
+  report(check_jpeg_frames(img_aligned), "jpeg_frames");
+
+#if !defined(ARDUINO)
+  for (uint8_t nbuf = 1; nbuf <= 3; nbuf++) {
+    snprintf(name, sizeof name, "frame_ring_nbuf%d", nbuf);
+    report(check_frame_ring(nbuf), name);
+  }
+  report(check_frame_faults(), "frame_faults");
+  report(check_write_list(), "write_list");
+#endif
+
+  Serial.print(passed);
+  Serial.print(" passed, ");
+  Serial.print(failed);
+  Serial.println(" failed");
+#if !defined(ARDUINO)
+  exit(failed ? 1 : 0);
+#endif
+}
+
+void loop() {}
+
+#if !defined(ARDUINO)
+int main(void) {
+  setup();
+  return 0;
+}
+#endif
@@ -32,7 +32,7 @@
 
 #if defined(ICAP_FULL_SUPPORT)
 
-#include <string.h> // memcpy()
+#include <string.h> // memcpy(), memset()
 
 Adafruit_ImageCapture::Adafruit_ImageCapture(iCap_arch *arch, uint16_t *pbuf,
                                              uint32_t pbufsize)
@@ -47,12 +47,30 @@ Adafruit_ImageCapture::Adafruit_ImageCapture(iCap_arch *arch, uint16_t *pbuf,
     pixbuf[0] = NULL;
   }
   pixbuf[1] = pixbuf[2] = NULL;
+  memset(frame_info, 0, sizeof frame_info);
+  memset(&frame_stats, 0, sizeof frame_stats);
 }
 
 Adafruit_ImageCapture::~Adafruit_ImageCapture() {
   if (pixbuf_allocable && pixbuf[0]) {
     free(pixbuf[0]);
   }
+  if (scratch_allocable && scratch) {
+    free(scratch);
+  }
+}
+
+// Bits/pixel of each iCap_colorspace as stored in RAM, in enum order.
+// JPEG's is a buffer budget, not a fixed size.
+static const uint8_t iCap_colorspace_bits[] = {16, 16, 8, 8, 12, 8, 4};
+
+uint8_t Adafruit_ImageCapture::bitsPerPixel(iCap_colorspace space) {
+  return iCap_colorspace_bits[space];
+}
+
+uint32_t Adafruit_ImageCapture::frameBytes(uint16_t width, uint16_t height,
+                                           iCap_colorspace space) {
+  return ((uint32_t)width * height * iCap_colorspace_bits[space] + 7) / 8;
 }
 
 #include <Arduino.h>
@@ -60,14 +78,16 @@ iCap_status Adafruit_ImageCapture::bufferConfig(uint16_t width, uint16_t height,
                                                 iCap_colorspace space,
                                                 uint8_t nbuf,
                                                 iCap_realloc allo) {
-  // Currently all (well, both) supported colorspaces are 16bpp...if this
-  // changes in the future, the new_buffer_size calc below will need update.
+  // Bytes per frame follow the colorspace's bits/pixel. Each buffer is
+  // rounded up to a 32-bit boundary so every frame pointer suits
+  // word-sized DMA and SWAR access.
   colorspace = space;
   if (nbuf < 1)
     nbuf = 1; // Constrain number of buffers to 1-3
   else if (nbuf > 3)
     nbuf = 3;
-  uint32_t new_buffer_size = width * height * nbuf * sizeof(uint16_t);
+  uint32_t per_buffer_bytes = (frameBytes(width, height, space) + 3) & ~3;
+  uint32_t new_buffer_size = per_buffer_bytes * nbuf;
   bool ra = false; // Gets set true only if a reallocation is needed
 
   // If static buffer was passed to constructor, reallocation not possible.
@@ -77,7 +97,6 @@ iCap_status Adafruit_ImageCapture::bufferConfig(uint16_t width, uint16_t height,
   else if (pixbuf[0] == NULL)
     allo = ICAP_REALLOC_CHANGE;
 
-  Serial.printf("%d %d %d %d\n", width, height, allo, new_buffer_size);
   switch (allo) {
   case ICAP_REALLOC_NONE:
     // Don't reallocate, keep existing buffer...test if it fits though...
@@ -107,83 +126,495 @@ iCap_status Adafruit_ImageCapture::bufferConfig(uint16_t width, uint16_t height,
       return ICAP_STATUS_ERR_MALLOC;
     }
     pixbuf_size = new_buffer_size;
-
-    uint32_t per_buffer_size = width * height * sizeof(uint16_t);
-    pixbuf[1] = &pixbuf[0][per_buffer_size]; // " double-buffering
-    pixbuf[2] = &pixbuf[1][per_buffer_size]; // " triple
   }
 
+  // Frame pointers are recalculated even if no realloc took place, as
+  // image size and/or number of buffers may have changed within the
+  // existing allocation. Unused frame pointers are NULL.
+  bufmode = nbuf;
+  uint8_t *base = (uint8_t *)pixbuf[0];
+  pixbuf[1] = (nbuf > 1) ? (uint16_t *)&base[per_buffer_bytes] : NULL;
+  pixbuf[2] = (nbuf > 2) ? (uint16_t *)&base[per_buffer_bytes * 2] : NULL;
+  frame_dma = frame_ready = frame_held = -1; // Reset buffer rotation
+  frame_view = frame_last = 0;
+  frame_drops = 0; // Losses under the old settings aren't the next frame's
+
   _width = width;
   _height = height;
 
+  // If the scratch arena is in use and library-allocated, resize it to
+  // suit image_median() at the new size now, rather than on the next
+  // filter call. Same realloc behavior as the image buffer, but failure
+  // isn't an error here; the arena can still grow on demand later.
+  if (scratch_allocable && scratch && (allo != ICAP_REALLOC_NONE)) {
+    uint32_t need = ((width + 2) * 3 + height - 1 + width) * 3;
+    if ((need > scratch_size) ||
+        ((need < scratch_size) && (allo == ICAP_REALLOC_CHANGE))) {
+      free(scratch);
+      scratch = (uint8_t *)malloc(need);
+      scratch_size = scratch ? need : 0;
+    }
+  }
+
   return ICAP_STATUS_OK;
 }
 
+// SCRATCH ARENA ------------------------------------------------------------
+
+// The 3x3 filters, mosaic and image_pipeline() need a few K of RAM for the
+// duration of each call. Rather than malloc() and free() that every time
+// (heap fragmentation, allocator latency, every frame), it's kept in a
+// persistent arena: library-allocated on demand, or a static buffer from
+// the application. Contents don't persist between calls.
+
+iCap_status Adafruit_ImageCapture::scratchConfig(uint32_t size, uint8_t *buf) {
+  if (scratch_allocable && scratch) {
+    free(scratch);
+  }
+  scratch_peak = 0;
+  if (buf) { // Static arena, aligned for image_pipeline()'s structures
+    uint8_t pad = -(uintptr_t)buf & (sizeof(void *) - 1);
+    scratch_allocable = false;
+    scratch = &buf[pad];
+    scratch_size = (size > pad) ? size - pad : 0;
+    return ICAP_STATUS_OK;
+  }
+  scratch_allocable = true;
+  scratch = size ? (uint8_t *)malloc(size) : NULL;
+  scratch_size = scratch ? size : 0;
+  return (size && !scratch) ? ICAP_STATUS_ERR_MALLOC : ICAP_STATUS_OK;
+}
+
+uint8_t *Adafruit_ImageCapture::scratchGet(uint32_t bytes) {
+  if (bytes > scratch_peak) {
+    scratch_peak = bytes; // Logged even if it doesn't fit, for sizing
+  }
+  if (bytes > scratch_size) {
+    if (!scratch_allocable) {
+      return NULL;
+    }
+    // Grow. free() + malloc() rather than realloc(), no need to copy.
+    free(scratch);
+    if (!(scratch = (uint8_t *)malloc(bytes))) {
+      scratch_size = 0;
+      return NULL;
+    }
+    scratch_size = bytes;
+  }
+  return scratch;
+}
+
+// MULTI-BUFFERING ----------------------------------------------------------
+
+// Buffer rotation works the same regardless of the number of buffers. At
+// each VSYNC, the arch-specific interrupt code asks frameStart() for a
+// destination: the next buffer (in round-robin order) that's neither held
+// by the application nor the newest unclaimed frame. If there's no such
+// buffer (e.g. double-buffering with one frame held and one ready), the
+// unclaimed frame is recycled -- it was never seen by the application, so
+// this can't tear, and the newer frame about to load replaces it. Only
+// if every buffer is held (single-buffered, with the frame acquired) is
+// the frame skipped. When DMA completes, frameDone() publishes that buffer
+// as the newest frame, which acquireFrame() hands to the application. If
+// VSYNC arrives before DMA completes (pixels were lost), the arch code
+// aborts the transfer and calls frameAbort(); the partial frame is never
+// published. JPEG frames vary in length and rarely fill the buffer, so
+// instead the arch code ends each one at the following VSYNC through
+// frameEnd(), which checks for a whole image (SOI ... EOI) before
+// publishing it. Each buffer carries an iCap_frame_info record, filled in
+// along the way, and running totals are kept in frame_stats.
+// Buffer indices are modified in interrupt context, hence the noInterrupts()
+// around changes made from application code.
+
+uint16_t *Adafruit_ImageCapture::acquireFrame(void) {
+  uint16_t *buf = NULL;
+  noInterrupts();
+  if (frame_ready >= 0) {     // New frame since last acquire?
+    frame_held = frame_ready; //   Claim it (releases any prior frame)
+    frame_view = frame_held;  //   getBuffer() & filters now use this
+    frame_ready = -1;         //   No longer 'new'
+    buf = pixbuf[frame_held];
+  }
+  interrupts();
+  return buf;
+}
+
+void Adafruit_ImageCapture::releaseFrame(void) { frame_held = -1; }
+
+uint16_t *Adafruit_ImageCapture::waitFrame(uint32_t timeout_ms) {
+  uint32_t start = millis();
+  uint16_t *buf;
+  releaseFrame(); // If single-buffered, a held frame would block capture
+  // acquireFrame() can still return NULL after pollFrame() when single-
+  // buffered (frame recycled at VSYNC), hence the loop on acquire itself.
+  while (!(buf = acquireFrame())) {
+    if ((millis() - start) >= timeout_ms) {
+      break;
+    }
+    yield();
+  }
+  return buf;
+}
+
+uint16_t *Adafruit_ImageCapture::frameStart(uint32_t timestamp_us) {
+  frame_sequence++; // Counts every VSYNC, whether captured or not
+  uint8_t n = frame_last;
+  for (uint8_t i = 0; i < bufmode; i++) { // Round-robin from last buffer
+    if (++n >= bufmode) {
+      n = 0;
+    }
+    if ((n != frame_held) && (n != frame_ready)) { // Free buffer?
+      break;
+    }
+  }
+  if ((n == frame_held) || (n == frame_ready)) { // No free buffer...
+    // Recycle the unclaimed frame if possible.
+    if ((frame_ready >= 0) && (frame_ready != frame_held)) {
+      n = frame_ready;
+      frame_ready = -1;
+    } else { // All buffers held, skip this frame
+      frame_dma = -1;
+      frame_stats.dropped++;
+      frame_drops++;
+      return NULL;
+    }
+  }
+  frame_dma = frame_last = n;
+  iCap_frame_info *info = &frame_info[n];
+  info->sequence = frame_sequence;
+  info->timestamp_us = timestamp_us;
+  info->pixels = info->bytes = 0;
+  info->dropped = frame_drops; // Any lost since prior frame
+  frame_drops = 0;
+  return pixbuf[n];
+}
+
+void Adafruit_ImageCapture::frameDone(uint32_t pixels) {
+  if (frame_dma >= 0) {
+    frame_info[frame_dma].pixels = pixels;
+    if (colorspace != ICAP_COLOR_JPEG) { // else set by frameEnd()
+      frame_info[frame_dma].bytes =
+          ((uint64_t)pixels * bitsPerPixel(colorspace) + 7) / 8;
+    }
+    frame_stats.captured++;
+    frame_ready = frame_dma;  // Newest complete frame
+    if (frame_held < 0) {     // If application isn't holding a frame,
+      frame_view = frame_dma; //   getBuffer() returns newest
+    }
+    frame_dma = -1;
+    if (frame_callback) {
+      (*frame_callback)(this);
+    }
+  }
+}
+
+// Length of the JPEG image at the start of buf, given 'bytes' received, or
+// 0 if there's no whole image there. Markers can't occur within entropy-
+// coded data (0xFF is stuffed as FF 00), and the OV2640 doesn't embed a
+// thumbnail, so the EOI is the last FF D9 received (anything after is
+// padding), or the first in the buffer if the count isn't known.
+static uint32_t iCap_jpeg_length(const uint8_t *buf, uint32_t bytes,
+                                 uint32_t max) {
+  if ((bytes > max) || (max < 4) || (buf[0] != 0xFF) || (buf[1] != 0xD8)) {
+    return 0;
+  }
+  if (bytes) {
+    for (uint32_t i = bytes - 1; i >= 3; i--) { // Back from end
+      if ((buf[i] == 0xD9) && (buf[i - 1] == 0xFF)) {
+        return i + 1;
+      }
+    }
+  } else {
+    for (uint32_t i = 3; i < max; i++) { // Forward from SOI
+      if ((buf[i] == 0xD9) && (buf[i - 1] == 0xFF)) {
+        return i + 1;
+      }
+    }
+  }
+  return 0;
+}
+
+void Adafruit_ImageCapture::frameEnd(uint32_t bytes) {
+  if (frame_dma >= 0) {
+    uint32_t len = iCap_jpeg_length((const uint8_t *)pixbuf[frame_dma], bytes,
+                                    frameBytes(_width, _height, colorspace));
+    if (len) {
+      frame_info[frame_dma].bytes = len;
+      frameDone((uint32_t)_width * _height);
+      return;
+    }
+    // Incomplete, back into rotation as with frameAbort(). Frames lost
+    // before this one are still lost before the next one published.
+    frame_drops += frame_info[frame_dma].dropped + 1;
+    frame_dma = -1;
+    frame_stats.dropped++;
+  }
+}
+
+void Adafruit_ImageCapture::frameAbort(uint32_t pixels) {
+  // Buffer is NOT published -- a partial frame is never handed to the
+  // application -- and goes back into rotation for the next frame.
+  if (frame_dma >= 0) {
+    frame_info[frame_dma].pixels = pixels;
+    frame_drops += frame_info[frame_dma].dropped; // Carried to next frame
+    frame_dma = -1;
+  }
+  frame_stats.dropped++;
+  frame_stats.resynced++;
+  frame_drops++;
+}
+
+iCap_frame_stats Adafruit_ImageCapture::frameStats(void) {
+  noInterrupts(); // Counters are modified in interrupt context
+  iCap_frame_stats stats = frame_stats;
+  interrupts();
+  return stats;
+}
+
+void Adafruit_ImageCapture::resetFrameStats(void) {
+  noInterrupts();
+  memset(&frame_stats, 0, sizeof frame_stats);
+  interrupts();
+}
+
+// PACKED PIXEL (SWAR) PROCESSING -------------------------------------------
+
+// Several of the per-pixel postprocessing functions operate on multiple
+// pixels at once, packed into the widest native integer ("SIMD within a
+// register"): two 16-bit pixels per 32-bit word on microcontrollers, four
+// per 64-bit word on host builds. Pixels are big-endian, so when a word is
+// loaded on these (little-endian) CPUs, each 16-bit lane holds the pixel
+// byte-swapped: for RGB565, lane bits 7-3 are red, 2-0 the upper three
+// bits of green, 15-13 the lower three bits of green and 12-8 blue. For
+// YUV, the lane's low byte is Y and the high byte is U or V. Rather than
+// swapping, the bit manipulation is simply done in that swapped layout.
+// Per-lane operations are arranged so carries never cross lanes.
+//
+// The word-at-a-time loop only runs over a suitably-aligned span. Any
+// leading pixels before that (a static buffer need only be 16-bit
+// aligned) or trailing odd pixels are passed through the same function
+// one at a time, in the low lane with the others zeroed, and the low 16
+// bits of the result kept. So there's one implementation for both paths.
+
+// On Cortex-M4 (SAMD51), the DSP extension's SIMD instructions do some of
+// this more directly: USUB16 compares two halfwords at once, setting
+// per-lane GE flags that SEL then uses to pick results,
+// and REV16 byte-swaps two pixels at once. These are used where they help
+// (threshold and the 3x3 filter row unpack). The portable versions remain
+// the reference; host builds can run the DSP code for testing by defining
+// ICAP_DSP_EMULATE (see arch/host/arm_dsp.h).
+#if defined(__ARM_FEATURE_DSP)
+#define ICAP_DSP ///< Use Cortex-M4 SIMD instructions (CMSIS intrinsics)
+#elif defined(ICAP_DSP_EMULATE) && !defined(ARDUINO)
+#include "arch/host/arm_dsp.h"
+#define ICAP_DSP ///< Use C equivalents of the above, for testing only
+#endif
+
+#if defined(ARDUINO) || defined(ICAP_DSP)
+typedef uint32_t iCap_word; ///< Native word for packed pixel operations
+#else
+typedef uint64_t iCap_word; ///< Host builds: 4 pixels per operation
+#endif
+
+#define ICAP_WORD_PIXELS (sizeof(iCap_word) / 2) ///< 16-bit pixels per word
+#define ICAP_REP16(x) ((iCap_word)(x) * (~(iCap_word)0 / 0xFFFF)) ///< Lanes
+
+// Number of leading pixels to handle one at a time, before pointer is
+// word-aligned (never more than num_pixels).
+static inline uint32_t iCap_word_head(uint16_t *pixels, uint32_t num_pixels) {
+  uint32_t head = (-(uintptr_t)pixels & (sizeof(iCap_word) - 1)) / 2;
+  return (head < num_pixels) ? head : num_pixels;
+}
+
+// Walks a pixel span as described above, applying expression 'op' (which
+// reads and returns 'w', an iCap_word) to each packed word, and to each
+// lone unaligned or leftover pixel.
+#define ICAP_SWAR_LOOP(pixels, num_pixels, op)                                 \
+  {                                                                            \
+    uint32_t head = iCap_word_head(pixels, num_pixels);                        \
+    uint32_t words = (num_pixels - head) / ICAP_WORD_PIXELS;                   \
+    iCap_word *wp = (iCap_word *)&pixels[head], w;                             \
+    uint32_t i;                                                                \
+    for (i = 0; i < head; i++) {                                               \
+      w = pixels[i];                                                           \
+      pixels[i] = (op);                                                        \
+    }                                                                          \
+    for (i = 0; i < words; i++) {                                              \
+      w = wp[i];                                                               \
+      wp[i] = (op);                                                            \
+    }                                                                          \
+    for (i = head + words * ICAP_WORD_PIXELS; i < num_pixels; i++) {           \
+      w = pixels[i];                                                           \
+      pixels[i] = (op);                                                        \
+    }                                                                          \
+  }
+
 // Negative image (avoiding 'invert' terminology as that could be confused
-// for an image flip operation, which is a different function).
+// for an image flip operation, which is a different function). This is
+// one of those operations that can probably be implemented through the
+// camera's gamma curve settings, and if so this function will go away.
+// Any uncompressed colorspace's bytes can be inverted alike; for 8- and
+// 12-bit formats the frame is processed as byte pairs (buffers are padded
+// to 32 bits).
 void Adafruit_ImageCapture::image_negative() {
-  // Working 32 bits at a time is slightly faster. This is dirty pool,
-  // relying on the fact that the camera lib currently only supports
-  // even image sizes (the pixel count will always be a multiple of 2)
-  // and that the image buffer, coming from malloc(), will always be
-  // on a 32-bit-safe boundary. This is one of those operations that
-  // can probably be implemented through the camera's gamma curve
-  // settings, and if so this function will go away.
-  uint32_t *p32 = (uint32_t *)pixbuf[0];
-  uint32_t i, num_pairs = _width * _height / 2;
-  for (i = 0; i < num_pairs; i++) {
-    p32[i] ^= 0xFFFFFFFF;
+  if (colorspace == ICAP_COLOR_JPEG) {
+    return; // Compressed, no pixels to invert
+  }
+  uint16_t *pixels = getBuffer();
+  uint32_t num_pixels = _width * _height;
+  if (bitsPerPixel(colorspace) < 16) {
+    num_pixels = (frameBytes(_width, _height, colorspace) + 1) / 2;
   }
+  ICAP_SWAR_LOOP(pixels, num_pixels, ~w);
+}
+
+#if defined(ICAP_DSP)
+
+// Per-lane RGB565 threshold in the swapped lane layout. Each channel is
+// gathered to the bottom of its halfword, USUB16 sets GE flags for lanes
+// at or above the limit, and SEL fills those lanes' channel bits.
+static inline iCap_word iCap_threshold565(iCap_word w, iCap_word rlimit,
+                                          iCap_word glimit, iCap_word blimit) {
+  uint32_t r = (w >> 3) & 0x001F001F;
+  uint32_t g = ((w & 0x00070007) << 3) | ((w >> 13) & 0x00070007);
+  uint32_t b = (w >> 8) & 0x001F001F;
+  uint32_t result;
+  __USUB16(r, rlimit);
+  result = __SEL(0x00F800F8, 0);
+  __USUB16(g, glimit);
+  result |= __SEL(0xE007E007, 0);
+  __USUB16(b, blimit);
+  return result | __SEL(0x1F001F00, 0);
+}
+
+#else // Portable
+
+// Per-lane RGB565 threshold in the swapped lane layout. Each channel is
+// gathered to the bottom of its lane, a guard bit (0x40) is set above it
+// and the limit subtracted; the guard survives if channel >= limit. That
+// 0/1 flag is then multiplied out to fill the channel's bits.
+static inline iCap_word iCap_threshold565(iCap_word w, iCap_word rlimit,
+                                          iCap_word glimit, iCap_word blimit) {
+  const iCap_word guard = ICAP_REP16(0x40);
+  iCap_word r = (w >> 3) & ICAP_REP16(0x1F);
+  iCap_word g = ((w & ICAP_REP16(0x07)) << 3) | ((w >> 13) & ICAP_REP16(7));
+  iCap_word b = (w >> 8) & ICAP_REP16(0x1F);
+  r = (((r | guard) - rlimit) & guard) >> 6; // 1 if red >= limit
+  g = (((g | guard) - glimit) & guard) >> 6; // 1 if green >= limit
+  b = (((b | guard) - blimit) & guard) >> 6; // 1 if blue >= limit
+  return (r * 0x00F8) | (g * 0xE007) | (b * 0x1F00);
+}
+
+#endif // end ICAP_DSP
+
+// YUV LOOKUP TABLES --------------------------------------------------------
+
+// YUV point operations (threshold, posterize) remap Y and U/V bytes
+// through separate 256-entry tables. U and V are signed color offsets
+// stored centered on 128, so the chroma table must keep 128 as neutral
+// (a luma-style table would tint gray areas). Lookups are per byte, but
+// pixels are loaded and stored a word at a time via ICAP_SWAR_LOOP: in
+// the swapped lane layout (see SWAR notes above), each lane's low byte
+// is Y and its high byte U or V.
+
+// Remap the two pixels in a 32-bit value, Y bytes through 'luma' and U/V
+// bytes through 'chroma'.
+static inline uint32_t iCap_yuv_lut32(uint32_t x, const uint8_t *luma,
+                                      const uint8_t *chroma) {
+  return luma[x & 0xFF] | (chroma[(x >> 8) & 0xFF] << 8) |
+         (luma[(x >> 16) & 0xFF] << 16) | ((uint32_t)chroma[x >> 24] << 24);
+}
+
+// Same for a packed word. Host builds' 64-bit words are done as two
+// independent halves, which schedules far better than one long chain.
+static inline iCap_word iCap_yuv_lut_word(iCap_word w, const uint8_t *luma,
+                                          const uint8_t *chroma) {
+  iCap_word result = iCap_yuv_lut32(w, luma, chroma);
+  if (sizeof(iCap_word) > 4) { // (Split shift is legal for 32-bit words)
+    result |= (iCap_word)iCap_yuv_lut32((w >> 16) >> 16, luma, chroma)
+              << 16 << 16;
+  }
+  return result;
+}
+
+// Remap a YUV image in place through luma and chroma tables.
+static void iCap_yuv_lut(uint16_t *pixels, uint32_t num_pixels,
+                         const uint8_t *luma, const uint8_t *chroma) {
+  ICAP_SWAR_LOOP(pixels, num_pixels, iCap_yuv_lut_word(w, luma, chroma));
+}
+
+// Thresholded U or V byte. Chroma at least threshold / 2 away from neutral
+// saturates in that direction (0 or 255), weaker chroma becomes neutral
+// (128). So a threshold of 0 keeps only the sign of each color offset.
+static inline uint8_t iCap_threshold_chroma(uint8_t v, uint8_t threshold) {
+  uint8_t limit = threshold / 2;
+  if (v >= 128 + limit) {
+    return 255;
+  }
+  return (v < 128 - limit) ? 0 : 128;
 }
 
 // Binary threshold, output is "black and white" per-channel. Pass in
 // threshold level as 0-255, this will be quantized to an appropriate
-// range for the colorspace.
+// range for the colorspace. YUV thresholds Y as-is and U/V about neutral
+// (see iCap_threshold_chroma()).
 void Adafruit_ImageCapture::image_threshold(uint8_t threshold) {
-  uint32_t i, num_pixels = _width * _height;
-  uint16_t *pixels = pixbuf[0];
+  if (bitsPerPixel(colorspace) < 16) { // Y8 capture, others unsupported
+    image_threshold(compactY8(), threshold);
+    return;
+  }
+  uint32_t num_pixels = _width * _height;
+  uint16_t *pixels = getBuffer();
   if (colorspace == ICAP_COLOR_RGB565) {
-    // Testing RGB thresholds "in place" in the packed RGB565 value
-    // avoids some bit-shifting on every pixel (just bit masking).
-    uint16_t rlimit = (threshold >> 3) << 11;  // In-place 565 red threshold
-    uint16_t glimit = (threshold >> 2) << 5;   // In-place 565 green threshold
-    uint16_t blimit = (threshold >> 3);        // In-place 565 blue threshold
-    uint16_t rgb565in, rgb565out;              // Packed RGB565 pixel values
-    for (i = 0; i < num_pixels; i++) {         // For each pixel...
-      rgb565in = __builtin_bswap16(pixels[i]); //   Swap endian from cam
-      rgb565out = 0;                           //   Start with 0 result
-      if ((rgb565in & 0xF800) >= rlimit) {     //   If red exceeds limit
-        rgb565out |= 0xF800;                   //     Set all red bits
-      }
-      if ((rgb565in & 0x07E0) >= glimit) { //   Ditto, green
-        rgb565out |= 0x07E0;
-      }
-      if ((rgb565in & 0x001F) >= blimit) { //   Ditto, blue
-        rgb565out |= 0x001F;
-      }
-      pixels[i] = __builtin_bswap16(rgb565out); //   Back to cam-native endian
+    // Limits are scaled to each channel's bit depth and replicated
+    // across all lanes. Comparisons are then done on packed pixels.
+    iCap_word rlimit = ICAP_REP16(threshold >> 3); // 5 bit red threshold
+    iCap_word glimit = ICAP_REP16(threshold >> 2); // 6 bit green threshold
+    iCap_word blimit = ICAP_REP16(threshold >> 3); // 5 bit blue threshold
+    ICAP_SWAR_LOOP(pixels, num_pixels,
+                   iCap_threshold565(w, rlimit, glimit, blimit));
+  } else { // YUV...
+    uint8_t luma[256], chroma[256];
+    for (uint16_t i = 0; i < 256; i++) {
+      luma[i] = (i >= threshold) ? 255 : 0;
+      chroma[i] = iCap_threshold_chroma(i, threshold);
     }
-  } else {                                    // YUV...
-    uint8_t *p8 = (uint8_t *)pixels;          // Separate Y's, U's, V's
-    num_pixels *= 2;                          // Actually num bytes now
-    for (i = 0; i < num_pixels; i++) {        // For each byte...
-      p8[i] = (p8[i] >= threshold) ? 255 : 0; //   Threshold to 0 or 255
-    }
-    // TO DO: the Y and U/V channels should be handled separately!
-    // Above is OK for Y, but U/V needs work.
+    iCap_yuv_lut(pixels, num_pixels, luma, chroma);
   }
 }
 
+// Posterized value of 'v', an input level in the range 0 to range-1
+// (32 for RGB channels, 256 for YUV), quantized to 'levels' steps (2+)
+// spread evenly across that same range. Shared with image_pipeline().
+static inline uint8_t iCap_posterize_level(uint16_t v, uint8_t levels,
+                                           uint16_t range) {
+  uint8_t lm1 = levels - 1; // Values used in fixed-
+  uint8_t lm1d2 = lm1 / 2;  // point interpolation
+  return (((v * levels + lm1d2) / range) * (range - 1) + lm1d2) / lm1;
+}
+
+// Posterized U or V byte: the offset from neutral 128 is quantized on each
+// side to 'levels' steps (including 0, so neutral stays neutral) spread
+// across that side's range. Shared with image_pipeline().
+static inline uint8_t iCap_posterize_chroma(uint8_t v, uint8_t levels) {
+  if (v >= 128) {
+    return 128 + iCap_posterize_level(v - 128, levels, 128);
+  }
+  return 128 - iCap_posterize_level((v > 0) ? 128 - v : 127, levels, 128);
+}
+
 // Reduce color fidelity to a specified number of steps or levels.
 void Adafruit_ImageCapture::image_posterize(uint8_t levels) {
-  uint16_t *pixels = pixbuf[0];
+  if (bitsPerPixel(colorspace) < 16) { // Y8 capture, others unsupported
+    image_posterize(compactY8(), levels);
+    return;
+  }
+  uint16_t *pixels = getBuffer();
   uint32_t i, num_pixels = _width * _height;
 
-  if (levels < 1) {
-    levels = 1;
+  if (levels < 2) {
+    levels = 2; // 1 level would divide by zero
   }
-  uint8_t lm1 = levels - 1; // Values used in fixed-
-  uint8_t lm1d2 = lm1 / 2;  // point interpolation
 
   if (colorspace == ICAP_COLOR_RGB565) {
     if (levels >= 32) {
@@ -195,43 +626,291 @@ void Adafruit_ImageCapture::image_posterize(uint8_t levels) {
       // Green is a special case here -- with RGB565 colors, the extra bit
       // of green would make for posterization thresholds that are not
       // uniform and may have weird halos. So the input is decimated to
-      // RGB555, posterized, and result scaled to RGB565.
-      uint16_t rtable[32], gtable[32], rgb;
-      uint8_t btable[32];
+      // RGB555, posterized, and result scaled to RGB565. Table lookups
+      // don't pack into words like the other functions, but tables are
+      // stored byte-swapped so big-endian pixels can be remapped directly,
+      // indexing by fields in the swapped layout (see SWAR notes above).
+      uint16_t rtable[32], gtable[32], btable[32], p;
       for (i = 0; i < 32; i++) { // 5 bits each
-        btable[i] = (((i * levels + lm1d2) / 32) * 31 + lm1d2) / lm1;
-        rtable[i] = btable[i] << 11;
-        gtable[i] = (btable[i] << 6) | ((btable[i] & 0x10) << 1);
+        uint8_t b = iCap_posterize_level(i, levels, 32);
+        rtable[i] = __builtin_bswap16(b << 11);
+        gtable[i] = __builtin_bswap16((b << 6) | ((b & 0x10) << 1));
+        btable[i] = __builtin_bswap16(b);
       }
-      for (i = 0; i < num_pixels; i++) {    // For each pixel...
-        rgb = __builtin_bswap16(pixels[i]); // Data from camera is big-endian
-        // Dismantle RGB into components, remap each through color table
-        rgb = rtable[rgb >> 11] | gtable[(rgb >> 6) & 31] | btable[rgb & 31];
-        pixels[i] = __builtin_bswap16(rgb); // Back to big-endian
+      for (i = 0; i < num_pixels; i++) { // For each pixel...
+        p = pixels[i];                   // Swapped: GGGBBBBB RRRRRGGG
+        pixels[i] = rtable[(p >> 3) & 31] | gtable[((p & 7) << 2) | (p >> 14)] |
+                    btable[(p >> 8) & 31];
       }
     }
   } else { // YUV
     if (levels == 255) {
       return;
     } else {
-      uint8_t table[256];
+      uint8_t luma[256], chroma[256];
       for (i = 0; i < 256; i++) {
-        table[i] = (((i * levels + lm1d2) / 256) * 255 + lm1d2) / lm1;
+        luma[i] = iCap_posterize_level(i, levels, 256);
+        chroma[i] = iCap_posterize_chroma(i, levels);
+      }
+      iCap_yuv_lut(pixels, num_pixels, luma, chroma);
+    }
+  }
+}
+
+// Shower door effect. Each band of tiles (tile_height rows) is summed a
+// full image row at a time (sequential access) into running column sums,
+// which are then all each tile needs: no pixel is visited twice, and the
+// cost per tile doesn't grow with its height. For tiles more than
+// ICAP_MOSAIC_NARROW bytes across, a column is a whole tile: each row
+// segment within a tile accumulates in registers, then adds to that
+// tile's three totals. For narrower tiles that per-tile work on every row
+// would dominate (2x2 ran slower than the tile-at-a-time original), so
+// instead each pixel column keeps its own totals, packed in a single
+// 64-bit word (one add per pixel), and a tile sums its few columns once
+// per band, with channels shifted down to keep its division exact as a
+// multiply (see iCap_recip()). The RGB565, YUV and Y8 paths
+// differ only in what the totals are and how a tile's average is packed
+// back into pixels. Uses 12 bytes of the scratch arena per tile across,
+// or for narrow tiles, per pixel column 8 bytes (RGB565), 4 (YUV) or 2
+// (Y8).
+
+#define ICAP_MOSAIC_NARROW 8 // Max bytes across for per-pixel column sums
+#define ICAP_MOSAIC_G 21     // Packed RGB565 totals: bit position of green
+#define ICAP_MOSAIC_R 43     //   and red (blue at 0), fields wide enough
+#define ICAP_MOSAIC_U 21     //   for 255 rows; YUV: U, V (Y at 0)
+#define ICAP_MOSAIC_V 42
+
+// Add one image row into the per-tile totals (three per tile). RGB565
+// sums red, green and blue; as in the original, channels accumulate in
+// place (masked, not shifted down), and 255 x 255 maximal reds just fit in
+// 32 bits. YUV sums Y, U and V; tile_width is even so every tile starts on
+// a U (Y0 U0 Y1 V0) pair, only a clipped last tile may end on half a pair.
+// Y8 sums just Y.
+static void iCap_mosaic_row(const uint8_t *src, uint16_t width,
+                            uint16_t tile_width, uint32_t *sum,
+                            iCap_colorspace space) {
+  for (uint16_t x1 = 0; x1 < width; x1 += tile_width, sum += 3) {
+    uint16_t n = (width - x1 > tile_width) ? tile_width : width - x1;
+    uint32_t sum0 = 0, sum1 = 0, sum2 = 0;
+    if (space == ICAP_COLOR_Y8) {
+      for (uint16_t i = n; i--;) {
+        sum0 += *src++;
+      }
+    } else if (space == ICAP_COLOR_YUV) {
+      for (uint16_t i = n / 2; i--; src += 4) { // Each Y0 U0 Y1 V0 pair...
+        sum0 += src[0] + src[2];
+        sum1 += src[1];
+        sum2 += src[3];
       }
-      uint8_t *p8 = (uint8_t *)pixels;   // Separate Ys, Us, Vs
-      num_pixels *= 2;                   // Actually num bytes now
-      for (i = 0; i < num_pixels; i++) { // For each byte...
-        p8[i] = table[p8[i]];            //   Remap through lookup table
+      if (n & 1) { // Half pair at right edge of image
+        sum0 += src[0];
+        sum1 += src[1];
+        src += 2;
       }
+    } else {
+      for (uint16_t i = n; i--; src += 2) { // (16-bit aligned)
+        uint16_t rgb = __builtin_bswap16(*(const uint16_t *)src);
+        sum0 += rgb & 0b1111100000000000; // Accumulate in-place,
+        sum1 += rgb & 0b0000011111100000; // no shift down needed
+        sum2 += rgb & 0b0000000000011111;
+      }
+    }
+    sum[0] += sum0;
+    sum[1] += sum1;
+    sum[2] += sum2;
+  }
+}
+
+// Store (if 'first', the band's top row) or add one image row into the
+// per-pixel column totals for narrow tiles: RGB565 packed per pixel, YUV
+// per Y0 U0 Y1 V0 pair (Y0 + Y1, U, V), Y8 a 16-bit total per pixel.
+static void iCap_mosaic_cols(const uint8_t *src, uint16_t width, void *col,
+                             iCap_colorspace space, bool first) {
+  uint16_t x;
+  if (space == ICAP_COLOR_RGB565) {
+    const uint16_t *src16 = (const uint16_t *)src; // (16-bit aligned)
+    uint64_t *c = (uint64_t *)col;
+    for (x = 0; x < width; x++) {
+      uint16_t rgb = __builtin_bswap16(src16[x]);
+      uint64_t sum = (rgb & 0x001F) |
+                     ((uint64_t)(rgb & 0x07E0) << (ICAP_MOSAIC_G - 5)) |
+                     ((uint64_t)(rgb & 0xF800) << (ICAP_MOSAIC_R - 11));
+      c[x] = first ? sum : c[x] + sum;
+    }
+  } else if (space == ICAP_COLOR_YUV) {
+    uint64_t *c = (uint64_t *)col;
+    for (x = 0; x < width / 2; x++, src += 4) { // Each Y0 U0 Y1 V0...
+      uint64_t sum = (src[0] + src[2]) | ((uint64_t)src[1] << ICAP_MOSAIC_U) |
+                     ((uint64_t)src[3] << ICAP_MOSAIC_V);
+      c[x] = first ? sum : c[x] + sum;
+    }
+    if (width & 1) { // Half pair at right edge of image
+      uint64_t sum = src[0] | ((uint64_t)src[1] << ICAP_MOSAIC_U);
+      c[x] = first ? sum : c[x] + sum;
+    }
+  } else {
+    uint16_t *c = (uint16_t *)col;
+    for (x = 0; x < width; x++) {
+      c[x] = first ? src[x] : c[x] + src[x];
+    }
+  }
+}
+
+// A tile's averages are floor divisions by a pixel count that's the same
+// for every full tile in a band, so division (tens of cycles, and for 2x2
+// tiles most of the work) is replaced by multiplying with a reciprocal
+// from iCap_recip(). Exact for numerators under 2^24 and divisors up to
+// 65536, which covers a 256x255 tile's sums of 8-bit values.
+static inline uint64_t iCap_recip(uint32_t d) { return (1ULL << 40) / d + 1; }
+
+static inline uint32_t iCap_div(uint32_t x, uint64_t recip) {
+  return (x * recip) >> 40;
+}
+
+iCap_status Adafruit_ImageCapture::mosaic(uint8_t *pixels, uint16_t width,
+                                          uint16_t height,
+                                          iCap_colorspace space,
+                                          uint8_t tile_width,
+                                          uint8_t tile_height) {
+  if ((space != ICAP_COLOR_RGB565) && (space != ICAP_COLOR_YUV) &&
+      (space != ICAP_COLOR_Y8)) { // Other formats not supported
+    return ICAP_STATUS_OK;
+  }
+  if (tile_width < 1) {
+    tile_width = 1;
+  }
+  if (tile_height < 1) {
+    tile_height = 1;
+  }
+  uint16_t tw = tile_width;
+  if (space == ICAP_COLOR_YUV) {
+    tw = (tw + 1) & ~1; // Even, so U & V stay paired within tiles (1 too)
+  }
+  if ((tw == 1) && (tile_height == 1)) { // 1x1 tiles, image is unchanged
+    return ICAP_STATUS_OK;
+  }
+
+  uint8_t bpp = (space == ICAP_COLOR_Y8) ? 1 : 2; // Bytes per pixel
+  bool narrow = (tw * bpp <= ICAP_MOSAIC_NARROW); // Per-pixel columns?
+  uint32_t sums_bytes = (width + (tw - 1)) / tw * 3 * sizeof(uint32_t);
+  if (narrow) {
+    sums_bytes = (space == ICAP_COLOR_RGB565) ? width * 8
+                 : (space == ICAP_COLOR_YUV)  ? (width + 1) / 2 * 8
+                                              : width * 2;
+  }
+  uint8_t *sums = scratchGet(sums_bytes);
+  if (!sums) {
+    return ICAP_STATUS_ERR_MALLOC;
+  }
+  uint32_t row_bytes = width * bpp;
+  uint16_t x, y, x1, x2, y1, rows, rgb;
+
+  for (y1 = 0; y1 < height; y1 += rows) { // Each tile row (band)...
+    rows = (height - y1 > tile_height) ? tile_height : height - y1;
+    uint8_t *dst = &pixels[y1 * row_bytes]; // Top row of band
+    if (!narrow) {
+      memset(sums, 0, sums_bytes);
+    }
+    for (y = 0; y < rows; y++) { // Each pixel row in band...
+      if (narrow) {
+        iCap_mosaic_cols(&dst[y * row_bytes], width, sums, space, !y);
+      } else {
+        iCap_mosaic_row(&dst[y * row_bytes], width, tw, (uint32_t *)sums,
+                        space);
+      }
+    }
+    uint64_t full = iCap_recip(tw * rows), half = 0; // Full tile, and
+    if (space == ICAP_COLOR_YUV) {                   // its U or V count
+      half = iCap_recip(tw / 2 * rows);
+    }
+    const uint32_t *tile = (const uint32_t *)sums;
+    const uint64_t *c = (const uint64_t *)sums;
+    const uint16_t *c16 = (const uint16_t *)sums;
+    for (x1 = 0; x1 < width; x1 = x2) { // Each tile...
+      x2 = (width - x1 > tw) ? x1 + tw : width;
+      uint16_t n = x2 - x1; // Columns in tile
+      uint64_t recip = (n == tw) ? full : iCap_recip(n * rows);
+      uint32_t sum0, sum1 = 0, sum2 = 0; // Tile totals
+      if (!narrow) {
+        sum0 = tile[0];
+        sum1 = tile[1];
+        sum2 = tile[2];
+        tile += 3;
+      } else if (space == ICAP_COLOR_Y8) {
+        for (sum0 = 0, x = n; x--;) {
+          sum0 += *c16++;
+        }
+      } else if (space == ICAP_COLOR_YUV) { // Too big to sum packed
+        for (sum0 = 0, x = (n + 1) / 2; x--; c++) {
+          sum0 += *c & ((1 << ICAP_MOSAIC_U) - 1);
+          sum1 += (*c >> ICAP_MOSAIC_U) & ((1 << ICAP_MOSAIC_U) - 1);
+          sum2 += *c >> ICAP_MOSAIC_V;
+        }
+      } else {
+        uint64_t sum = 0; // Fields are wide enough for the whole tile
+        for (x = n; x--;) {
+          sum += *c++;
+        }
+        sum0 = sum >> ICAP_MOSAIC_R;
+        sum1 = (sum >> ICAP_MOSAIC_G) & ((1 << (ICAP_MOSAIC_R -
+                                                 ICAP_MOSAIC_G)) - 1);
+        sum2 = sum & ((1 << ICAP_MOSAIC_G) - 1);
+      }
+
+      uint8_t *p8 = &dst[x1 * bpp];
+      if (space == ICAP_COLOR_Y8) {
+        memset(p8, iCap_div(sum0, recip), n);
+      } else if (space == ICAP_COLOR_YUV) {
+        // U count is half the pixels rounded up, V rounded down (maybe 0,
+        // in which case no pixel in the tile takes a V anyway). Both are
+        // half a full tile's.
+        uint8_t luma = iCap_div(sum0, recip), uv[2];
+        if (n == tw) {
+          uv[0] = iCap_div(sum1, half);
+          uv[1] = iCap_div(sum2, half);
+        } else {
+          uv[0] = sum1 / (((n + 1) / 2) * rows);
+          uv[1] = (n > 1) ? sum2 / ((n / 2) * rows) : 0;
+        }
+        for (x = 0; x < n; x++) { // Overwrite top row of tile
+          *p8++ = luma;           // with averaged tile value
+          *p8++ = uv[x & 1];
+        }
+      } else {
+        if (narrow) {
+          rgb = (iCap_div(sum0, recip) << 11) |
+                (iCap_div(sum1, recip) << 5) | iCap_div(sum2, recip);
+        } else { // In-place sums, too big for iCap_div()
+          uint32_t pixels_in_tile = n * rows;
+          rgb = ((sum0 / pixels_in_tile) & 0b1111100000000000) |
+                ((sum1 / pixels_in_tile) & 0b0000011111100000) |
+                ((sum2 / pixels_in_tile) & 0b0000000000011111);
+        }
+        rgb = __builtin_bswap16(rgb);
+        for (x = x1; x < x2; x++) {   // Overwrite top row of tile
+          ((uint16_t *)dst)[x] = rgb; // with averaged tile value
+        }
+      }
+    }
+    // Duplicate scanlines to fill tiles on Y axis
+    for (y = 1; y < rows; y++) {
+      memcpy(&dst[y * row_bytes], dst, row_bytes);
     }
-    // TO DO: as with threshold(), I don't think this is handling the YUV
-    // case properly.
   }
+  return ICAP_STATUS_OK;
+}
+
+iCap_status Adafruit_ImageCapture::image_mosaic(uint8_t tile_width,
+                                                uint8_t tile_height) {
+  return mosaic((uint8_t *)getBuffer(), _width, _height, colorspace,
+                tile_width, tile_height);
 }
 
-// Shower door effect.
-void Adafruit_ImageCapture::image_mosaic(uint8_t tile_width,
-                                         uint8_t tile_height) {
+// Original tile-at-a-time mosaic, same output as image_mosaic() but
+// slower. Kept as a known-good reference for checking optimizations.
+// RGB565 only.
+void Adafruit_ImageCapture::image_mosaic_reference(uint8_t tile_width,
+                                                   uint8_t tile_height) {
   if ((tile_width <= 1) && (tile_height <= 1)) {
     return;
   }
@@ -242,12 +921,12 @@ void Adafruit_ImageCapture::image_mosaic(uint8_t tile_width,
     tile_height = 1;
   }
 
-  uint8_t tiles_across = (_width + (tile_width - 1)) / tile_width;
-  uint8_t tiles_down = (_height + (tile_height - 1)) / tile_height;
+  uint16_t tiles_across = (_width + (tile_width - 1)) / tile_width;
+  uint16_t tiles_down = (_height + (tile_height - 1)) / tile_height;
   uint16_t tile_x, tile_y;
   uint16_t x1, x2, y1, y2, xx, yy; // Tile bounds, counters
   uint32_t pixels_in_tile;
-  uint16_t *pixels = pixbuf[0];
+  uint16_t *pixels = getBuffer();
 
   if (colorspace == ICAP_COLOR_RGB565) {
     uint16_t rgb;
@@ -299,9 +978,6 @@ void Adafruit_ImageCapture::image_mosaic(uint8_t tile_width,
       }
       y1 += tile_height; // Advance pixel index by one tile row
     }
-  } else { // YUV
-    // YUV is not handled yet because it's weird, with U & V
-    // on alternating pixels. This will require Some Doing.
   }
 }
 
@@ -389,6 +1065,13 @@ void Adafruit_ImageCapture::image_mosaic(uint8_t tile_width,
 //   9-element (3x3) list doesn't require sorting the whole list as is
 //   typically described. It's sufficient to identify the maximum of the
 //   least five values, or minimum of largest five, same result all around.
+//   Better still, the noodle format hands us each 3-pixel column as three
+//   consecutive bytes. If every column is sorted (low, mid, high), the
+//   median of the 3x3 square is the median of: the max of the three lows,
+//   the median of the three mids and the min of the three highs. Each
+//   column is sorted just once and reused by the next two pixels, so it's
+//   about 3 + 6 compare-and-selects per pixel instead of 30-odd compares
+//   of the selection method (which is kept as a reference, for checking).
 //
 // Thank you for coming to my TED Talk.
 
@@ -400,13 +1083,37 @@ void Adafruit_ImageCapture::image_mosaic(uint8_t tile_width,
 // median to operate on all source image pixels, no black border or other
 // uglies. Pixels within each channel are not sequential in memory, but
 // increment by 3's -- corresponding to the prior, current and next rows.
+// If 'reference' is set, the plain one-pixel-at-a-time code is used
+// throughout (for image_median_reference()).
 static void iCap_filter_row_prep(uint16_t *src, uint8_t *r_dst, uint16_t width,
-                                 uint32_t channel_bytes) {
+                                 uint32_t channel_bytes,
+                                 bool reference = false) {
   uint8_t *g_dst = &r_dst[channel_bytes];
   uint8_t *b_dst = &g_dst[channel_bytes];
 
-  uint16_t x, rgb, offset = 3;
-  for (x = 0; x < width; x++) {        // For each pixel in row...
+  uint16_t x = 0, rgb, offset = 3;
+#if defined(ICAP_DSP)
+  // Two pixels per 32-bit load; REV16 byte-swaps both at once, then each
+  // channel is extracted from both halfwords with a single shift and mask.
+  for (; !reference && (x + 1 < width); x += 2, offset += 6) {
+    uint32_t pair, r, g, b;
+    memcpy(&pair, src, 4); // Static buffer may be unaligned, M4 is OK w/that
+    src += 2;
+    pair = __REV16(pair); // Two native RGB565 pixels
+    r = (pair >> 11) & 0x001F001F;
+    g = (pair >> 5) & 0x003F003F;
+    b = pair & 0x001F001F;
+    r_dst[offset] = r;
+    g_dst[offset] = g;
+    b_dst[offset] = b;
+    r_dst[offset + 3] = r >> 16;
+    g_dst[offset + 3] = g >> 16;
+    b_dst[offset + 3] = b >> 16;
+  }
+#else
+  (void)reference; // Plain code is all there is
+#endif
+  for (; x < width; x++) {             // For each (remaining) pixel in row...
     rgb = __builtin_bswap16(*src++);   // Packed RGB565 pixel
     r_dst[offset] = rgb >> 11;         // Extract 5 bits red,
     g_dst[offset] = (rgb >> 5) & 0x3F; // 6 bits green,
@@ -438,6 +1145,55 @@ static void iCap_filter_row_copy(uint8_t *r_src, uint8_t *r_dst, uint16_t width,
   }
 }
 
+// Load one row of one channel into the 3x3 filter format: 'count' 8-bit
+// values, 'stride' bytes apart in src, with edge pixels duplicated as
+// iCap_filter_row_prep() does.
+static void iCap_noodle_load(const uint8_t *src, uint8_t stride,
+                             uint16_t count, uint8_t *dst) {
+  uint16_t x, offset = 3;
+  for (x = 0; x < count; x++, offset += 3) {
+    dst[offset] = *src;
+    src += stride;
+  }
+  dst[0] = dst[3];               // Duplicate leftmost pixel
+  dst[offset] = dst[offset - 3]; // Duplicate rightmost pixel
+}
+
+// Load one row of planar 8-bit channel data (red, green, blue, each
+// 'width' bytes, consecutive) into the 3x3 filter format. Used by
+// image_pipeline(), where rows arrive already unpacked.
+static void iCap_filter_row_load(const uint8_t *src, uint8_t *r_dst,
+                                 uint16_t width, uint32_t channel_bytes) {
+  for (uint8_t c = 0; c < 3; c++) { // For each channel...
+    iCap_noodle_load(&src[c * width], 1, width, &r_dst[c * channel_bytes]);
+  }
+}
+
+// YUV equivalents of iCap_filter_row_prep() and iCap_filter_row_load().
+// The three 'channels' are planes: Y at full width, then U and V at half
+// width (4:2:2, U from even pixels, V from odd). Each plane is allocated
+// channel_bytes as for RGB, U and V just use less of it. The _prep variant
+// takes a packed image row (bytes Y0 U0 Y1 V0 ...); _load a planar row as
+// image_pipeline() keeps it (Y bytes, then U/V bytes in pixel order).
+static void iCap_filter_row_prep_yuv(const uint16_t *src, uint8_t *y_dst,
+                                     uint16_t width, uint32_t channel_bytes) {
+  const uint8_t *p8 = (const uint8_t *)src;
+  iCap_noodle_load(p8, 2, width, y_dst);
+  iCap_noodle_load(&p8[1], 4, (width + 1) / 2, &y_dst[channel_bytes]);
+  if (width > 1) {
+    iCap_noodle_load(&p8[3], 4, width / 2, &y_dst[channel_bytes * 2]);
+  }
+}
+
+static void iCap_filter_row_load_yuv(const uint8_t *src, uint8_t *y_dst,
+                                     uint16_t width, uint32_t channel_bytes) {
+  iCap_noodle_load(src, 1, width, y_dst);
+  iCap_noodle_load(&src[width], 2, (width + 1) / 2, &y_dst[channel_bytes]);
+  if (width > 1) {
+    iCap_noodle_load(&src[width + 1], 2, width / 2, &y_dst[channel_bytes * 2]);
+  }
+}
+
 // Determine median value of 9-element list
 static inline uint8_t iCap_med9(uint8_t *list) {
 
@@ -511,163 +1267,1067 @@ static inline uint8_t iCap_med9(uint8_t *list) {
 #endif // end A/B testing
 }
 
-// 3x3 median filter for noise reduction. Even with Clever Optimizations(tm)
-// this is a tad slow, it's just the nature of the thing...lots and lots and
-// lots of pixel comparisons. Requires a chunk of RAM temporarily,
-// ((width + 2) * 3 + height - 1) * 3 bytes, or about 3.6K for a 320x240
-// RGB image. YUV is not currently supported.
-void Adafruit_ImageCapture::image_median() {
-  uint16_t *pixels = pixbuf[0];
-  if (colorspace == ICAP_COLOR_RGB565) {
-    uint8_t *buf;
-    uint32_t buf_bytes_per_channel = (_width + 2) * 3 + _height - 1;
-    if ((buf = (uint8_t *)malloc(buf_bytes_per_channel * 3))) {
-      uint8_t *rptr = buf;                          // -> red buffer
-      uint8_t *gptr = &rptr[buf_bytes_per_channel]; // -> green buffer
-      uint8_t *bptr = &gptr[buf_bytes_per_channel]; // -> blue buffer
-
-      // For each of the three channel pointers (rptr, gptr, bptr),
-      // ptr[0] is the first pixel of the row ABOVE the current one,
-      // ptr[1] is the first pixel of the current row (0 to height-1),
-      // ptr[2] is the first pixel of the row BELOW the current one.
-      // Horizontal pixel addresses then increment by 3's...for each
-      // column (x) in row, pixel x = ptr[x * 3 + n], where n is 0, 1, 2
-      // for the above, current, and below rows, respectively.
-
-      // Convert pixel data into the initial 'current' (1) row buf
-      iCap_filter_row_prep(pixels, &rptr[1], _width, buf_bytes_per_channel);
-
-      // Copy pixel data from the initial (1) row to the prior (0) row buf
-      // (Because edge pixels are repeated so we can 3x3 filter full image)
-      iCap_filter_row_copy(&rptr[1], rptr, _width + 2, buf_bytes_per_channel);
-
-      uint16_t *ptr = pixels; // Dest pointer, back into source image
-      uint16_t x, y, offset, rgb;
-      uint8_t r_med, g_med, b_med;
-      for (y = 0; y < _height; y++) { // For each row of image...
-        // Set up 'below' row buffer...
-        if (y < (_height - 1)) { // If current row is 0 to height-2
-          // Convert pixel data into the 'next' (2) row buf
-          iCap_filter_row_prep(&pixels[(y + 1) * _width], &rptr[2], _width,
-                               buf_bytes_per_channel);
-        } else { // Last row, y = height-1
-          // Copy pixel data from current (1) row to next (2) row buf
-          // (Edge pixels are repeated so we can 3x3 filter full image)
-          iCap_filter_row_copy(&rptr[1], &rptr[2], _width + 2,
-                               buf_bytes_per_channel);
-        }
+// Branchless-ish 8-bit min/max/median-of-3; compilers turn these into
+// conditional selects rather than jumps.
+static inline uint8_t iCap_min8(uint8_t a, uint8_t b) { return a < b ? a : b; }
+static inline uint8_t iCap_max8(uint8_t a, uint8_t b) { return a > b ? a : b; }
+static inline uint8_t iCap_med3(uint8_t a, uint8_t b, uint8_t c) {
+  return iCap_max8(iCap_min8(a, b), iCap_min8(iCap_max8(a, b), c));
+}
 
-        for (x = offset = 0; x < _width; x++, offset += 3) { // Each column...
-          r_med = iCap_med9(&rptr[offset]);                  // 3x3 median red
-          g_med = iCap_med9(&gptr[offset]);                  // " green
-          b_med = iCap_med9(&bptr[offset]);                  // " blue
-          rgb = (r_med << 11) | (g_med << 5) | b_med;        // Recombine 565
-          *ptr++ = __builtin_bswap16(rgb);                   // back in image
-        }
-        rptr++; // Next row
-        gptr++;
-        bptr++;
-      }
+// Sort one 3-pixel noodle column into low, mid, high.
+static inline void iCap_sort3(const uint8_t *p, uint8_t *lo, uint8_t *mid,
+                              uint8_t *hi) {
+  *lo = iCap_min8(iCap_min8(p[0], p[1]), p[2]);
+  *hi = iCap_max8(iCap_max8(p[0], p[1]), p[2]);
+  *mid = iCap_med3(p[0], p[1], p[2]);
+}
 
-      free(buf);
-    }
-  } else { // YUV
-    // Not yet supported. Tricky because of alternating U/V pixels.
+// 3x3 medians for one row of one channel, using presorted columns (see
+// notes above). src is the noodle buffer for this channel at the current
+// row (src[0] = left edge pixel, prior row), dst is one value per pixel.
+static void iCap_med9_row(const uint8_t *src, uint8_t *dst, uint16_t width) {
+  uint8_t lo0, mid0, hi0, lo1, mid1, hi1, lo2, mid2, hi2;
+  iCap_sort3(src, &lo0, &mid0, &hi0);     // Column x-1
+  iCap_sort3(&src[3], &lo1, &mid1, &hi1); // Column x
+  src += 6;
+  for (uint16_t x = 0; x < width; x++, src += 3) {
+    iCap_sort3(src, &lo2, &mid2, &hi2); // Column x+1
+    uint8_t lo = iCap_max8(iCap_max8(lo0, lo1), lo2);
+    uint8_t hi = iCap_min8(iCap_min8(hi0, hi1), hi2);
+    dst[x] = iCap_med3(lo, iCap_med3(mid0, mid1, mid2), hi);
+    lo0 = lo1; // Shift columns left for next pixel
+    mid0 = mid1;
+    hi0 = hi1;
+    lo1 = lo2;
+    mid1 = mid2;
+    hi1 = hi2;
   }
 }
 
-// EDGE DETECTION -----------------------------------------------------------
+// Size of each channel of a 3x3 filter's noodle buffer, in bytes
+static inline uint32_t iCap_noodle_bytes(uint16_t width, uint16_t height) {
+  return (width + 2) * 3 + height - 1;
+}
 
-// Edge detection borrows a lot of code from the median function above...
-// same peculiar looped image format, primary change is just the function
-// called in the per-pixel loop.
+// Scratch needed by image_median(): noodle buffer and median rows, 3 bytes
+// each per channel (rows unused by the reference), about 4.6K for 320x240.
+static inline uint32_t iCap_median_bytes(uint16_t width, uint16_t height) {
+  return (iCap_noodle_bytes(width, height) + width) * 3;
+}
+
+// Common guts of image_median() and image_median_reference(), using 'buf'
+// of iCap_median_bytes() as working space.
+static void iCap_median(uint16_t *pixels, uint8_t *buf, uint16_t width,
+                        uint16_t height, bool reference) {
+  uint32_t buf_bytes_per_channel = iCap_noodle_bytes(width, height);
+  uint8_t *rptr = buf;                          // -> red buffer
+  uint8_t *gptr = &rptr[buf_bytes_per_channel]; // -> green buffer
+  uint8_t *bptr = &gptr[buf_bytes_per_channel]; // -> blue buffer
+
+  // For each of the three channel pointers (rptr, gptr, bptr),
+  // ptr[0] is the first pixel of the row ABOVE the current one,
+  // ptr[1] is the first pixel of the current row (0 to height-1),
+  // ptr[2] is the first pixel of the row BELOW the current one.
+  // Horizontal pixel addresses then increment by 3's...for each
+  // column (x) in row, pixel x = ptr[x * 3 + n], where n is 0, 1, 2
+  // for the above, current, and below rows, respectively.
+
+  // Convert pixel data into the initial 'current' (1) row buf
+  iCap_filter_row_prep(pixels, &rptr[1], width, buf_bytes_per_channel,
+                       reference);
+
+  // Copy pixel data from the initial (1) row to the prior (0) row buf
+  // (Because edge pixels are repeated so we can 3x3 filter full image)
+  iCap_filter_row_copy(&rptr[1], rptr, width + 2, buf_bytes_per_channel);
+
+  uint16_t *ptr = pixels; // Dest pointer, back into source image
+  uint16_t x, y, offset, rgb;
+  uint8_t r_med, g_med, b_med;
+  for (y = 0; y < height; y++) { // For each row of image...
+    // Set up 'below' row buffer...
+    if (y < (height - 1)) { // If current row is 0 to height-2
+      // Convert pixel data into the 'next' (2) row buf
+      iCap_filter_row_prep(&pixels[(y + 1) * width], &rptr[2], width,
+                           buf_bytes_per_channel, reference);
+    } else { // Last row, y = height-1
+      // Copy pixel data from current (1) row to next (2) row buf
+      // (Edge pixels are repeated so we can 3x3 filter full image)
+      iCap_filter_row_copy(&rptr[1], &rptr[2], width + 2,
+                           buf_bytes_per_channel);
+    }
+
+    // Image row y has already been converted to the noodle buffer,
+    // so results can be written straight back into it.
+    if (reference) {
+      for (x = offset = 0; x < width; x++, offset += 3) { // Each column...
+        r_med = iCap_med9(&rptr[offset]);                 // 3x3 median red
+        g_med = iCap_med9(&gptr[offset]);                 // " green
+        b_med = iCap_med9(&bptr[offset]);                 // " blue
+        rgb = (r_med << 11) | (g_med << 5) | b_med;       // Recombine 565
+        *ptr++ = __builtin_bswap16(rgb);                  // back in image
+      }
+    } else {
+      uint8_t *r_out = &buf[buf_bytes_per_channel * 3]; // Median rows
+      uint8_t *g_out = &r_out[width];
+      uint8_t *b_out = &g_out[width];
+      iCap_med9_row(rptr, r_out, width);
+      iCap_med9_row(gptr, g_out, width);
+      iCap_med9_row(bptr, b_out, width);
+      for (x = 0; x < width; x++) { // Recombine 565, back in image
+        rgb = (r_out[x] << 11) | (g_out[x] << 5) | b_out[x];
+        *ptr++ = __builtin_bswap16(rgb);
+      }
+    }
+    rptr++; // Next row
+    gptr++;
+    bptr++;
+  }
+}
 
 // Detect edges in 3x3 pixel square. Evaluates difference between current
 // pixel and the four pixels above, below, left and right, sets result 'on'
 // if any of those 4 exceeds a given threshold. Note to future self: might
 // instead evaluate sum-of-four rather than any-of-four.
 static inline bool iCap_edge9(uint8_t *list, uint8_t sensitivity) {
-  int8_t center = (int16_t)list[4];                 // Must be signed!
+  int16_t center = list[4];                         // Must be signed!
   return ((abs(center - list[1]) >= sensitivity) || // left
           (abs(center - list[3]) >= sensitivity) || // up
           (abs(center - list[5]) >= sensitivity) || // down
           (abs(center - list[7]) >= sensitivity));  // right
 }
 
-// Edge detection filter. Requires a chunk of RAM temporarily,
-// ((width + 2) * 3 + height - 1) * 3 bytes, or about 3.6K for a
-// 320x240 RGB image. YUV is not currently supported.
-void Adafruit_ImageCapture::image_edges(uint8_t sensitivity) {
-  uint16_t *pixels = pixbuf[0];
+// YUV 3X3 FILTERS ----------------------------------------------------------
+
+// Median and edge detection on YUV 4:2:2 images. Same noodle buffer as
+// the RGB filters, but its three 'channels' are Y, U and V planes (see
+// iCap_filter_row_prep_yuv()), so Y is filtered at full resolution, and U
+// and V at their half horizontal resolution, each against its own nearest
+// samples. Edge detection uses Y only: output is a white-on-black edge map
+// with neutral chroma. Y has 8 bits to the RGB channels' 5, so sensitivity
+// is scaled up by 8 to behave similarly in either colorspace.
+
+// Compute one filtered row from a YUV noodle buffer (all three rows
+// loaded) into planar 'out': Y bytes, then U/V bytes in pixel order, then
+// 'width' bytes used as working space.
+static void iCap_filter_row_yuv(uint8_t *src, uint8_t *out, uint16_t width,
+                                uint32_t channel_bytes, bool edges,
+                                uint8_t sensitivity) {
+  uint8_t *chroma = &out[width];
+  uint16_t x;
+  if (edges) {
+    uint16_t s = sensitivity * 8;
+    if (s > 255) {
+      s = 255;
+    }
+    for (x = 0; x < width; x++) {
+      out[x] = iCap_edge9(&src[x * 3], s) ? 255 : 0;
+    }
+    memset(chroma, 128, width);
+  } else {
+    uint16_t u_count = (width + 1) / 2, v_count = width / 2;
+    uint8_t *u_med = &out[width * 2], *v_med = &u_med[u_count];
+    iCap_med9_row(src, out, width);
+    iCap_med9_row(&src[channel_bytes], u_med, u_count);
+    iCap_med9_row(&src[channel_bytes * 2], v_med, v_count);
+    for (x = 0; x < width; x++) { // Re-interleave U and V
+      chroma[x] = (x & 1) ? v_med[x / 2] : u_med[x / 2];
+    }
+  }
+}
+
+// Common guts of image_median() and image_edges() for YUV, with the same
+// row handling as iCap_median(). 'buf' is iCap_median_bytes() of working
+// space.
+static void iCap_filter_yuv(uint16_t *pixels, uint8_t *buf, uint16_t width,
+                            uint16_t height, bool edges,
+                            uint8_t sensitivity) {
+  uint32_t channel_bytes = iCap_noodle_bytes(width, height);
+  uint8_t *ptr = buf;                     // -> Y plane, U & V follow
+  uint8_t *out = &buf[channel_bytes * 3]; // Filtered row, planar
+  uint8_t *dst = (uint8_t *)pixels;       // Dest pointer, back into image
+  uint16_t x, y;
 
+  // Initial 'current' (1) row, copied to prior (0), as for RGB
+  iCap_filter_row_prep_yuv(pixels, &ptr[1], width, channel_bytes);
+  iCap_filter_row_copy(&ptr[1], ptr, width + 2, channel_bytes);
+
+  for (y = 0; y < height; y++) { // For each row of image...
+    if (y < (height - 1)) {      // Set up 'below' row buffer...
+      iCap_filter_row_prep_yuv(&pixels[(y + 1) * width], &ptr[2], width,
+                               channel_bytes);
+    } else { // Last row, repeat current row
+      iCap_filter_row_copy(&ptr[1], &ptr[2], width + 2, channel_bytes);
+    }
+    iCap_filter_row_yuv(ptr, out, width, channel_bytes, edges, sensitivity);
+    for (x = 0; x < width; x++) { // Re-pack row back into image
+      *dst++ = out[x];
+      *dst++ = out[width + x];
+    }
+    ptr++; // Next row
+  }
+}
+
+// 3x3 median filter for noise reduction. Even with Clever Optimizations(tm)
+// this is a tad slow, it's just the nature of the thing...lots and lots and
+// lots of pixel comparisons. YUV is handled by iCap_filter_yuv() above.
+iCap_status Adafruit_ImageCapture::image_median() {
+  if (bitsPerPixel(colorspace) < 16) { // Y8 capture, others unsupported
+    return image_median(compactY8());
+  }
   if (colorspace == ICAP_COLOR_RGB565) {
-    uint8_t *buf;
-    uint32_t buf_bytes_per_channel = (_width + 2) * 3 + _height - 1;
-    if ((buf = (uint8_t *)malloc(buf_bytes_per_channel * 3))) {
-      uint8_t *rptr = buf;                          // -> red buffer
-      uint8_t *gptr = &rptr[buf_bytes_per_channel]; // -> green buffer
-      uint8_t *bptr = &gptr[buf_bytes_per_channel]; // -> blue buffer
-
-      // For each of the three channel pointers (rptr, gptr, bptr),
-      // ptr[0] is the first pixel of the row ABOVE the current one,
-      // ptr[1] is the first pixel of the current row (0 to height-1),
-      // ptr[2] is the first pixel of the row BELOW the current one.
-      // Horizontal pixel addresses then increment by 3's...for each
-      // column (x) in row, pixel x = ptr[x * 3 + n], where n is 0, 1, 2
-      // for the above, current, and below rows, respectively.
-
-      // Convert pixel data into the initial 'current' (1) row buf
-      iCap_filter_row_prep(pixels, &rptr[1], _width, buf_bytes_per_channel);
-
-      // Copy pixel data from the initial (1) row to the prior (0) row buf
-      // (Because edge pixels are repeated so we can 3x3 filter full image)
-      iCap_filter_row_copy(&rptr[1], rptr, _width + 2, buf_bytes_per_channel);
-
-      uint8_t s2 = sensitivity * 2; // Because green has extra bit
-
-      uint16_t *ptr = pixels; // Dest pointer, back into source image
-      uint16_t x, y, offset, rgb;
-      for (y = 0; y < _height; y++) { // For each row of image...
-        // Set up 'below' row buffer...
-        if (y < (_height - 1)) { // If current row is 0 to height-2
-          // Convert pixel data into the 'next' (2) row buf
-          iCap_filter_row_prep(&pixels[(y + 1) * _width], &rptr[2], _width,
-                               buf_bytes_per_channel);
-        } else { // Last row, y = height-1
-          // Copy pixel data from current (1) row to next (2) row buf
-          // (Edge pixels are repeated so we can 3x3 filter full image)
-          iCap_filter_row_copy(&rptr[1], &rptr[2], _width + 2,
-                               buf_bytes_per_channel);
-        }
+    uint8_t *buf = scratchGet(iCap_median_bytes(_width, _height));
+    if (!buf) {
+      return ICAP_STATUS_ERR_MALLOC;
+    }
+    iCap_median(getBuffer(), buf, _width, _height, false);
+  } else { // YUV
+    uint8_t *buf = scratchGet(iCap_median_bytes(_width, _height));
+    if (!buf) {
+      return ICAP_STATUS_ERR_MALLOC;
+    }
+    iCap_filter_yuv(getBuffer(), buf, _width, _height, false, 0);
+  }
+  return ICAP_STATUS_OK;
+}
 
-        for (x = offset = 0; x < _width; x++, offset += 3) {
-          rgb = ((iCap_edge9(&rptr[offset], sensitivity) * 0xF800) |
-                 (iCap_edge9(&gptr[offset], s2) * 0x07E0) |
-                 (iCap_edge9(&bptr[offset], sensitivity) * 0x001F));
-          *ptr++ = __builtin_bswap16(rgb);
-        }
-        rptr++; // Next row
-        gptr++;
-        bptr++;
+// Original selection-based median, same output as image_median() but
+// slower. Kept as a known-good reference for checking optimizations.
+iCap_status Adafruit_ImageCapture::image_median_reference() {
+  if (colorspace == ICAP_COLOR_RGB565) {
+    uint8_t *buf = scratchGet(iCap_median_bytes(_width, _height));
+    if (!buf) {
+      return ICAP_STATUS_ERR_MALLOC;
+    }
+    iCap_median(getBuffer(), buf, _width, _height, true);
+  }
+  return ICAP_STATUS_OK;
+}
+
+// EDGE DETECTION -----------------------------------------------------------
+
+// Edge detection borrows a lot of code from the median function above...
+// same peculiar looped image format, primary change is just the function
+// called in the per-pixel loop.
+
+// Edge detection filter. Uses ((width + 2) * 3 + height - 1) * 3 bytes of
+// the scratch arena, or about 3.6K for a 320x240 RGB image (YUV, via
+// iCap_filter_yuv(), needs iCap_median_bytes()).
+iCap_status Adafruit_ImageCapture::image_edges(uint8_t sensitivity) {
+  if (bitsPerPixel(colorspace) < 16) { // Y8 capture, others unsupported
+    return image_edges(compactY8(), sensitivity);
+  }
+  uint16_t *pixels = getBuffer();
+
+  if (colorspace == ICAP_COLOR_RGB565) {
+    uint32_t buf_bytes_per_channel = iCap_noodle_bytes(_width, _height);
+    uint8_t *buf = scratchGet(buf_bytes_per_channel * 3);
+    if (!buf) {
+      return ICAP_STATUS_ERR_MALLOC;
+    }
+    uint8_t *rptr = buf;                          // -> red buffer
+    uint8_t *gptr = &rptr[buf_bytes_per_channel]; // -> green buffer
+    uint8_t *bptr = &gptr[buf_bytes_per_channel]; // -> blue buffer
+
+    // For each of the three channel pointers (rptr, gptr, bptr),
+    // ptr[0] is the first pixel of the row ABOVE the current one,
+    // ptr[1] is the first pixel of the current row (0 to height-1),
+    // ptr[2] is the first pixel of the row BELOW the current one.
+    // Horizontal pixel addresses then increment by 3's...for each
+    // column (x) in row, pixel x = ptr[x * 3 + n], where n is 0, 1, 2
+    // for the above, current, and below rows, respectively.
+
+    // Convert pixel data into the initial 'current' (1) row buf
+    iCap_filter_row_prep(pixels, &rptr[1], _width, buf_bytes_per_channel);
+
+    // Copy pixel data from the initial (1) row to the prior (0) row buf
+    // (Because edge pixels are repeated so we can 3x3 filter full image)
+    iCap_filter_row_copy(&rptr[1], rptr, _width + 2, buf_bytes_per_channel);
+
+    uint8_t s2 = sensitivity * 2; // Because green has extra bit
+
+    uint16_t *ptr = pixels; // Dest pointer, back into source image
+    uint16_t x, y, offset, rgb;
+    for (y = 0; y < _height; y++) { // For each row of image...
+      // Set up 'below' row buffer...
+      if (y < (_height - 1)) { // If current row is 0 to height-2
+        // Convert pixel data into the 'next' (2) row buf
+        iCap_filter_row_prep(&pixels[(y + 1) * _width], &rptr[2], _width,
+                             buf_bytes_per_channel);
+      } else { // Last row, y = height-1
+        // Copy pixel data from current (1) row to next (2) row buf
+        // (Edge pixels are repeated so we can 3x3 filter full image)
+        iCap_filter_row_copy(&rptr[1], &rptr[2], _width + 2,
+                             buf_bytes_per_channel);
       }
 
-      free(buf);
+      for (x = offset = 0; x < _width; x++, offset += 3) {
+        rgb = ((iCap_edge9(&rptr[offset], sensitivity) * 0xF800) |
+               (iCap_edge9(&gptr[offset], s2) * 0x07E0) |
+               (iCap_edge9(&bptr[offset], sensitivity) * 0x001F));
+        *ptr++ = __builtin_bswap16(rgb);
+      }
+      rptr++; // Next row
+      gptr++;
+      bptr++;
     }
   } else { // YUV
-    // Not yet supported. Tricky because of alternating U/V pixels.
+    uint8_t *buf = scratchGet(iCap_median_bytes(_width, _height));
+    if (!buf) {
+      return ICAP_STATUS_ERR_MALLOC;
+    }
+    iCap_filter_yuv(pixels, buf, _width, _height, true, sensitivity);
   }
+  return ICAP_STATUS_OK;
+}
+
+// Y (low byte of each lane) to RGB565, in the swapped lane layout: red is
+// the top 5 bits of Y, green the top 6, blue the top 5.
+static inline iCap_word iCap_y2rgb565(iCap_word w) {
+  iCap_word y = w & ICAP_REP16(0x00FF);
+  iCap_word hi = (y & ICAP_REP16(0xF8)) | ((y >> 5) & ICAP_REP16(0x07));
+  iCap_word lo = ((y << 3) & ICAP_REP16(0xE0)) | ((y >> 3) & ICAP_REP16(0x1F));
+  return hi | (lo << 8); // hi = R, G bits 5-3; lo = G bits 2-0, B
 }
 
 // Reformat YUV gray component to RGB565 for TFT preview.
 // Big-endian in and out.
 void Adafruit_ImageCapture::Y2RGB565() {
-  uint16_t *pixels = pixbuf[0];
-  uint32_t len = _width * _height;
-  while (len--) {
-    uint8_t y = *pixels & 0xFF; // Y (brightness) component of YUV
-    uint16_t rgb = ((y >> 3) * 0x801) | ((y & 0xFC) << 3); // to RGB565
-    *pixels++ = __builtin_bswap16(rgb); // Big-endianify RGB565 for TFT
+  if (bitsPerPixel(colorspace) < 16) {
+    return; // Buffer is too small to expand in place
+  }
+  uint16_t *pixels = getBuffer();
+  uint32_t num_pixels = _width * _height;
+  ICAP_SWAR_LOOP(pixels, num_pixels, iCap_y2rgb565(w));
+}
+
+// Full-color YUV to RGB565, JFIF (full range BT.601) coefficients in 16.16
+// fixed point:
+//   R = Y + 1.402 (V - 128)
+//   G = Y - 0.344136 (U - 128) - 0.714136 (V - 128)
+//   B = Y + 1.772 (U - 128)
+// The chroma terms are precomputed into four tables of 256 int16_t, so each
+// U/V pair costs four lookups, shared by the two pixels of that pair. Three
+// more tables, indexed by Y plus chroma term (-256 to 511), clamp to 0-255
+// and return that channel's bits already in big-endian RGB565 position, so
+// per pixel it's three adds, three lookups and two ORs with no branches
+// (random chroma makes clamp branches unpredictable). All of this is about
+// 6.5K in the scratch arena. Rows are handled separately (U on even pixels,
+// as elsewhere); an odd width's last pixel has no V and uses neutral 128.
+iCap_status Adafruit_ImageCapture::YUV2RGB565(uint16_t *dst) {
+  if ((colorspace != ICAP_COLOR_YUV) &&
+      ((colorspace != ICAP_COLOR_Y8) || !dst)) { // Y8 can't be in place
+    return ICAP_STATUS_ERR_PERIPHERAL;
+  }
+  if (colorspace == ICAP_COLOR_Y8) { // Gray, no tables needed
+    const uint8_t *src = (const uint8_t *)getBuffer();
+    uint32_t num_pixels = _width * _height;
+    for (uint32_t i = 0; i < num_pixels; i++) {
+      uint8_t k = src[i];
+      dst[i] = __builtin_bswap16(((k & 0xF8) << 8) | ((k & 0xFC) << 3) |
+                                 (k >> 3));
+    }
+    return ICAP_STATUS_OK;
+  }
+  int16_t *rv = (int16_t *)scratchGet((4 * 256 + 3 * 768) * sizeof(int16_t));
+  if (!rv) {
+    return ICAP_STATUS_ERR_MALLOC;
+  }
+  int16_t *gu = &rv[256], *gv = &gu[256], *bu = &gv[256];
+  uint16_t *r565 = (uint16_t *)&bu[256] + 256; // Valid from -256 to 511
+  uint16_t *g565 = &r565[768], *b565 = &g565[768];
+  for (int16_t c = -256; c < 512; c++) { // Clamp & pack tables
+    uint8_t k = (c < 0) ? 0 : (c > 255) ? 255 : c;
+    r565[c] = __builtin_bswap16((k & 0xF8) << 8);
+    g565[c] = __builtin_bswap16((k & 0xFC) << 3);
+    b565[c] = __builtin_bswap16(k >> 3);
+  }
+  for (int16_t c = 0; c < 256; c++) { // Chroma tables, rounded
+    rv[c] = (91881 * (c - 128) + 32768) >> 16;
+    gu[c] = (-22554 * (c - 128) + 32768) >> 16;
+    gv[c] = (-46802 * (c - 128) + 32768) >> 16;
+    bu[c] = (116130 * (c - 128) + 32768) >> 16;
   }
+
+  const uint8_t *src = (const uint8_t *)getBuffer();
+  if (!dst) {
+    dst = getBuffer(); // In place, each pair is read before it's written
+  }
+  uint16_t pairs = _width / 2, x, y;
+  for (y = 0; y < _height; y++) {
+    for (x = 0; x < pairs; x++, src += 4, dst += 2) {
+      int16_t dr = rv[src[3]], dg = gu[src[1]] + gv[src[3]], db = bu[src[1]];
+      int16_t y0 = src[0], y1 = src[2];
+      dst[0] = r565[y0 + dr] | g565[y0 + dg] | b565[y0 + db];
+      dst[1] = r565[y1 + dr] | g565[y1 + dg] | b565[y1 + db];
+    }
+    if (_width & 1) { // Odd width: half pair, no V
+      int16_t y0 = src[0], u = src[1];
+      *dst++ = r565[y0] | g565[y0 + gu[u]] | b565[y0 + bu[u]];
+      src += 2;
+    }
+  }
+  return ICAP_STATUS_OK;
+}
+
+// 8-BIT GRAYSCALE (Y8) -----------------------------------------------------
+
+// compactY8() packs an image down to one luma byte per pixel, in place,
+// after which the Y8 variants of the image_* functions touch half the
+// bytes of their 16-bit counterparts. Point operations run the SWAR loop
+// over pixel pairs, with one table for every byte where a table's needed.
+// The 3x3 filters use a single noodle channel (see median notes) and
+// write each result row straight back into the image, since the noodle
+// buffer already holds copies of the rows still needed.
+
+// Y bytes (low byte of each lane) of a word of YUV pixels, packed into
+// the low half of the word.
+static inline iCap_word iCap_pack_y8(iCap_word w) {
+  w &= ICAP_REP16(0x00FF);
+  w |= w >> 8;                 // Y pairs at bottom of each 32 bits
+  if (sizeof(iCap_word) > 4) { // (Split shift is legal for 32-bit words)
+    w = (w & 0xFFFF) | (((w >> 16) >> 16) << 16);
+  }
+  return w;
+}
+
+// Applies expression 'op' (as for ICAP_SWAR_LOOP) to a Y8 plane: the
+// 16-bit-aligned span as packed pixel pairs, plus any odd leading or
+// trailing pixel alone (in the low byte of 'w', result's low byte kept).
+#define ICAP_Y8_LOOP(pixels, num_pixels, op)                                  \
+  {                                                                            \
+    uint8_t *b8 = pixels;                                                      \
+    uint32_t n8 = num_pixels;                                                  \
+    iCap_word w;                                                               \
+    if (n8 && ((uintptr_t)b8 & 1)) {                                           \
+      w = *b8;                                                                 \
+      *b8++ = (op);                                                            \
+      n8--;                                                                    \
+    }                                                                          \
+    uint16_t *p16 = (uint16_t *)b8;                                            \
+    uint32_t n16 = n8 / 2;                                                     \
+    ICAP_SWAR_LOOP(p16, n16, op);                                              \
+    if (n8 & 1) {                                                              \
+      w = b8[n8 - 1];                                                          \
+      b8[n8 - 1] = (op);                                                       \
+    }                                                                          \
+  }
+
+iCap_view Adafruit_ImageCapture::compactY8(void) {
+  uint16_t *pixels = getBuffer();
+  uint8_t *dst = (uint8_t *)pixels; // Each write is behind all reads to come
+  uint32_t i, num_pixels = _width * _height;
+  if (colorspace == ICAP_COLOR_YUV) { // Keep Y bytes, a word at a time
+    uint32_t head = iCap_word_head(pixels, num_pixels);
+    uint32_t words = (num_pixels - head) / ICAP_WORD_PIXELS;
+    iCap_word *wp = (iCap_word *)&pixels[head];
+    for (i = 0; i < head; i++) {
+      dst[i] = dst[i * 2];
+    }
+    for (i = 0; i < words; i++) {
+      iCap_word y = iCap_pack_y8(wp[i]);
+      memcpy(&dst[head + i * ICAP_WORD_PIXELS], &y, ICAP_WORD_PIXELS);
+    }
+    for (i = head + words * ICAP_WORD_PIXELS; i < num_pixels; i++) {
+      dst[i] = dst[i * 2];
+    }
+  } else if (colorspace == ICAP_COLOR_RGB565) {
+    // BT.601 luma, 0.299 R + 0.587 G + 0.114 B, with weights here in 8.8
+    // fixed point pre-scaled for 5- and 6-bit channels. Pixels are read
+    // in the swapped lane layout (see SWAR notes above).
+    for (i = 0; i < num_pixels; i++) {
+      uint16_t p = pixels[i]; // GGGBBBBB RRRRRGGG
+      uint16_t r = (p >> 3) & 31, g = ((p & 7) << 3) | (p >> 13);
+      uint16_t b = (p >> 8) & 31;
+      dst[i] = (r * 630 + g * 608 + b * 240 + 128) >> 8;
+    }
+  } // Else already Y8, or a format that isn't converted (kept in view)
+  iCap_view view = {dst, _width, _height,
+                    (bitsPerPixel(colorspace) < 16) ? colorspace
+                                                     : ICAP_COLOR_Y8};
+  return view;
+}
+
+void Adafruit_ImageCapture::image_negative(const iCap_view &view) {
+  if (view.space == ICAP_COLOR_Y8) {
+    ICAP_Y8_LOOP(view.pixels, (uint32_t)view.width * view.height, ~w);
+  }
+}
+
+void Adafruit_ImageCapture::image_threshold(const iCap_view &view,
+                                            uint8_t threshold) {
+  if (view.space == ICAP_COLOR_Y8) {
+    uint8_t table[256];
+    for (uint16_t i = 0; i < 256; i++) {
+      table[i] = (i >= threshold) ? 255 : 0;
+    }
+    ICAP_Y8_LOOP(view.pixels, (uint32_t)view.width * view.height,
+                 iCap_yuv_lut_word(w, table, table));
+  }
+}
+
+void Adafruit_ImageCapture::image_posterize(const iCap_view &view,
+                                            uint8_t levels) {
+  if ((view.space == ICAP_COLOR_Y8) && (levels < 255)) {
+    uint8_t table[256];
+    for (uint16_t i = 0; i < 256; i++) {
+      table[i] = iCap_posterize_level(i, (levels < 2) ? 2 : levels, 256);
+    }
+    ICAP_Y8_LOOP(view.pixels, (uint32_t)view.width * view.height,
+                 iCap_yuv_lut_word(w, table, table));
+  }
+}
+
+iCap_status Adafruit_ImageCapture::image_mosaic(const iCap_view &view,
+                                                uint8_t tile_width,
+                                                uint8_t tile_height) {
+  return mosaic(view.pixels, view.width, view.height, view.space, tile_width,
+                tile_height);
+}
+
+// Common guts of the Y8 image_median() and image_edges(), with the same
+// row handling as iCap_median(). 'buf' is iCap_noodle_bytes() of working
+// space. Sensitivity is scaled as for YUV.
+static void iCap_filter_y8(uint8_t *pixels, uint8_t *buf, uint16_t width,
+                           uint16_t height, bool edges,
+                           uint8_t sensitivity) {
+  uint16_t s = sensitivity * 8, x, y;
+  if (s > 255) {
+    s = 255;
+  }
+  // Initial 'current' (1) row, duplicated in prior (0) row
+  iCap_noodle_load(pixels, 1, width, &buf[1]);
+  iCap_noodle_load(pixels, 1, width, buf);
+
+  for (y = 0; y < height; y++, buf++) { // For each row of image...
+    uint8_t *row = &pixels[y * width];
+    // Set up 'below' row (last row repeats current row)
+    iCap_noodle_load((y < (height - 1)) ? &row[width] : row, 1, width,
+                     &buf[2]);
+    if (edges) {
+      for (x = 0; x < width; x++) {
+        row[x] = iCap_edge9(&buf[x * 3], s) ? 255 : 0;
+      }
+    } else {
+      iCap_med9_row(buf, row, width);
+    }
+  }
+}
+
+iCap_status Adafruit_ImageCapture::image_median(const iCap_view &view) {
+  if (view.space == ICAP_COLOR_Y8) {
+    uint8_t *buf = scratchGet(iCap_noodle_bytes(view.width, view.height));
+    if (!buf) {
+      return ICAP_STATUS_ERR_MALLOC;
+    }
+    iCap_filter_y8(view.pixels, buf, view.width, view.height, false, 0);
+  }
+  return ICAP_STATUS_OK;
+}
+
+iCap_status Adafruit_ImageCapture::image_edges(const iCap_view &view,
+                                               uint8_t sensitivity) {
+  if (view.space == ICAP_COLOR_Y8) {
+    uint8_t *buf = scratchGet(iCap_noodle_bytes(view.width, view.height));
+    if (!buf) {
+      return ICAP_STATUS_ERR_MALLOC;
+    }
+    iCap_filter_y8(view.pixels, buf, view.width, view.height, true,
+                   sensitivity);
+  }
+  return ICAP_STATUS_OK;
+}
+
+// BAYER DEMOSAIC -----------------------------------------------------------
+
+// Raw Bayer (BGGR: B G B G... rows alternating with G R G R...) to RGB565
+// or Y8 by bilinear interpolation, in 8-bit integer math. Rows stream
+// through the same three-row noodle buffer as the 3x3 filters (see
+// iCap_filter_y8()), so the 3x3 neighborhood of pixel x is &buf[x * 3],
+// column-major. At a B or R site, G is the mean of the four orthogonal
+// neighbors and the other color the mean of the four diagonals; at a G
+// site, the horizontal pair gives that row's color and the vertical pair
+// the other. Image edges are mirrored rather than duplicated so that every
+// neighbor keeps the right color.
+
+// Load one Bayer row into the noodle buffer with mirrored edge pixels
+static void iCap_noodle_load_bayer(const uint8_t *src, uint16_t width,
+                                   uint8_t *dst) {
+  iCap_noodle_load(src, 1, width, dst);
+  dst[0] = dst[6];                             // Pixel 1 left of pixel 0
+  dst[(width + 1) * 3] = dst[(width - 1) * 3]; // Pixel width-2 at right
+}
+
+// Demosaic one row from the noodle buffer to either RGB565 (dst565, if
+// non-NULL) or BT.601 luma (dst8, may be the source row itself).
+static void iCap_demosaic_row(const uint8_t *n, uint16_t width, bool odd_row,
+                              uint16_t *dst565, uint8_t *dst8) {
+  for (uint16_t x = 0; x < width; x++, n += 3) {
+    uint8_t r, g, b;
+    if ((x & 1) == odd_row) { // B site (even row) or R site (odd row)
+      uint8_t c = n[4], o = (n[0] + n[2] + n[6] + n[8] + 2) >> 2;
+      g = (n[1] + n[3] + n[5] + n[7] + 2) >> 2;
+      r = odd_row ? c : o;
+      b = odd_row ? o : c;
+    } else { // G site
+      uint8_t h = (n[1] + n[7] + 1) >> 1, v = (n[3] + n[5] + 1) >> 1;
+      g = n[4];
+      r = odd_row ? h : v;
+      b = odd_row ? v : h;
+    }
+    if (dst565) {
+      dst565[x] = __builtin_bswap16(((r & 0xF8) << 8) | ((g & 0xFC) << 3) |
+                                    (b >> 3));
+    } else {
+      dst8[x] = (r * 77 + g * 150 + b * 29 + 128) >> 8;
+    }
+  }
+}
+
+// Common guts of demosaicRGB565() and demosaicY8(), 'buf' is
+// iCap_noodle_bytes() of working space. With dst565 NULL, Y8 is written
+// over the Bayer image; each row is in the noodle buffer before that.
+static void iCap_demosaic(uint8_t *pixels, uint8_t *buf, uint16_t width,
+                          uint16_t height, uint16_t *dst565) {
+  // Initial 'current' (1) row, with row 1 mirrored into the prior (0) row
+  iCap_noodle_load_bayer(pixels, width, &buf[1]);
+  iCap_noodle_load_bayer(&pixels[width], width, buf);
+
+  for (uint16_t y = 0; y < height; y++, buf++) { // For each row of image...
+    uint8_t *row = &pixels[y * width];
+    if (y < (height - 1)) { // Set up 'below' row...
+      iCap_noodle_load_bayer(&row[width], width, &buf[2]);
+    } else { // ...last row mirrors the one above (maybe already Y8 now)
+      for (uint16_t x = 0; x < width + 2; x++) {
+        buf[x * 3 + 2] = buf[x * 3];
+      }
+    }
+    iCap_demosaic_row(buf, width, y & 1, dst565 ? &dst565[y * width] : NULL,
+                      row);
+  }
+}
+
+iCap_status Adafruit_ImageCapture::demosaicRGB565(uint16_t *dst) {
+  if (dst && (colorspace == ICAP_COLOR_BAYER) && (_width > 1) &&
+      (_height > 1)) {
+    uint8_t *buf = scratchGet(iCap_noodle_bytes(_width, _height));
+    if (!buf) {
+      return ICAP_STATUS_ERR_MALLOC;
+    }
+    iCap_demosaic((uint8_t *)getBuffer(), buf, _width, _height, dst);
+  }
+  return ICAP_STATUS_OK;
+}
+
+iCap_status Adafruit_ImageCapture::demosaicY8(iCap_view *view) {
+  uint8_t *pixels = (uint8_t *)getBuffer();
+  if ((colorspace == ICAP_COLOR_BAYER) && (_width > 1) && (_height > 1)) {
+    uint8_t *buf = scratchGet(iCap_noodle_bytes(_width, _height));
+    if (!buf) {
+      return ICAP_STATUS_ERR_MALLOC;
+    }
+    iCap_demosaic(pixels, buf, _width, _height, NULL);
+    if (view) {
+      iCap_view y8 = {pixels, _width, _height, ICAP_COLOR_Y8};
+      *view = y8;
+    }
+  }
+  return ICAP_STATUS_OK;
+}
+
+// IMAGE PIPELINE -----------------------------------------------------------
+
+// image_pipeline() applies a chain of the above effects in one pass. The
+// stage list is first translated into 'steps':
+// - Each run of consecutive point operations (negative, threshold,
+//   posterize, Y2RGB565) is composed into a single lookup table step,
+//   one 256-entry table per channel, so a run of any length costs one
+//   lookup per channel per pixel.
+// - Each 3x3 operation (median, edges) is a step with its own noodle
+//   buffer (see median notes above) and a one-row result buffer.
+// Image rows are then decoded into planar 8-bit channels (red, green, blue
+// for RGB565; the two bytes, Y and U/V, for YUV) and pushed through steps.
+// A 3x3 step holds back one row (it needs the row below before it can
+// produce a result), so output trails input by one row per 3x3 step and
+// is written back in place only after its source rows have been read.
+// For YUV, 3x3 steps filter Y, U and V planes as the standalone YUV
+// filters do (see above).
+// The last rows are flushed through the chain (edge row duplicated, as
+// the standalone filters do) once all input is consumed.
+
+typedef enum {
+  ICAP_STEP_LUT = 0, // Per-channel lookup table
+  ICAP_STEP_PACK_Y,  // RGB565 to 'Y' the way Y2RGB565() reads it
+  ICAP_STEP_MEDIAN,  // 3x3 median
+  ICAP_STEP_EDGES,   // 3x3 edge detect
+} iCap_step_type;
+
+typedef struct {
+  uint8_t type;   // iCap_step_type
+  uint8_t param;  // Edge sensitivity
+  uint8_t src[3]; // LUT: source channel of each output channel, <= itself
+  uint16_t rows;  // 3x3: rows received so far
+  uint8_t *buf;   // LUT: 3 x 256 tables; 3x3: noodle buf, advances by row
+  uint8_t *out;   // 3x3: result row, 3 channels
+} iCap_pipe_step;
+
+typedef struct {
+  iCap_pipe_step *steps;  // NULL when only counting (see compile)
+  uint8_t *mem;           // Next free byte for step buffers
+  uint16_t *pixels;       // Image being processed
+  uint32_t channel_bytes; // Noodle buffer size per channel
+  uint32_t out_row;       // Next image row to be written
+  uint16_t width;         // Image width in pixels
+  uint16_t num_steps;     // Number of steps
+  uint16_t num_run;       // Steps run on rows (last LUT folds into output)
+  uint16_t num_luts;      // How many of those are ICAP_STEP_LUT
+  uint16_t num_3x3s;      // And how many ICAP_STEP_MEDIAN/EDGES
+  bool rgb;               // RGB565 image (else YUV)
+} iCap_pipe;
+
+// Output value of one point operation on one channel value v, for a
+// channel of 'bits' depth (5 or 6 for RGB565, 8 for YUV), 'chroma' set for
+// YUV's U/V channel. Same math as the standalone functions, one channel
+// at a time.
+static uint8_t iCap_point(uint8_t op, uint8_t param, uint8_t bits,
+                          bool chroma, uint8_t v) {
+  uint8_t max = (1 << bits) - 1; // 31, 63 or 255
+  switch (op) {
+  case ICAP_OP_NEGATIVE:
+    return max - v;
+  case ICAP_OP_THRESHOLD:
+    if (chroma) {
+      return iCap_threshold_chroma(v, param);
+    }
+    return (v >= (param >> (8 - bits))) ? max : 0;
+  case ICAP_OP_POSTERIZE:
+    if (param < 2) {
+      param = 2;
+    }
+    if (bits == 8) {
+      if (param == 255) {
+        return v;
+      }
+      return chroma ? iCap_posterize_chroma(v, param)
+                    : iCap_posterize_level(v, param, 256);
+    } else if (param >= 32) {
+      return v;
+    } else if (bits == 6) { // Green, posterized as 5 bits then expanded
+      uint8_t g = iCap_posterize_level(v >> 1, param, 32);
+      return (g << 1) | (g >> 4);
+    }
+    return iCap_posterize_level(v, param, 32);
+  }
+  return v;
+}
+
+// Output value of Y2RGB565 for channel c, given Y. For RGB images (where Y
+// is the first byte of each pixel, see ICAP_STEP_PACK_Y) that's the 5/6/5
+// bit red, green or blue; for YUV, the first or second byte of RGB565.
+static uint8_t iCap_y2rgb(uint8_t c, bool rgb, uint8_t y) {
+  if (rgb) {
+    return y >> ((c == 1) ? 2 : 3); // 6 bits green, 5 red & blue
+  }
+  return c ? (((y << 3) & 0xE0) | (y >> 3)) : ((y & 0xF8) | (y >> 5));
+}
+
+// Compose a point operation onto the end of a LUT step. In 'rgb' space
+// channels are 5/6/5 bits, otherwise the two 8-bit bytes of each pixel.
+// As with the standalone functions, the image colorspace setting applies
+// throughout, even after Y2RGB565. Channel sources only ever point to the
+// same or a lower channel, which lets tables (and rows, later) update in
+// place when processed in descending channel order.
+static void iCap_pipe_compose(iCap_pipe_step *step, uint8_t op,
+                              uint8_t param, bool rgb) {
+  for (uint8_t c = 3; c--;) {
+    uint8_t s = (op == ICAP_OP_Y2RGB565) ? 0 : c; // Input channel
+    uint8_t *dst = &step->buf[c * 256], *in = &step->buf[s * 256];
+    for (uint16_t v = 0; v < 256; v++) {
+      if (op == ICAP_OP_Y2RGB565) {
+        dst[v] = iCap_y2rgb(c, rgb, in[v]);
+      } else {
+        dst[v] = iCap_point(op, param, rgb ? ((c == 1) ? 6 : 5) : 8,
+                            !rgb && (c == 1), in[v]);
+      }
+    }
+    step->src[c] = step->src[s];
+  }
+}
+
+// Translate stages to steps. Called twice: once with p->steps NULL just
+// to count steps and buffers, then again with memory to fill them in.
+static void iCap_pipe_compile(iCap_pipe *p, const iCap_pipeline_stage *stages,
+                              uint8_t num_stages) {
+  bool rgb = p->rgb;
+  bool lut_open = false; // If set, last step is a LUT to compose onto
+  p->num_steps = p->num_luts = p->num_3x3s = 0;
+  for (uint8_t i = 0; i < num_stages; i++) {
+    uint8_t op = stages[i].op, param = stages[i].param;
+    iCap_pipe_step *step = p->steps ? &p->steps[p->num_steps] : NULL;
+    if ((op == ICAP_OP_MEDIAN) || (op == ICAP_OP_EDGES)) {
+      if (step) {
+        step->type =
+            (op == ICAP_OP_MEDIAN) ? ICAP_STEP_MEDIAN : ICAP_STEP_EDGES;
+        step->param = param;
+        step->rows = 0;
+        step->buf = p->mem;
+        p->mem += p->channel_bytes * 3;
+        step->out = p->mem;
+        p->mem += p->width * 3;
+      }
+      p->num_steps++;
+      p->num_3x3s++;
+      lut_open = false;
+    } else if (op <= ICAP_OP_Y2RGB565) { // Point operation
+      if ((op == ICAP_OP_Y2RGB565) && rgb) {
+        // Y2RGB565() on RGB data takes the first byte of each pixel as Y
+        if (step) {
+          step++->type = ICAP_STEP_PACK_Y;
+        }
+        p->num_steps++;
+        lut_open = false;
+      }
+      if (!lut_open) { // Start a new LUT step, initially identity
+        if (step) {
+          step->type = ICAP_STEP_LUT;
+          step->buf = p->mem;
+          p->mem += 3 * 256;
+          for (uint8_t c = 0; c < 3; c++) {
+            step->src[c] = c;
+            for (uint16_t v = 0; v < 256; v++) {
+              step->buf[c * 256 + v] = v;
+            }
+          }
+        }
+        p->num_steps++;
+        p->num_luts++;
+        lut_open = true;
+      }
+      if (p->steps) {
+        iCap_pipe_compose(&p->steps[p->num_steps - 1], op, param, rgb);
+      }
+    } // Else unrecognized op, ignored
+  }
+}
+
+// Compute one result row of a 3x3 step (all three noodle rows loaded),
+// then advance the noodle buffer to the next row. Returns result row.
+static uint8_t *iCap_pipe_3x3(iCap_pipe *p, iCap_pipe_step *step) {
+  uint16_t width = p->width;
+  for (uint8_t c = 0; p->rgb && (c < 3); c++) {
+    uint8_t *src = &step->buf[c * p->channel_bytes];
+    uint8_t *dst = &step->out[c * width];
+    if (step->type == ICAP_STEP_MEDIAN) {
+      iCap_med9_row(src, dst, width);
+    } else {
+      // Green has an extra bit, so twice the sensitivity (as in
+      // image_edges(), including 8-bit wraparound of that).
+      uint8_t sensitivity = (c == 1) ? step->param * 2 : step->param;
+      uint8_t on = (c == 1) ? 63 : 31;
+      for (uint16_t x = 0; x < width; x++) {
+        dst[x] = iCap_edge9(&src[x * 3], sensitivity) ? on : 0;
+      }
+    }
+  }
+  if (!p->rgb) {
+    iCap_filter_row_yuv(step->buf, step->out, width, p->channel_bytes,
+                        step->type == ICAP_STEP_EDGES, step->param);
+  }
+  step->buf++; // Next row
+  return step->out;
+}
+
+// Push one row through steps 'first' onward. The row is either planar (3
+// channels, p->width bytes each) or, for a 3x3 first step only, NULL with
+// 'src' pointing to the image row itself. A 3x3 step may hold the row, or
+// replace it with its own result row. Rows reaching the end are encoded
+// back into the image, through the final LUT step if there is one.
+static void iCap_pipe_run(iCap_pipe *p, uint16_t first, uint8_t *row,
+                          uint16_t *src) {
+  uint16_t x, width = p->width;
+  for (uint16_t i = first; i < p->num_run; i++) {
+    iCap_pipe_step *step = &p->steps[i];
+    if (step->type == ICAP_STEP_LUT) {
+      for (uint8_t c = 3; c--;) { // Descending, sources are <= c
+        const uint8_t *table = &step->buf[c * 256];
+        const uint8_t *in = &row[step->src[c] * width];
+        uint8_t *out = &row[c * width];
+        for (x = 0; x < width; x++) {
+          out[x] = table[in[x]];
+        }
+      }
+    } else if (step->type == ICAP_STEP_PACK_Y) {
+      for (x = 0; x < width; x++) { // Red and top 3 bits of green
+        row[x] = (row[x] << 3) | (row[width + x] >> 3);
+      }
+    } else { // 3x3
+      uint8_t *dst = &step->buf[step->rows ? 2 : 1];
+      if (!p->rgb) {
+        if (row) {
+          iCap_filter_row_load_yuv(row, dst, width, p->channel_bytes);
+        } else {
+          iCap_filter_row_prep_yuv(src, dst, width, p->channel_bytes);
+        }
+      } else if (row) {
+        iCap_filter_row_load(row, dst, width, p->channel_bytes);
+      } else {
+        iCap_filter_row_prep(src, dst, width, p->channel_bytes);
+      }
+      if (!step->rows++) {
+        // First row loads as 'current' (1) and is duplicated to 'prior'
+        // (0). No result yet, that needs the next row.
+        iCap_filter_row_copy(dst, step->buf, width + 2, p->channel_bytes);
+        return;
+      }
+      row = iCap_pipe_3x3(p, step);
+    }
+  }
+
+  uint16_t *dst = &p->pixels[p->out_row++ * width];
+  const uint8_t *in0 = row, *in1 = &row[width], *in2 = &row[width * 2];
+  if (p->num_run < p->num_steps) { // Final LUT, fold into output
+    const iCap_pipe_step *step = &p->steps[p->num_run];
+    const uint8_t *t0 = step->buf, *t1 = &t0[256], *t2 = &t1[256];
+    in1 = &row[step->src[1] * width];
+    in2 = &row[step->src[2] * width];
+    if (p->rgb) {
+      for (x = 0; x < width; x++) {
+        uint16_t rgb = (t0[in0[x]] << 11) | (t1[in1[x]] << 5) | t2[in2[x]];
+        dst[x] = __builtin_bswap16(rgb);
+      }
+    } else {
+      uint8_t *p8 = (uint8_t *)dst;
+      for (x = 0; x < width; x++) {
+        *p8++ = t0[in0[x]];
+        *p8++ = t1[in1[x]];
+      }
+    }
+  } else if (p->rgb) {
+    for (x = 0; x < width; x++) {
+      uint16_t rgb = (in0[x] << 11) | (in1[x] << 5) | in2[x];
+      dst[x] = __builtin_bswap16(rgb);
+    }
+  } else {
+    uint8_t *p8 = (uint8_t *)dst;
+    for (x = 0; x < width; x++) {
+      *p8++ = in0[x]; // Y (or first byte after Y2RGB565)
+      *p8++ = in1[x]; // U or V
+    }
+  }
+}
+
+// Pipelines of only point operations compile to a single LUT step, which
+// is applied directly to packed pixels, no row unpacking. RGB tables are
+// expanded to byte-swapped 16-bit values, as in image_posterize().
+static void iCap_pipe_points(const iCap_pipe_step *step, uint16_t *pixels,
+                             uint32_t num_pixels, bool rgb) {
+  const uint8_t *t0 = step->buf, *t1 = &t0[256], *t2 = &t1[256];
+  uint32_t i;
+  if (rgb) { // Sources are always r, g, b here (PACK_Y makes 2+ steps)
+    uint16_t rtable[32], gtable[64], btable[32], q;
+    for (i = 0; i < 64; i++) {
+      if (i < 32) {
+        rtable[i] = __builtin_bswap16(t0[i] << 11);
+        btable[i] = __builtin_bswap16(t2[i]);
+      }
+      gtable[i] = __builtin_bswap16(t1[i] << 5);
+    }
+    for (i = 0; i < num_pixels; i++) { // For each pixel...
+      q = pixels[i];                   // Swapped: GGGBBBBB RRRRRGGG
+      pixels[i] = rtable[(q >> 3) & 31] | gtable[((q & 7) << 3) | (q >> 13)] |
+                  btable[(q >> 8) & 31];
+    }
+  } else { // Second byte's source is itself, or first byte after Y2RGB565
+    uint8_t *p8 = (uint8_t *)pixels, s1 = step->src[1], b1;
+    for (i = 0; i < num_pixels; i++, p8 += 2) {
+      b1 = t1[p8[s1]];
+      p8[0] = t0[p8[0]];
+      p8[1] = b1;
+    }
+  }
+}
+
+iCap_status
+Adafruit_ImageCapture::image_pipeline(const iCap_pipeline_stage *stages,
+                                      uint8_t num_stages) {
+  if (bitsPerPixel(colorspace) < 16) {
+    return ICAP_STATUS_OK; // Not supported, use the Y8 image_* functions
+  }
+  iCap_pipe p;
+  p.steps = NULL;
+  p.rgb = (colorspace == ICAP_COLOR_RGB565);
+  p.width = _width;
+  p.channel_bytes = iCap_noodle_bytes(_width, _height);
+  iCap_pipe_compile(&p, stages, num_stages); // Count steps & buffers
+  if (!p.num_steps) {
+    return ICAP_STATUS_OK; // Nothing to do
+  }
+
+  // Scratch arena holds everything: steps, then tables, noodle buffers
+  // and result rows, then the input row.
+  uint32_t row_bytes = _width * 3;
+  uint32_t step_bytes = p.num_steps * sizeof(iCap_pipe_step);
+  uint8_t *buf =
+      scratchGet(step_bytes + p.num_luts * 3 * 256 +
+                 p.num_3x3s * (p.channel_bytes * 3 + row_bytes) + row_bytes);
+  if (!buf) {
+    return ICAP_STATUS_ERR_MALLOC;
+  }
+  p.steps = (iCap_pipe_step *)buf;
+  p.mem = &buf[step_bytes];
+  iCap_pipe_compile(&p, stages, num_stages); // Fill in steps
+  uint8_t *row = p.mem;                      // Input row is last
+
+  uint16_t *pixels = getBuffer();
+  if ((p.num_steps == 1) && (p.steps[0].type == ICAP_STEP_LUT)) {
+    iCap_pipe_points(p.steps, pixels, _width * _height, p.rgb);
+    return ICAP_STATUS_OK;
+  }
+
+  // A trailing LUT step is applied while encoding rows, not separately
+  p.num_run = p.num_steps;
+  if (p.steps[p.num_steps - 1].type == ICAP_STEP_LUT) {
+    p.num_run--;
+  }
+  p.pixels = pixels;
+  p.out_row = 0;
+  bool decode = (p.steps[0].type < ICAP_STEP_MEDIAN); // Else 3x3 does it
+  for (uint16_t y = 0; y < _height; y++) { // For each row of image...
+    uint16_t x, *src = &pixels[y * _width];
+    if (!decode) {
+      iCap_pipe_run(&p, 0, NULL, src);
+    } else {
+      if (p.rgb) {
+        for (x = 0; x < _width; x++) { // Unpack to 5/6/5 bit channels
+          uint16_t rgb = __builtin_bswap16(src[x]);
+          row[x] = rgb >> 11;
+          row[_width + x] = (rgb >> 5) & 0x3F;
+          row[_width * 2 + x] = rgb & 0x1F;
+        }
+      } else {
+        uint8_t *p8 = (uint8_t *)src;
+        for (x = 0; x < _width; x++) { // Bytes, third channel unused
+          row[x] = *p8++;
+          row[_width + x] = *p8++;
+          row[_width * 2 + x] = 0;
+        }
+      }
+      iCap_pipe_run(&p, 0, row, NULL);
+    }
+  }
+
+  // Each 3x3 step still holds its last row. Flush these in order, with
+  // the last row duplicated as the one below, same as the filters above.
+  for (uint16_t i = 0; i < p.num_run; i++) {
+    iCap_pipe_step *step = &p.steps[i];
+    if ((step->type >= ICAP_STEP_MEDIAN) && step->rows) {
+      iCap_filter_row_copy(&step->buf[1], &step->buf[2], _width + 2,
+                           p.channel_bytes);
+      iCap_pipe_run(&p, i + 1, iCap_pipe_3x3(&p, step), NULL);
+    }
+  }
+
+  return ICAP_STATUS_OK;
 }
 
 #endif // end ICAP_FULL_SUPPORT
@@ -25,11 +25,28 @@ typedef enum {
   ICAP_STATUS_ERR_PERIPHERAL, ///< Peripheral (e.g. timer) not found
   ICAP_STATUS_ERR_PINS,       ///< Pin config doesn't align with peripheral(s)
   ICAP_STATUS_ERR_TIMEOUT,    ///< Function didn't complete in expected time
+  ICAP_STATUS_ERR_WRITE,      ///< Output sink accepted less than all data
 } iCap_status;
 
+/** Output for encoded data, e.g. a write to an SD File or an I2C transfer.
+    Called with successive chunks of the stream; returns the number of
+    bytes accepted (fewer than len is treated as an error). The classes
+    that feed a sink from an output block of their own (JPEG encoder,
+    file writer, recorder) are large for it (see each class for its
+    size): keep them static or global rather than on the stack. */
+typedef uint32_t (*iCap_sink)(void *context, const uint8_t *data,
+                              uint32_t len);
+
+// The encoders (JPEG, QOI, file writer) fill output through uint8_t
+// pointers, and a byte store may alias any object, including their own
+// state. So their inner loops work on copies of that state in locals
+// (cursor, bit accumulator, run length...), stored back once, rather than
+// have it reloaded after every byte written.
+
 // Must include ALL arch headers here (each has #ifdef checks for specific
 // architectures). Do this here, after the iCap_status typedef, as functions
 // declared in these headers may rely on that.
+#include "arch/host.h"
 #include "arch/rp2040.h"
 #include "arch/samd51.h"
 
@@ -48,6 +65,11 @@ typedef enum {
 typedef enum {
   ICAP_COLOR_RGB565 = 0, ///< RGB565 big-endian
   ICAP_COLOR_YUV,        ///< YUV/YCbCr 4:2:2 big-endian
+  ICAP_COLOR_Y8,         ///< 8-bit grayscale (luma only), see compactY8()
+  ICAP_COLOR_RGB332,     ///< 8-bit RRRGGGBB, packed from RGB565 capture
+  ICAP_COLOR_RGB444,     ///< 12-bit R,G,B nibbles, 2 pixels per 3 bytes
+  ICAP_COLOR_BAYER,      ///< 8-bit raw Bayer (BGGR), one channel per pixel
+  ICAP_COLOR_JPEG,       ///< Compressed in-camera, variable length per frame
 } iCap_colorspace;
 
 /** Buffer reallocation behaviors when changing captured image size */
@@ -59,6 +81,51 @@ typedef enum {
 
 #if defined(ICAP_FULL_SUPPORT)
 
+class Adafruit_ImageCapture;
+
+/** Frame-complete callback, invoked from end-of-DMA interrupt */
+typedef void (*iCap_frame_callback)(Adafruit_ImageCapture *cam);
+
+/** Metadata recorded for each captured frame */
+typedef struct {
+  uint32_t sequence;     ///< VSYNC count at capture start (gaps = skipped)
+  uint32_t timestamp_us; ///< micros() at capture start (VSYNC)
+  uint32_t pixels;       ///< Pixels received by DMA for this frame
+  uint32_t dropped;      ///< Frames lost between prior frame and this one
+  uint32_t bytes;        ///< Image data length (JPEG: SOI through EOI)
+} iCap_frame_info;
+
+/** Aggregate capture counters, see frameStats() */
+typedef struct {
+  uint32_t captured; ///< Frames completed intact
+  uint32_t dropped;  ///< Frames lost (overrun, or no buffer available)
+  uint32_t resynced; ///< Transfers aborted & restarted after an overrun
+} iCap_frame_stats;
+
+/** Location and format of an image in RAM, e.g. from compactY8() */
+typedef struct {
+  uint8_t *pixels;       ///< First pixel, rows follow without padding
+  uint16_t width;        ///< Width in pixels
+  uint16_t height;       ///< Height in pixels
+  iCap_colorspace space; ///< Pixel format
+} iCap_view;
+
+/** Operations available to image_pipeline(), same as image_* functions */
+typedef enum {
+  ICAP_OP_NEGATIVE = 0, ///< image_negative(), param unused
+  ICAP_OP_THRESHOLD,    ///< image_threshold(), param = threshold
+  ICAP_OP_POSTERIZE,    ///< image_posterize(), param = levels
+  ICAP_OP_MEDIAN,       ///< image_median(), param unused
+  ICAP_OP_EDGES,        ///< image_edges(), param = sensitivity
+  ICAP_OP_Y2RGB565,     ///< Y2RGB565(), param unused
+} iCap_op;
+
+/** One stage of an image_pipeline() */
+typedef struct {
+  iCap_op op;    ///< Operation to apply
+  uint8_t param; ///< Argument to that operation, if any
+} iCap_pipeline_stage;
+
 /*!
     @brief  Class encapsulating common image sensor functionality.
 */
@@ -91,14 +158,16 @@ public:
                      allowable value (e.g. one of several fixed sizes).
     @param   height  Height in pixels. Subclass will limit this to a known
                      allowable value (e.g. one of several fixed sizes).
-    @param   space   Colorspace: currently ICAP_COLOR_RGB565 or
-                     ICAP_COLOR_YUV are supported, both 16 bits/pixel.
-                     This value is only used for figuring memory allocation,
-                     subclass needs to actually configure camera to match.
-    @param   nbuf    Number of image buffers, 1-3. Currently only 1 is
-                     supported...you can request more but this just wastes
-                     RAM right now, but eventually will help with latency
-                     with suitably-written application.
+    @param   space   Colorspace, any iCap_colorspace value. Buffer size
+                     follows from its bits per pixel (see bitsPerPixel()),
+                     so the 8- and 12-bit formats allow larger frames in
+                     the same RAM. This value is only used for figuring
+                     memory allocation, subclass needs to actually
+                     configure camera to match.
+    @param   nbuf    Number of image buffers, 1-3. With 2 or 3 buffers,
+                     DMA rotates through them on each VSYNC, and the
+                     application can use acquireFrame() and releaseFrame()
+                     to process one complete frame while the next loads.
     @param   allo    (Re-)allocation behavior. This value is IGNORED if a
                      static pixel buffer was passed to the constructor; it
                      only applies to dynamic allocation. ICAP_REALLOC_NONE
@@ -120,6 +189,29 @@ public:
                            uint8_t nbuf = 1,
                            iCap_realloc allo = ICAP_REALLOC_CHANGE);
 
+  /*!
+    @brief   Get storage size of pixels in a colorspace.
+    @param   space  One of the iCap_colorspace values.
+    @return  Bits per pixel: 16 for RGB565 and YUV, 12 for RGB444 (packed,
+             big-endian: R0G0 B0R1 G1B1 for each pair of pixels), 8 for
+             Y8, RGB332 and Bayer. JPEG has no fixed size; its 4 is the
+             buffer budget (a quarter of RGB565, ample at the camera's
+             default quality), and frames that overflow it are dropped.
+  */
+  static uint8_t bitsPerPixel(iCap_colorspace space);
+
+  /*!
+    @brief   Get size of one frame in a given format. This is what DMA
+             transfers per frame; image buffers are padded to a 32-bit
+             boundary.
+    @param   width   Width in pixels.
+    @param   height  Height in pixels.
+    @param   space   One of the iCap_colorspace values.
+    @return  Size in bytes, rounded up for a partial byte (RGB444).
+  */
+  static uint32_t frameBytes(uint16_t width, uint16_t height,
+                             iCap_colorspace space);
+
   /*!
     @brief   Get image width of camera's current resolution setting.
     @return  Width in pixels.
@@ -132,16 +224,179 @@ public:
   */
   uint16_t height(void) { return _height; }
 
+  /*!
+    @brief   Get colorspace of camera's current setting.
+    @return  One of the iCap_colorspace values, e.g. ICAP_COLOR_RGB565.
+  */
+  iCap_colorspace getColorspace(void) { return colorspace; }
+
   /*!
     @brief   Get address of image buffer being used by camera.
-    @return  uint16_t pointer to last-captured image data.
+    @return  uint16_t pointer to last-captured image data. If a frame is
+             currently held via acquireFrame(), that frame is returned.
+             Otherwise this is the most recently completed frame, which
+             (unless capture is suspended) may be overwritten by DMA at
+             any time.
   */
-  uint16_t *getBuffer(void) { return pixbuf[0]; }
+  uint16_t *getBuffer(void) { return pixbuf[frame_view]; }
+
+  /*!
+    @brief   Claim the newest complete frame for processing. While held,
+             DMA will not write to this buffer; capture continues into the
+             other buffer(s) when multi-buffering (nbuf 2 or 3), or pauses
+             when single-buffered. Any frame previously acquired is
+             implicitly released. The postprocessing functions (e.g.
+             image_median()) then operate on the held frame.
+    @return  Pointer to frame data, or NULL if no new frame has completed
+             since the last call.
+  */
+  uint16_t *acquireFrame(void);
+
+  /*!
+    @brief  Return a frame obtained with acquireFrame() to the pool, so
+            DMA may again write to that buffer.
+  */
+  void releaseFrame(void);
+
+  /*!
+    @brief   Test whether a new frame has completed since the last
+             acquireFrame(), without blocking.
+    @return  true if a frame is available to acquire, else false.
+    @note    When single-buffered, the frame is only available until the
+             next VSYNC. Use waitFrame() or a callback to avoid that race.
+  */
+  bool pollFrame(void) { return frame_ready >= 0; }
+
+  /*!
+    @brief   Release any held frame, wait for a new frame to complete, then
+             acquire it (as with acquireFrame()). Other tasks are yield()ed
+             to while waiting.
+    @param   timeout_ms  Maximum time to wait, in milliseconds.
+    @return  Pointer to frame data, or NULL if timeout elapsed first.
+  */
+  uint16_t *waitFrame(uint32_t timeout_ms = 1000);
+
+  /*!
+    @brief  Register a function to be called each time a frame finishes
+            loading. This is called from the end-of-DMA interrupt, so it
+            should be brief -- e.g. set a flag, or call acquireFrame().
+    @param  callback  Function to call, or NULL to disable. The function
+                      receives a pointer to the camera object.
+  */
+  void setFrameCallback(iCap_frame_callback callback) {
+    frame_callback = callback;
+  }
+
+  /*!
+    @brief   Get metadata for the frame returned by getBuffer() (i.e. the
+             acquired frame, if one is held).
+    @return  Pointer to iCap_frame_info structure. Contents are only
+             stable while the frame is held. Its 'bytes' is the length to
+             save or transfer, which for JPEG varies frame to frame.
+  */
+  const iCap_frame_info *frameInfo(void) { return &frame_info[frame_view]; }
+
+  /*!
+    @brief   Get aggregate capture counters since startup or last
+             resetFrameStats(), for measuring actual frame rate and
+             reliability.
+    @return  Copy of iCap_frame_stats structure.
+  */
+  iCap_frame_stats frameStats(void);
+
+  /*!
+    @brief  Zero the counters returned by frameStats().
+  */
+  void resetFrameStats(void);
+
+  /*!
+    @brief   Select DMA destination for the next frame. Called from arch-
+             specific VSYNC interrupt code, not user code. Rotates through
+             buffers, never selecting one held by the application.
+    @param   timestamp_us  micros() value at VSYNC, for frame metadata.
+    @return  Pointer to buffer for next frame, or NULL if none is free
+             (frame should be skipped).
+  */
+  uint16_t *frameStart(uint32_t timestamp_us);
+
+  /*!
+    @brief  Mark the frame started with frameStart() as complete. Called
+            from arch-specific end-of-DMA interrupt code, not user code.
+    @param  pixels  Number of pixels transferred.
+  */
+  void frameDone(uint32_t pixels);
+
+  /*!
+    @brief  Finish a variable-length (JPEG) frame. Called from arch-
+            specific interrupt code, not user code: at VSYNC after stopping
+            the transfer, or at end-of-DMA if the frame filled its buffer.
+            The frame is published as with frameDone() if it holds a
+            complete JPEG image (SOI marker at start, EOI within the data
+            received), its length then in frameInfo()->bytes. Otherwise
+            (overflow, or capture started mid-frame) it's discarded and
+            counted as dropped.
+    @param  bytes  Number of bytes transferred, or 0 if the architecture
+                   can't determine this (the whole buffer is then searched
+                   for EOI).
+  */
+  void frameEnd(uint32_t bytes);
+
+  /*!
+    @brief  Discard the frame started with frameStart(), which was cut
+            short (VSYNC arrived before DMA completed, so pixels were
+            lost). Called from arch-specific VSYNC interrupt code, not user
+            code, after aborting the transfer.
+    @param  pixels  Number of pixels transferred before abort, or 0 if the
+                    architecture can't determine this.
+  */
+  void frameAbort(uint32_t pixels);
+
+  /*!
+    @brief   Configure the scratch arena: working RAM for the 3x3 filters
+             (image_median(), image_edges()), image_mosaic() and
+             image_pipeline(), kept between calls rather than allocated
+             and freed on each. By default the library allocates the arena
+             on first use, grows it if a later call needs more, and
+             resizes it in bufferConfig() when image dimensions change
+             (following the same realloc behavior as the image buffer).
+             Use this function to supply a static buffer instead, or to
+             allocate up front.
+    @param   size  Arena size in bytes. scratchPeak(), after running the
+                   application's filters at its largest image size, is the
+                   exact figure needed. 0 (with buf NULL) frees the arena,
+                   returning to the default on-demand allocation.
+    @param   buf   Static buffer of 'size' bytes, or NULL (default) for the
+                   library to allocate. A static buffer is never resized;
+                   filters needing more than it holds return
+                   ICAP_STATUS_ERR_MALLOC and leave the image unchanged.
+                   Should be word-aligned, else a few bytes are skipped.
+    @return  ICAP_STATUS_OK on success, ICAP_STATUS_ERR_MALLOC if the
+             library could not allocate 'size' bytes (arena is then empty,
+             and default on-demand allocation resumes).
+    @note    Resets the scratchPeak() figure.
+  */
+  iCap_status scratchConfig(uint32_t size, uint8_t *buf = NULL);
+
+  /*!
+    @brief   Get current size of the scratch arena.
+    @return  Size in bytes, 0 if not yet allocated.
+  */
+  uint32_t scratchSize(void) { return scratch_size; }
+
+  /*!
+    @brief   Get scratch arena high-water mark: the most working RAM any
+             single filter call has requested since startup or the last
+             scratchConfig(), including requests that didn't fit. Use
+             this to size a static arena exactly.
+    @return  Size in bytes.
+  */
+  uint32_t scratchPeak(void) { return scratch_peak; }
 
   /*!
     @brief  Produces a negative image. This is a postprocessing effect,
             not in-camera, and must be applied to frame(s) manually.
-            Image in memory will be overwritten.
+            Image in memory will be overwritten. Works in any colorspace
+            but JPEG (no-op).
   */
   void image_negative(void);
 
@@ -177,29 +432,61 @@ public:
             frame(s) manually. Image in memory will be overwritten. If
             image size does not divide equally by tile size, fractional
             tiles will always be along the right and/or bottom edge(s);
-            top left corner is always a full tile.
-            YUV colorspace is not currently supported.
+            top left corner is always a full tile. For YUV images, Y, U
+            and V are each averaged per tile, and an odd tile_width
+            (including 1) is rounded up to the next even number so that
+            every tile holds whole U/V pairs.
     @param  tile_width   Tile width in pixels (1 to 255)
     @param  tile_height  Tile height in pixels (1 to 255)
+    @return ICAP_STATUS_OK on success, ICAP_STATUS_ERR_MALLOC if scratch
+            arena space (see scratchConfig()) isn't available.
   */
-  void image_mosaic(uint8_t tile_width = 8, uint8_t tile_height = 8);
+  iCap_status image_mosaic(uint8_t tile_width = 8, uint8_t tile_height = 8);
+
+  /*!
+    @brief  Original (slower) implementation of the mosaic effect. Output
+            is identical to image_mosaic(); this is kept only as a
+            reference for verifying optimized code. RGB565 only.
+    @param  tile_width   Tile width in pixels (1 to 255)
+    @param  tile_height  Tile height in pixels (1 to 255)
+  */
+  void image_mosaic_reference(uint8_t tile_width = 8,
+                              uint8_t tile_height = 8);
 
   /*!
     @brief  3x3 pixel median filter, reduces visual noise in image.
             This is a postprocessing effect, not in-camera, and must be
             applied to frame(s) manually. Image in memory will be
-            overwritten. YUV colorspace is not currently supported.
+            overwritten. For YUV images, Y is filtered at full resolution
+            and U and V each at their half horizontal resolution.
+    @return ICAP_STATUS_OK on success, ICAP_STATUS_ERR_MALLOC if scratch
+            arena space (see scratchConfig()) isn't available.
   */
-  void image_median(void);
+  iCap_status image_median(void);
+
+  /*!
+    @brief  Original (slower) implementation of the 3x3 median filter.
+            Output is identical to image_median(); this is kept only as a
+            reference for verifying optimized code. RGB565 only.
+    @return ICAP_STATUS_OK on success (or YUV, no-op), ICAP_STATUS_ERR_MALLOC
+            if scratch arena space (see scratchConfig()) isn't available.
+  */
+  iCap_status image_median_reference(void);
 
   /*!
     @brief  Edge detection filter.
             This is a postprocessing effect, not in-camera, and must be
             applied to frame(s) manually. Image in memory will be
-            overwritten. YUV colorspace is not currently supported.
+            overwritten. YUV images are edge-detected on Y alone, giving
+            a white-on-black edge map with neutral (128) chroma.
     @param  sensitivity  Smaller value = more sensitive to edge changes.
+                         For YUV this is scaled by 8 (to a maximum of 255)
+                         to match Y's 8-bit range, so the same value works
+                         similarly in either colorspace.
+    @return ICAP_STATUS_OK on success, ICAP_STATUS_ERR_MALLOC if scratch
+            arena space (see scratchConfig()) isn't available.
   */
-  void image_edges(uint8_t sensitivity = 7);
+  iCap_status image_edges(uint8_t sensitivity = 7);
 
   /*!
     @brief  Convert Y (brightness) component YUV image in RAM to RGB565
@@ -207,19 +494,207 @@ public:
             overwritten in-place, Y is truncated and UV elements are lost.
             No practical use outside TFT preview. If you need actual
             grayscale 0-255 data, just access the low byte of each 16-bit
-            YUV pixel.
+            YUV pixel. No-op for an ICAP_COLOR_Y8 capture, whose buffer
+            is too small to convert in place; use YUV2RGB565(dst).
   */
   void Y2RGB565(void);
 
+  /*!
+    @brief  Convert YUV 4:2:2 image in RAM to full-color RGB565 big-endian
+            format, e.g. for preview on TFT display. Unlike Y2RGB565(),
+            chroma is kept. Can convert in place (overwriting the camera
+            buffer) or into a separate buffer, leaving the YUV image intact
+            for further processing. Like Y2RGB565(), this does not change
+            the colorspace setting.
+    @param  dst  Destination for width * height RGB565 pixels, or NULL
+                 (default) to convert the camera buffer in place. For an
+                 ICAP_COLOR_Y8 capture, a gray preview is written here
+                 (NULL isn't allowed; the buffer can't hold 16 bits/pixel).
+    @return ICAP_STATUS_OK on success, ICAP_STATUS_ERR_MALLOC if scratch
+            arena space (about 6.5K, see scratchConfig()) isn't available
+            for the conversion tables, ICAP_STATUS_ERR_PERIPHERAL (image
+            unchanged) unless the colorspace is YUV, or Y8 with a dst.
+  */
+  iCap_status YUV2RGB565(uint16_t *dst = NULL);
+
+  /*!
+    @brief   Compact the current RGB565 or YUV image in place to 8-bit
+             grayscale (Y8): one luma byte per pixel, densely packed at the
+             start of the buffer, halving the memory that later processing
+             must read and write. YUV keeps its Y bytes as-is; RGB565 is
+             converted with BT.601 luma weights. Use the returned view
+             with the Y8 variants of the image_* functions (those taking
+             an iCap_view). The second half of the buffer is left as-is,
+             and the colorspace setting (which describes what the camera
+             delivers) is unchanged. If that setting is ICAP_COLOR_Y8
+             (luma-only capture), nothing moves and the view just
+             describes the buffer; image_* functions without a view
+             argument use this to work on Y8 captures directly. RGB332,
+             RGB444 and Bayer aren't converted; the view then carries
+             that colorspace, which the Y8 functions ignore (as is
+             JPEG).
+    @return  iCap_view of the Y8 image (pixels at start of getBuffer()).
+  */
+  iCap_view compactY8(void);
+
+  /*!
+    @brief  Convert a raw Bayer (BGGR) image to RGB565 big-endian by
+            bilinear interpolation, e.g. for display. The Bayer image is
+            left intact. Does nothing unless the colorspace setting is
+            ICAP_COLOR_BAYER and the image is at least 2x2.
+    @param  dst  Destination for width * height RGB565 pixels (twice the
+                 size of the Bayer image, so it can't be done in place).
+    @return ICAP_STATUS_OK on success, ICAP_STATUS_ERR_MALLOC if scratch
+            arena space (about 3 bytes per pixel of width, see
+            scratchConfig()) isn't available.
+  */
+  iCap_status demosaicRGB565(uint16_t *dst);
+
+  /*!
+    @brief  Convert a raw Bayer (BGGR) image in place to 8-bit grayscale
+            (Y8, BT.601 luma of the bilinear-interpolated color), for the
+            Y8 variants of the image_* functions. As with compactY8(),
+            the colorspace setting is unchanged. Does nothing unless the
+            colorspace setting is ICAP_COLOR_BAYER and the image is at
+            least 2x2.
+    @param  view  If non-NULL, set to the Y8 image on success.
+    @return ICAP_STATUS_OK on success, ICAP_STATUS_ERR_MALLOC if scratch
+            arena space (as for demosaicRGB565()) isn't available.
+  */
+  iCap_status demosaicY8(iCap_view *view = NULL);
+
+  /*!
+    @brief  Y8 variant of image_negative().
+    @param  view  Y8 image, e.g. from compactY8(). Other formats are
+                  ignored.
+  */
+  void image_negative(const iCap_view &view);
+
+  /*!
+    @brief  Y8 variant of image_threshold(), each pixel to 0 or 255.
+    @param  view       Y8 image, e.g. from compactY8(). Other formats are
+                       ignored.
+    @param  threshold  Threshold level, 0-255.
+  */
+  void image_threshold(const iCap_view &view, uint8_t threshold = 128);
+
+  /*!
+    @brief  Y8 variant of image_posterize().
+    @param  view    Y8 image, e.g. from compactY8(). Other formats are
+                    ignored.
+    @param  levels  Number of brightness levels, 2 to 255.
+  */
+  void image_posterize(const iCap_view &view, uint8_t levels = 4);
+
+  /*!
+    @brief  Variant of image_mosaic() for an image described by a view,
+            e.g. Y8 from compactY8(). RGB565, YUV and Y8 are supported,
+            other formats are ignored. As with image_mosaic(), a YUV
+            image's tile_width is rounded up to the next even number.
+    @param  view         Image to process.
+    @param  tile_width   Tile width in pixels (1 to 255)
+    @param  tile_height  Tile height in pixels (1 to 255)
+    @return ICAP_STATUS_OK on success, ICAP_STATUS_ERR_MALLOC if scratch
+            arena space (see scratchConfig()) isn't available.
+  */
+  iCap_status image_mosaic(const iCap_view &view, uint8_t tile_width = 8,
+                           uint8_t tile_height = 8);
+
+  /*!
+    @brief  Y8 variant of image_median().
+    @param  view  Y8 image, e.g. from compactY8(). Other formats are
+                  ignored.
+    @return ICAP_STATUS_OK on success, ICAP_STATUS_ERR_MALLOC if scratch
+            arena space (see scratchConfig()) isn't available.
+  */
+  iCap_status image_median(const iCap_view &view);
+
+  /*!
+    @brief  Y8 variant of image_edges(): white-on-black edge map.
+    @param  view         Y8 image, e.g. from compactY8(). Other formats are
+                         ignored.
+    @param  sensitivity  Smaller value = more sensitive to edge changes.
+                         Scaled by 8 (to a maximum of 255), as for YUV.
+    @return ICAP_STATUS_OK on success, ICAP_STATUS_ERR_MALLOC if scratch
+            arena space (see scratchConfig()) isn't available.
+  */
+  iCap_status image_edges(const iCap_view &view, uint8_t sensitivity = 7);
+
+  /*!
+    @brief   Apply a chain of postprocessing effects in a single pass over
+             the image. Output is identical to calling the equivalent
+             image_* functions (and Y2RGB565()) in the same order, but each
+             pixel is read and written only once rather than once per
+             effect, and consecutive point operations (negative, threshold,
+             posterize, Y2RGB565) are merged into one table lookup. 3x3
+             operations (median, edges) are streamed a row at a time.
+             Mosaic is not row-local and can't be included; call
+             image_mosaic() separately. As with the individual functions,
+             every stage follows the current colorspace setting (which
+             Y2RGB565 doesn't change). An ICAP_COLOR_Y8 capture isn't
+             supported (no-op); use the Y8 image_* functions instead.
+    @param   stages      Array of operations and their parameters.
+    @param   num_stages  Number of elements in stages array.
+    @return  ICAP_STATUS_OK on success (image processed in place),
+             ICAP_STATUS_ERR_MALLOC if working space in the scratch arena
+             (see scratchConfig()) isn't available (image is unchanged).
+             That's about 1K per run of point operations and, for each 3x3
+             stage, ((width + 2) * 3 + height - 1 + width) * 3 bytes, plus
+             3 bytes per pixel of width.
+  */
+  iCap_status image_pipeline(const iCap_pipeline_stage *stages,
+                             uint8_t num_stages);
+
 protected:
-  uint16_t *pixbuf[3];        ///< Frame pointers (up to 3) into pixel buffer
-  uint32_t pixbuf_size = 0;   ///< Full size of pixbuf, in bytes
-  uint8_t bufmode;            ///< 1-3 = single-, double-, triple-buffered
-  bool pixbuf_allocable;      ///< Internally allocated vs static buffer
-  uint16_t _width = 0;        ///< Current settings width in pixels
-  uint16_t _height = 0;       ///< Current settings height in pixels
-  iCap_colorspace colorspace; ///< Current settings colorspace
-  iCap_arch *arch = NULL;     ///< Device-specific data, if needed
+  uint16_t *pixbuf[3];              ///< Frame pointers (up to 3) in pixbuf
+  uint32_t pixbuf_size = 0;         ///< Full size of pixbuf, in bytes
+  uint8_t bufmode = 1;              ///< 1-3 = single-, double-, triple-buffered
+  volatile int8_t frame_dma = -1;   ///< Buffer being filled by DMA, or -1
+  volatile int8_t frame_ready = -1; ///< Newest unclaimed frame, or -1
+  volatile int8_t frame_held = -1;  ///< Buffer held by application, or -1
+  volatile uint8_t frame_view = 0;  ///< Buffer returned by getBuffer()
+  uint8_t frame_last = 0;           ///< Buffer most recently DMA'd into
+  bool pixbuf_allocable;            ///< Internally allocated vs static buffer
+  uint16_t _width = 0;              ///< Current settings width in pixels
+  uint16_t _height = 0;             ///< Current settings height in pixels
+  iCap_colorspace colorspace;       ///< Current settings colorspace
+  iCap_arch *arch = NULL;           ///< Device-specific data, if needed
+  uint8_t *scratch = NULL;          ///< Scratch arena for filters, or NULL
+  uint32_t scratch_size = 0;        ///< Size of scratch arena, in bytes
+  uint32_t scratch_peak = 0;        ///< Largest scratch request, in bytes
+  bool scratch_allocable = true;    ///< Internally allocated vs static arena
+
+  iCap_frame_callback frame_callback = NULL; ///< Called on frame complete
+  iCap_frame_info frame_info[3];             ///< Metadata for each buffer
+  iCap_frame_stats frame_stats;              ///< Capture counters
+  uint32_t frame_sequence = 0;               ///< VSYNC counter
+  uint32_t frame_drops = 0;                  ///< Frames lost since last start
+
+  /*!
+    @brief   Get working RAM from the scratch arena for a filter, growing
+             the arena if it's library-allocated and too small. Only one
+             caller uses the arena at a time; contents aren't preserved.
+    @param   bytes  Number of bytes needed.
+    @return  Pointer to arena, or NULL if 'bytes' can't be provided.
+  */
+  uint8_t *scratchGet(uint32_t bytes);
+
+  /*!
+    @brief  Common guts of the image_mosaic() variants.
+    @param  pixels       First pixel of image.
+    @param  width        Image width in pixels.
+    @param  height       Image height in pixels.
+    @param  space        Image colorspace.
+    @param  tile_width   Tile width in pixels (1 to 255). For YUV, odd
+                         widths (1 included) are rounded up to the next
+                         even number, keeping U/V pairs whole.
+    @param  tile_height  Tile height in pixels (1 to 255)
+    @return ICAP_STATUS_OK on success, ICAP_STATUS_ERR_MALLOC if scratch
+            arena space isn't available.
+  */
+  iCap_status mosaic(uint8_t *pixels, uint16_t width, uint16_t height,
+                     iCap_colorspace space, uint8_t tile_width,
+                     uint8_t tile_height);
 
   // No longer used
   //  iCap_status setSize(uint16_t width, uint16_t height, uint8_t nbuf=1,
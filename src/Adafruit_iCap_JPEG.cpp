@@ -0,0 +1,495 @@
+#include <Adafruit_iCap_JPEG.h>
+#include <Arduino.h>
+
+#if defined(ICAP_FULL_SUPPORT)
+
+// STANDARD TABLES ----------------------------------------------------------
+
+// Quantization tables from the JPEG spec (Annex K), natural (row-major)
+// order, scaled by quality in begin().
+static const uint8_t iCap_jpeg_quant[2][64] = {
+    {16, 11, 10, 16, 24,  40,  51,  61,  12, 12, 14, 19, 26,  58,  60,  55,
+     14, 13, 16, 24, 40,  57,  69,  56,  14, 17, 22, 29, 51,  87,  80,  62,
+     18, 22, 37, 56, 68,  109, 103, 77,  24, 35, 55, 64, 81,  104, 113, 92,
+     49, 64, 78, 87, 103, 121, 120, 101, 72, 92, 95, 98, 112, 100, 103, 99},
+    {17, 18, 24, 47, 99, 99, 99, 99, 18, 21, 26, 66, 99, 99, 99, 99,
+     24, 26, 56, 99, 99, 99, 99, 99, 47, 66, 99, 99, 99, 99, 99, 99,
+     99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99,
+     99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99}};
+
+// Natural-order index of each coefficient in zigzag order
+static const uint8_t iCap_jpeg_zigzag[64] = {
+    0,  1,  8,  16, 9,  2,  3,  10, 17, 24, 32, 25, 18, 11, 4,  5,
+    12, 19, 26, 33, 40, 48, 41, 34, 27, 20, 13, 6,  7,  14, 21, 28,
+    35, 42, 49, 56, 57, 50, 43, 36, 29, 22, 15, 23, 30, 37, 44, 51,
+    58, 59, 52, 45, 38, 31, 39, 46, 53, 60, 61, 54, 47, 55, 62, 63};
+
+// AAN DCT output scale per row/column, cos(k*pi/16)*sqrt(2) (1 for k=0),
+// 2.14 fixed point. Folded into the quantizer reciprocals.
+static const uint16_t iCap_jpeg_aan[8] = {16384, 22725, 21407, 19266,
+                                          16384, 12873, 8867,  4520};
+
+// Huffman tables from the JPEG spec (Annex K): count of codes of each
+// length 1-16, then symbols in code order. Luma DC, luma AC, chroma DC,
+// chroma AC.
+static const uint8_t iCap_jpeg_dc_counts[2][16] = {
+    {0, 1, 5, 1, 1, 1, 1, 1, 1, 0, 0, 0, 0, 0, 0, 0},
+    {0, 3, 1, 1, 1, 1, 1, 1, 1, 1, 1, 0, 0, 0, 0, 0}};
+static const uint8_t iCap_jpeg_dc_symbols[12] = {0, 1, 2, 3, 4,  5,
+                                                 6, 7, 8, 9, 10, 11};
+static const uint8_t iCap_jpeg_ac_counts[2][16] = {
+    {0, 2, 1, 3, 3, 2, 4, 3, 5, 5, 4, 4, 0, 0, 1, 0x7D},
+    {0, 2, 1, 2, 4, 4, 3, 4, 7, 5, 4, 4, 0, 1, 2, 0x77}};
+static const uint8_t iCap_jpeg_ac_symbols[2][162] = {
+    {0x01, 0x02, 0x03, 0x00, 0x04, 0x11, 0x05, 0x12, 0x21, 0x31, 0x41, 0x06,
+     0x13, 0x51, 0x61, 0x07, 0x22, 0x71, 0x14, 0x32, 0x81, 0x91, 0xA1, 0x08,
+     0x23, 0x42, 0xB1, 0xC1, 0x15, 0x52, 0xD1, 0xF0, 0x24, 0x33, 0x62, 0x72,
+     0x82, 0x09, 0x0A, 0x16, 0x17, 0x18, 0x19, 0x1A, 0x25, 0x26, 0x27, 0x28,
+     0x29, 0x2A, 0x34, 0x35, 0x36, 0x37, 0x38, 0x39, 0x3A, 0x43, 0x44, 0x45,
+     0x46, 0x47, 0x48, 0x49, 0x4A, 0x53, 0x54, 0x55, 0x56, 0x57, 0x58, 0x59,
+     0x5A, 0x63, 0x64, 0x65, 0x66, 0x67, 0x68, 0x69, 0x6A, 0x73, 0x74, 0x75,
+     0x76, 0x77, 0x78, 0x79, 0x7A, 0x83, 0x84, 0x85, 0x86, 0x87, 0x88, 0x89,
+     0x8A, 0x92, 0x93, 0x94, 0x95, 0x96, 0x97, 0x98, 0x99, 0x9A, 0xA2, 0xA3,
+     0xA4, 0xA5, 0xA6, 0xA7, 0xA8, 0xA9, 0xAA, 0xB2, 0xB3, 0xB4, 0xB5, 0xB6,
+     0xB7, 0xB8, 0xB9, 0xBA, 0xC2, 0xC3, 0xC4, 0xC5, 0xC6, 0xC7, 0xC8, 0xC9,
+     0xCA, 0xD2, 0xD3, 0xD4, 0xD5, 0xD6, 0xD7, 0xD8, 0xD9, 0xDA, 0xE1, 0xE2,
+     0xE3, 0xE4, 0xE5, 0xE6, 0xE7, 0xE8, 0xE9, 0xEA, 0xF1, 0xF2, 0xF3, 0xF4,
+     0xF5, 0xF6, 0xF7, 0xF8, 0xF9, 0xFA},
+    {0x00, 0x01, 0x02, 0x03, 0x11, 0x04, 0x05, 0x21, 0x31, 0x06, 0x12, 0x41,
+     0x51, 0x07, 0x61, 0x71, 0x13, 0x22, 0x32, 0x81, 0x08, 0x14, 0x42, 0x91,
+     0xA1, 0xB1, 0xC1, 0x09, 0x23, 0x33, 0x52, 0xF0, 0x15, 0x62, 0x72, 0xD1,
+     0x0A, 0x16, 0x24, 0x34, 0xE1, 0x25, 0xF1, 0x17, 0x18, 0x19, 0x1A, 0x26,
+     0x27, 0x28, 0x29, 0x2A, 0x35, 0x36, 0x37, 0x38, 0x39, 0x3A, 0x43, 0x44,
+     0x45, 0x46, 0x47, 0x48, 0x49, 0x4A, 0x53, 0x54, 0x55, 0x56, 0x57, 0x58,
+     0x59, 0x5A, 0x63, 0x64, 0x65, 0x66, 0x67, 0x68, 0x69, 0x6A, 0x73, 0x74,
+     0x75, 0x76, 0x77, 0x78, 0x79, 0x7A, 0x82, 0x83, 0x84, 0x85, 0x86, 0x87,
+     0x88, 0x89, 0x8A, 0x92, 0x93, 0x94, 0x95, 0x96, 0x97, 0x98, 0x99, 0x9A,
+     0xA2, 0xA3, 0xA4, 0xA5, 0xA6, 0xA7, 0xA8, 0xA9, 0xAA, 0xB2, 0xB3, 0xB4,
+     0xB5, 0xB6, 0xB7, 0xB8, 0xB9, 0xBA, 0xC2, 0xC3, 0xC4, 0xC5, 0xC6, 0xC7,
+     0xC8, 0xC9, 0xCA, 0xD2, 0xD3, 0xD4, 0xD5, 0xD6, 0xD7, 0xD8, 0xD9, 0xDA,
+     0xE2, 0xE3, 0xE4, 0xE5, 0xE6, 0xE7, 0xE8, 0xE9, 0xEA, 0xF2, 0xF3, 0xF4,
+     0xF5, 0xF6, 0xF7, 0xF8, 0xF9, 0xFA}};
+
+// Canonical Huffman codes from counts and symbols, indexed by symbol
+static void iCap_jpeg_huffman(const uint8_t *counts, const uint8_t *symbols,
+                              uint16_t *code, uint8_t *size) {
+  uint16_t c = 0;
+  for (uint8_t len = 1; len <= 16; len++) {
+    for (uint8_t n = counts[len - 1]; n; n--) {
+      code[*symbols] = c++;
+      size[*symbols++] = len;
+    }
+    c <<= 1;
+  }
+}
+
+// OUTPUT -------------------------------------------------------------------
+
+void Adafruit_iCap_JPEG::flush(void) {
+  // Full chunks keep SD writes sector-sized; the final one is whatever's
+  // left. Anything past a full chunk (a stuffed 0x00) moves to the front.
+  uint16_t len = (out_len >= ICAP_JPEG_OUTBUF) ? ICAP_JPEG_OUTBUF : out_len;
+  if ((status == ICAP_STATUS_OK) && (sink(context, out, len) != len)) {
+    status = ICAP_STATUS_ERR_WRITE;
+  }
+  total += len;
+  out_len -= len;
+  if (out_len) {
+    out[0] = out[len];
+  }
+}
+
+void Adafruit_iCap_JPEG::put(uint8_t byte) {
+  out[out_len++] = byte;
+  if (out_len >= ICAP_JPEG_OUTBUF) {
+    flush();
+  }
+}
+
+inline void Adafruit_iCap_JPEG::putBits(uint32_t code, uint8_t size) {
+  // Accumulator holds at most 7 pending bits between calls, so up to 16
+  // more always fit; bits above those that matter just shift out.
+  uint32_t b = (bits << size) | code;
+  uint8_t n = num_bits + size;
+  uint16_t len = out_len;
+  while (n >= 8) {
+    n -= 8;
+    uint8_t byte = b >> n;
+    out[len++] = byte;
+    if (byte == 0xFF) {
+      out[len++] = 0; // Stuffing, so data isn't mistaken for a marker
+    }
+    if (len >= ICAP_JPEG_OUTBUF) {
+      out_len = len;
+      flush();
+      len = out_len;
+    }
+  }
+  bits = b;
+  num_bits = n;
+  out_len = len;
+}
+
+// HEADERS ------------------------------------------------------------------
+
+iCap_status Adafruit_iCap_JPEG::begin(uint16_t width, uint16_t height,
+                                      iCap_colorspace space, iCap_sink sink,
+                                      void *context, uint8_t quality,
+                                      iCap_jpeg_sampling sampling) {
+  if (!width || !height || !sink ||
+      ((space != ICAP_COLOR_RGB565) && (space != ICAP_COLOR_YUV) &&
+       (space != ICAP_COLOR_Y8))) {
+    return ICAP_STATUS_ERR_PERIPHERAL;
+  }
+  this->sink = sink;
+  this->context = context;
+  this->space = space;
+  _width = width;
+  _height = height;
+  row = 0;
+  bits = num_bits = 0;
+  out_len = 0;
+  total = 0;
+  status = ICAP_STATUS_OK;
+  last_dc[0] = last_dc[1] = last_dc[2] = 0;
+  uint8_t num_tables = 2, num_comps = 3;
+  if (space == ICAP_COLOR_Y8) {
+    mcu_width = mcu_height = 8;
+    num_tables = num_comps = 1;
+  } else {
+    mcu_width = 16;
+    mcu_height = (sampling == ICAP_JPEG_420) ? 16 : 8;
+  }
+
+  put(0xFF); // SOI
+  put(0xD8);
+  static const uint8_t jfif[] = {0xFF, 0xE0, 0, 16, 'J', 'F', 'I', 'F', 0,
+                                 1,    1,    0, 0,  1,   0,   1,   0,   0};
+  for (uint8_t i = 0; i < sizeof jfif; i++) {
+    put(jfif[i]);
+  }
+
+  // Quantization tables, as libjpeg scales them for quality. Written in
+  // zigzag order; reciprocals kept in natural order to match DCT output.
+  // DCT output carries the AAN scale factors and a factor of 8, so each
+  // reciprocal is 2^16 / (q * 8 * aan[u] * aan[v]), i.e. 2^27 / (q * the
+  // 2.14 product). With 4:2:0, chroma samples are sums of two rows
+  // (doubled), which is compensated here too.
+  quality = (quality < 1) ? 1 : (quality > 100) ? 100 : quality;
+  uint16_t scale = (quality < 50) ? 5000 / quality : 200 - quality * 2;
+  put(0xFF); // DQT
+  put(0xDB);
+  put(0);
+  put(2 + 65 * num_tables);
+  for (uint8_t t = 0; t < num_tables; t++) {
+    put(t);
+    for (uint8_t k = 0; k < 64; k++) {
+      uint8_t i = iCap_jpeg_zigzag[k];
+      uint32_t q = (iCap_jpeg_quant[t][i] * scale + 50) / 100;
+      q = (q < 1) ? 1 : (q > 255) ? 255 : q;
+      put(q);
+      uint32_t aan = (uint32_t)iCap_jpeg_aan[i >> 3] * iCap_jpeg_aan[i & 7];
+      aan = (aan + 8192) >> 14;
+      uint32_t d = q * aan * ((t && (mcu_height == 16)) ? 2 : 1);
+      recip[t][i] = ((1UL << 27) + d / 2) / d;
+    }
+  }
+
+  put(0xFF); // SOF0 (baseline)
+  put(0xC0);
+  put(0);
+  put(8 + 3 * num_comps);
+  put(8); // Bits per sample
+  put(height >> 8);
+  put(height);
+  put(width >> 8);
+  put(width);
+  put(num_comps);
+  uint8_t hv = ((mcu_width / 8) << 4) | (mcu_height / 8); // Y blocks/MCU
+  for (uint8_t c = 0; c < num_comps; c++) {
+    put(c + 1);         // Component ID
+    put(c ? 0x11 : hv); // Horizontal:vertical sampling
+    put(c ? 1 : 0);     // Quantization table
+  }
+
+  put(0xFF); // DHT, and build the encoding tables to match
+  put(0xC4);
+  uint16_t len = 2;
+  for (uint8_t t = 0; t < num_tables; t++) {
+    len += 17 + 12 + 17 + 162;
+  }
+  put(len >> 8);
+  put(len);
+  for (uint8_t t = 0; t < num_tables; t++) {
+    put(t); // DC table t
+    for (uint8_t i = 0; i < 16; i++) {
+      put(iCap_jpeg_dc_counts[t][i]);
+    }
+    for (uint8_t i = 0; i < 12; i++) {
+      put(iCap_jpeg_dc_symbols[i]);
+    }
+    put(0x10 | t); // AC table t
+    for (uint8_t i = 0; i < 16; i++) {
+      put(iCap_jpeg_ac_counts[t][i]);
+    }
+    for (uint8_t i = 0; i < 162; i++) {
+      put(iCap_jpeg_ac_symbols[t][i]);
+    }
+    iCap_jpeg_huffman(iCap_jpeg_dc_counts[t], iCap_jpeg_dc_symbols,
+                      dc_code[t], dc_size[t]);
+    iCap_jpeg_huffman(iCap_jpeg_ac_counts[t], iCap_jpeg_ac_symbols[t],
+                      ac_code[t], ac_size[t]);
+  }
+
+  put(0xFF); // SOS
+  put(0xDA);
+  put(0);
+  put(6 + 2 * num_comps);
+  put(num_comps);
+  for (uint8_t c = 0; c < num_comps; c++) {
+    put(c + 1);        // Component ID
+    put(c ? 0x11 : 0); // DC:AC Huffman tables
+  }
+  put(0);  // Spectral selection start
+  put(63); // ...and end
+  put(0);  // Successive approximation
+
+  return status;
+}
+
+// ENCODING -----------------------------------------------------------------
+
+// Fixed-point multiply by AAN constants (8 fractional bits)
+#define ICAP_AAN_MUL(v, c) (((v) * (c)) >> 8)
+#define ICAP_AAN_0_382683433 98
+#define ICAP_AAN_0_541196100 139
+#define ICAP_AAN_0_707106781 181
+#define ICAP_AAN_1_306562965 334
+
+// One 8-point AAN forward DCT (Arai, Agui & Nakajima, as in the IJG
+// jfdctfst.c) over elements spaced 'step' apart in an int32_t array.
+static inline void iCap_jpeg_fdct8(int32_t *d, uint8_t step) {
+  int32_t tmp0 = d[0] + d[7 * step], tmp7 = d[0] - d[7 * step];
+  int32_t tmp1 = d[step] + d[6 * step], tmp6 = d[step] - d[6 * step];
+  int32_t tmp2 = d[2 * step] + d[5 * step], tmp5 = d[2 * step] - d[5 * step];
+  int32_t tmp3 = d[3 * step] + d[4 * step], tmp4 = d[3 * step] - d[4 * step];
+
+  // Even part
+  int32_t tmp10 = tmp0 + tmp3, tmp13 = tmp0 - tmp3;
+  int32_t tmp11 = tmp1 + tmp2, tmp12 = tmp1 - tmp2;
+  d[0] = tmp10 + tmp11;
+  d[4 * step] = tmp10 - tmp11;
+  int32_t z1 = ICAP_AAN_MUL(tmp12 + tmp13, ICAP_AAN_0_707106781);
+  d[2 * step] = tmp13 + z1;
+  d[6 * step] = tmp13 - z1;
+
+  // Odd part
+  tmp10 = tmp4 + tmp5;
+  tmp11 = tmp5 + tmp6;
+  tmp12 = tmp6 + tmp7;
+  int32_t z5 = ICAP_AAN_MUL(tmp10 - tmp12, ICAP_AAN_0_382683433);
+  int32_t z2 = ICAP_AAN_MUL(tmp10, ICAP_AAN_0_541196100) + z5;
+  int32_t z4 = ICAP_AAN_MUL(tmp12, ICAP_AAN_1_306562965) + z5;
+  int32_t z3 = ICAP_AAN_MUL(tmp11, ICAP_AAN_0_707106781);
+  int32_t z11 = tmp7 + z3, z13 = tmp7 - z3;
+  d[5 * step] = z13 + z2;
+  d[3 * step] = z13 - z2;
+  d[step] = z11 + z4;
+  d[7 * step] = z11 - z4;
+}
+
+void Adafruit_iCap_JPEG::encodeBlock(const int16_t *in, uint8_t comp) {
+  int32_t d[64];
+  uint8_t t = comp ? 1 : 0; // Table index, luma or chroma
+  for (uint8_t i = 0; i < 64; i++) {
+    d[i] = in[i];
+  }
+  for (uint8_t i = 0; i < 64; i += 8) {
+    iCap_jpeg_fdct8(&d[i], 1); // Rows
+  }
+  for (uint8_t i = 0; i < 8; i++) {
+    iCap_jpeg_fdct8(&d[i], 8); // Columns
+  }
+
+  // DC: difference from previous block of same component
+  const uint32_t *r = recip[t];
+  int32_t v = d[0];
+  uint32_t a = ((uint32_t)((v < 0) ? -v : v) * r[0] + 0x8000) >> 16;
+  v = (v < 0) ? -(int32_t)a : a;
+  int32_t diff = v - last_dc[comp];
+  last_dc[comp] = v;
+  a = (diff < 0) ? -diff : diff;
+  uint8_t nbits = a ? 32 - __builtin_clz(a) : 0;
+  putBits(dc_code[t][nbits], dc_size[t][nbits]);
+  if (nbits) {
+    // Negative values are sent as one's complement in nbits
+    putBits((diff - (diff < 0)) & ((1 << nbits) - 1), nbits);
+  }
+
+  // AC: run of zeros + magnitude category, in zigzag order. Magnitude is
+  // limited to the 10 bits baseline allows (only reachable at quality
+  // 100, by DCT rounding).
+  uint8_t run = 0;
+  for (uint8_t k = 1; k < 64; k++) {
+    uint8_t i = iCap_jpeg_zigzag[k];
+    v = d[i];
+    a = ((uint32_t)((v < 0) ? -v : v) * r[i] + 0x8000) >> 16;
+    if (!a) {
+      run++;
+      continue;
+    }
+    if (a > 1023) {
+      a = 1023;
+    }
+    for (; run > 15; run -= 16) {
+      putBits(ac_code[t][0xF0], ac_size[t][0xF0]); // ZRL, 16 zeros
+    }
+    nbits = 32 - __builtin_clz(a);
+    uint8_t symbol = (run << 4) | nbits;
+    putBits(ac_code[t][symbol], ac_size[t][symbol]);
+    putBits((v < 0) ? (~a & ((1 << nbits) - 1)) : a, nbits);
+    run = 0;
+  }
+  if (run) {
+    putBits(ac_code[t][0], ac_size[t][0]); // EOB
+  }
+}
+
+// Color conversion (JFIF full-range BT.601), 16 fractional bits
+#define ICAP_JPEG_YR 19595
+#define ICAP_JPEG_YG 38470
+#define ICAP_JPEG_YB 7471
+#define ICAP_JPEG_CBR -11059
+#define ICAP_JPEG_CBG -21709
+#define ICAP_JPEG_CBB 32768
+#define ICAP_JPEG_CRR 32768
+#define ICAP_JPEG_CRG -27439
+#define ICAP_JPEG_CRB -5329
+
+// Big-endian RGB565 pixel to 8-bit R, G, B (high bits repeated into low)
+static inline void iCap_jpeg_rgb(const uint8_t *p, int32_t *r, int32_t *g,
+                                 int32_t *b) {
+  uint16_t c = (p[0] << 8) | p[1];
+  *r = ((c >> 8) & 0xF8) | (c >> 13);
+  *g = ((c >> 3) & 0xFC) | ((c >> 9) & 3);
+  *b = ((c << 3) & 0xF8) | ((c >> 2) & 7);
+}
+
+// Level-shifted (-128 to 127) luma of 8-bit R, G, B
+static inline int16_t iCap_jpeg_luma(int32_t r, int32_t g, int32_t b) {
+  int32_t y = ICAP_JPEG_YR * r + ICAP_JPEG_YG * g + ICAP_JPEG_YB * b;
+  return ((y + 32768) >> 16) - 128;
+}
+
+void Adafruit_iCap_JPEG::loadMCU(const uint8_t *pixels, uint8_t rows,
+                                 uint16_t x) {
+  uint16_t last = _width - 1;
+  if (space == ICAP_COLOR_Y8) {
+    for (uint8_t yy = 0; yy < 8; yy++) {
+      const uint8_t *src = pixels + ((yy < rows) ? yy : rows - 1) * _width;
+      int16_t *dst = &block[0][yy * 8];
+      for (uint8_t xx = 0; xx < 8; xx++) {
+        uint16_t sx = x + xx;
+        dst[xx] = src[(sx < last) ? sx : last] - 128;
+      }
+    }
+    return;
+  }
+
+  // Color: worked in horizontal pixel pairs, which share chroma. With
+  // 4:2:0 the two rows of a chroma sample are summed (not averaged); the
+  // chroma quantizers are halved to match.
+  uint8_t num_y = mcu_height / 4; // Y blocks per MCU: 4 or 2
+  int16_t *cb = block[num_y], *cr = block[num_y + 1];
+  uint8_t vshift = (mcu_height == 16);
+  bool rgb = (space == ICAP_COLOR_RGB565);
+  for (uint8_t yy = 0; yy < mcu_height; yy++) {
+    const uint8_t *src = pixels + ((yy < rows) ? yy : rows - 1) * _width * 2;
+    int16_t *ydst = &block[(yy >> 3) * 2][(yy & 7) * 8];
+    bool sum = vshift && (yy & 1);
+    uint8_t ci = (yy >> vshift) * 8;
+    for (uint8_t xx = 0; xx < 16; xx += 2, ci++) {
+      uint16_t sx = x + xx;
+      int16_t *yp = ydst + (xx >> 3) * 64 + (xx & 7);
+      int32_t cbv, crv;
+      if (rgb) {
+        uint16_t x0 = (sx < last) ? sx : last, x1 = (sx < last) ? sx + 1 : last;
+        int32_t r0, g0, b0, r1, g1, b1;
+        iCap_jpeg_rgb(src + x0 * 2, &r0, &g0, &b0);
+        iCap_jpeg_rgb(src + x1 * 2, &r1, &g1, &b1);
+        yp[0] = iCap_jpeg_luma(r0, g0, b0);
+        yp[1] = iCap_jpeg_luma(r1, g1, b1);
+        int32_t r = r0 + r1, g = g0 + g1, b = b0 + b1; // Pair sums
+        cbv = ICAP_JPEG_CBR * r + ICAP_JPEG_CBG * g + ICAP_JPEG_CBB * b;
+        crv = ICAP_JPEG_CRR * r + ICAP_JPEG_CRG * g + ICAP_JPEG_CRB * b;
+        cbv = (cbv + 65536) >> 17; // Rounded, and halved for the pair sum
+        crv = (crv + 65536) >> 17;
+      } else { // YUV: Y0 U Y1 V, V neutral if odd width leaves no Y1
+        uint16_t px = (sx < last) ? sx : last & ~1;
+        const uint8_t *p = src + px * 2;
+        yp[0] = p[0] - 128;
+        cbv = p[1] - 128;
+        if (px < last) {
+          yp[1] = p[2] - 128;
+          crv = p[3] - 128;
+        } else {
+          yp[1] = yp[0];
+          crv = 0;
+        }
+      }
+      if (sum) {
+        cb[ci] += cbv;
+        cr[ci] += crv;
+      } else {
+        cb[ci] = cbv;
+        cr[ci] = crv;
+      }
+    }
+  }
+}
+
+iCap_status Adafruit_iCap_JPEG::writeBand(const uint8_t *pixels) {
+  if ((status != ICAP_STATUS_OK) || (row >= _height)) {
+    return status;
+  }
+  uint8_t rows = ((_height - row) < mcu_height) ? _height - row : mcu_height;
+  uint8_t num_y = (space == ICAP_COLOR_Y8) ? 1 : mcu_height / 4;
+  for (uint16_t x = 0; (x < _width) && (status == ICAP_STATUS_OK);
+       x += mcu_width) {
+    loadMCU(pixels, rows, x);
+    for (uint8_t i = 0; i < num_y; i++) {
+      encodeBlock(block[i], 0);
+    }
+    if (space != ICAP_COLOR_Y8) {
+      encodeBlock(block[num_y], 1);
+      encodeBlock(block[num_y + 1], 2);
+    }
+  }
+  row += rows;
+  if (row >= _height) { // Last band: pad to byte with 1s, EOI, flush all
+    if (num_bits) {
+      putBits((1 << (8 - num_bits)) - 1, 8 - num_bits);
+    }
+    put(0xFF);
+    put(0xD9);
+    while (out_len) {
+      flush();
+    }
+  }
+  return status;
+}
+
+iCap_status Adafruit_iCap_JPEG::encode(const iCap_view &view, iCap_sink sink,
+                                       void *context, uint8_t quality,
+                                       iCap_jpeg_sampling sampling) {
+  iCap_status status = begin(view.width, view.height, view.space, sink,
+                             context, quality, sampling);
+  uint32_t stride = view.width * ((view.space == ICAP_COLOR_Y8) ? 1 : 2);
+  for (uint16_t y = 0; (y < view.height) && (status == ICAP_STATUS_OK);
+       y += mcu_height) {
+    status = writeBand(view.pixels + y * stride);
+  }
+  return status;
+}
+
+#endif // end ICAP_FULL_SUPPORT
@@ -0,0 +1,171 @@
+/*!
+ * @file Adafruit_iCap_JPEG.h
+ *
+ * Baseline JPEG encoder for Adafruit_ImageCapture, for sensors with no
+ * compressor of their own (e.g. OV7670).
+ *
+ * Adafruit invests time and resources providing this open source code,
+ * please support Adafruit and open-source hardware by purchasing
+ * products from Adafruit!
+ *
+ * MIT license, all text here must be included in any redistribution.
+ */
+
+#pragma once
+
+#include <Adafruit_ImageCapture.h>
+
+#if defined(ICAP_FULL_SUPPORT)
+
+#define ICAP_JPEG_OUTBUF 512 ///< Bytes per sink call (last may be fewer)
+
+/** Chroma subsampling, see Adafruit_iCap_JPEG::begin() */
+typedef enum {
+  ICAP_JPEG_420 = 0, ///< Chroma halved both ways, 16-row bands (smallest)
+  ICAP_JPEG_422,     ///< Chroma halved horizontally only, 8-row bands
+} iCap_jpeg_sampling;
+
+/*!
+    @brief  Streaming baseline JPEG encoder. The image is fed in as bands
+            of 8 or 16 rows (one row of JPEG MCUs) and compressed data goes
+            straight to a sink function in ICAP_JPEG_OUTBUF chunks, so
+            neither the source nor the compressed frame needs to be held
+            in RAM all at once. Fixed-point throughout (AAN DCT, reciprocal
+            quantization), standard Huffman tables. The object is about
+            3.5K.
+*/
+class Adafruit_iCap_JPEG {
+public:
+  /*!
+    @brief  Constructor for Adafruit_iCap_JPEG class. Nothing is set up
+            until begin() (or encode()).
+  */
+  Adafruit_iCap_JPEG(void) {}
+
+  /*!
+    @brief   Start a new JPEG image: set up tables and write the headers to
+             the sink. Follow with writeBand() calls, top to bottom.
+    @param   width     Image width in pixels.
+    @param   height    Image height in pixels.
+    @param   space     Source format: ICAP_COLOR_RGB565 or ICAP_COLOR_YUV
+                       (big-endian, as captured) for color, ICAP_COLOR_Y8
+                       for grayscale.
+    @param   sink      Function receiving the compressed data.
+    @param   context   Passed through to sink, e.g. a File pointer.
+    @param   quality   1 (smallest) to 100 (best), scaling the standard
+                       quantization tables the same way as libjpeg.
+    @param   sampling  Chroma subsampling for color images, sets the band
+                       height (see bandRows()). Ignored for Y8.
+    @return  ICAP_STATUS_OK on success, ICAP_STATUS_ERR_PERIPHERAL if the
+             format isn't supported (or size is zero or sink NULL),
+             ICAP_STATUS_ERR_WRITE if the sink failed.
+  */
+  iCap_status begin(uint16_t width, uint16_t height, iCap_colorspace space,
+                    iCap_sink sink, void *context, uint8_t quality = 75,
+                    iCap_jpeg_sampling sampling = ICAP_JPEG_420);
+
+  /*!
+    @brief   Get number of image rows consumed per writeBand() call.
+    @return  16 for color with ICAP_JPEG_420, else 8.
+  */
+  uint8_t bandRows(void) { return mcu_height; }
+
+  /*!
+    @brief   Compress the next band of the image: bandRows() rows, or
+             whatever remains at the bottom of the image. The last band
+             also completes the JPEG stream (EOI marker) and flushes it to
+             the sink; further calls do nothing.
+    @param   pixels  First pixel of the band, rows following without
+                     padding in the format given to begin() -- e.g. the
+                     camera buffer plus row * width * 2 bytes for RGB565.
+                     Need not be aligned.
+    @return  ICAP_STATUS_OK on success, ICAP_STATUS_ERR_WRITE if the sink
+             failed (now or on an earlier call; the stream is then
+             abandoned).
+  */
+  iCap_status writeBand(const uint8_t *pixels);
+
+  /*!
+    @brief   Compress a whole image in RAM: begin() then writeBand() for
+             each band. The image is left intact.
+    @param   view      Image to compress, e.g. {(uint8_t *)cam.getBuffer(),
+                       cam.width(), cam.height(), cam.getColorspace()}.
+    @param   sink      Function receiving the compressed data.
+    @param   context   Passed through to sink, e.g. a File pointer.
+    @param   quality   1 (smallest) to 100 (best).
+    @param   sampling  Chroma subsampling for color images.
+    @return  As for begin() and writeBand().
+  */
+  iCap_status encode(const iCap_view &view, iCap_sink sink, void *context,
+                     uint8_t quality = 75,
+                     iCap_jpeg_sampling sampling = ICAP_JPEG_420);
+
+  /*!
+    @brief   Get the amount of compressed data passed to the sink so far.
+    @return  Size in bytes; the complete file size once the last band is
+             written.
+  */
+  uint32_t bytesWritten(void) { return total; }
+
+protected:
+  /*!
+    @brief  Append a marker or header byte to the output buffer.
+    @param  byte  Value to append.
+  */
+  void put(uint8_t byte);
+
+  /*!
+    @brief  Append entropy-coded bits to the output, byte-stuffing any
+            0xFF that results.
+    @param  code  Bits to append, right-aligned, nothing set above them.
+    @param  size  Number of bits, 0 to 16.
+  */
+  void putBits(uint32_t code, uint8_t size);
+
+  /*!
+    @brief  Pass buffered output to the sink: ICAP_JPEG_OUTBUF bytes at a
+            time, or all of it once the image is complete.
+  */
+  void flush(void);
+
+  /*!
+    @brief  Gather one MCU from a band into block[], converting to level-
+            shifted Y (and subsampled Cb, Cr). Pixels past the right or
+            bottom edge repeat the last column or row.
+    @param  pixels  First pixel of band.
+    @param  rows    Rows in band, 1 to mcu_height.
+    @param  x       Left column of MCU.
+  */
+  void loadMCU(const uint8_t *pixels, uint8_t rows, uint16_t x);
+
+  /*!
+    @brief  Forward DCT, quantize and Huffman-code one 8x8 block.
+    @param  in    64 level-shifted samples, row-major.
+    @param  comp  Component: 0 = Y, 1 = Cb, 2 = Cr.
+  */
+  void encodeBlock(const int16_t *in, uint8_t comp);
+
+  iCap_sink sink = NULL;               ///< Output function
+  void *context = NULL;                ///< Passed to sink
+  uint32_t recip[2][64];               ///< Quantizer reciprocals, Y & CbCr
+  uint16_t dc_code[2][12];             ///< DC Huffman codes by category
+  uint8_t dc_size[2][12];              ///< DC Huffman code lengths
+  uint16_t ac_code[2][256];            ///< AC Huffman codes by run/size
+  uint8_t ac_size[2][256];             ///< AC Huffman code lengths
+  int16_t block[6][64];                ///< One MCU: up to 4 Y blocks, Cb, Cr
+  int16_t last_dc[3];                  ///< Previous DC value per component
+  uint32_t bits = 0;                   ///< Entropy coder bit accumulator
+  uint8_t num_bits = 0;                ///< Bits pending in accumulator
+  uint8_t out[ICAP_JPEG_OUTBUF + 1];   ///< Output buffer (+1 for stuffing)
+  uint16_t out_len = 0;                ///< Bytes in out[]
+  uint32_t total = 0;                  ///< Bytes passed to sink
+  uint16_t _width = 0;                 ///< Image width in pixels
+  uint16_t _height = 0;                ///< Image height in pixels
+  uint16_t row = 0;                    ///< Next row to encode
+  iCap_colorspace space;               ///< Source format
+  uint8_t mcu_width = 16;              ///< MCU width in pixels, 8 or 16
+  uint8_t mcu_height = 16;             ///< MCU height (= band), 8 or 16
+  iCap_status status = ICAP_STATUS_OK; ///< First error, if any
+};
+
+#endif // end ICAP_FULL_SUPPORT
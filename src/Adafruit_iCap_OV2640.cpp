@@ -14,7 +14,7 @@ Adafruit_iCap_OV2640::~Adafruit_iCap_OV2640() {}
 
 // CAMERA STARTUP ----------------------------------------------------------
 
-static const iCap_parallel_config OV2640_init[] = {
+static constexpr iCap_parallel_config OV2640_init[] = {
 #if 0
 // Ideas from esp32-camera
 // not working yet (scrambled image)
@@ -463,8 +463,32 @@ static const iCap_parallel_config OV2640_init[] = {
          OV2640_IMAGE_MODE_DVP_YUV | OV2640_IMAGE_MODE_BYTE_SWAP},
         {0xD7, 0x01},               // Mystery init values
         {0xE1, 0x67},               // seen in other examples
+        {OV2640_REG0_RESET, 0x00}}, // Go
+    OV2640_jpeg[] = {
+        {OV2640_REG_RA_DLMT, OV2640_RA_DLMT_DSP}, // DSP bank select 0
+        {OV2640_REG0_RESET, OV2640_RESET_JPEG | OV2640_RESET_DVP},
+        // Compressor takes YUV422 from the DSP. HREF is left as per-line
+        // (not JPEG_HREF), as capture is gated on HREF.
+        {OV2640_REG0_IMAGE_MODE,
+         OV2640_IMAGE_MODE_JPEG | OV2640_IMAGE_MODE_DVP_YUV},
+        {OV2640_REG0_CTRL0, OV2640_CTRL0_YUV422 | OV2640_CTRL0_YUV_EN |
+                                OV2640_CTRL0_RGB_EN},
+        {OV2640_REG0_QS, OV2640_QS_DEFAULT},
+        {0xD7, 0x03},               // Mystery init values
+        {0xE1, 0x77},               // seen in other examples
+        {0xE5, 0x1F},               // Reserved
+        {0xDD, 0x7F},               // Reserved
         {OV2640_REG0_RESET, 0x00}}; // Go
 
+// Pauses in OV2640_init: the datasheet's tS:RESET (1 ms) after the on-chip
+// microcontroller reset. The JPEG/DVP reset that follows needs none, it's
+// held until a later list releases it ("Go").
+#define OV2640_INIT_MC_RESET 67 ///< Index of MC_BIST reset in OV2640_init
+static_assert(OV2640_init[OV2640_INIT_MC_RESET].reg == OV2640_REG0_MC_BIST,
+              "OV2640_INIT_MC_RESET must follow changes to OV2640_init");
+static const iCap_parallel_pause OV2640_init_pause[] = {
+    {OV2640_INIT_MC_RESET, 1}};
+
 iCap_status Adafruit_iCap_OV2640::begin(void) {
   iCap_status status;
 
@@ -497,7 +521,9 @@ iCap_status Adafruit_iCap_OV2640::begin(void) {
   delay(1); // Datasheet: tS:RESET = 1 ms
 
   // Init main camera settings
-  writeList(OV2640_init, sizeof OV2640_init / sizeof OV2640_init[0]);
+  writeList(OV2640_init, sizeof OV2640_init / sizeof OV2640_init[0],
+            OV2640_init_pause,
+            sizeof OV2640_init_pause / sizeof OV2640_init_pause[0]);
 
   // Further initialization for specific colorspaces, frame sizes, timing,
   // etc. are done in other functions.
@@ -519,11 +545,28 @@ iCap_status Adafruit_iCap_OV2640::begin(OV2640_size size, iCap_colorspace space,
 }
 
 void Adafruit_iCap_OV2640::setColorspace(iCap_colorspace space) {
-  if (colorspace == ICAP_COLOR_RGB565) {
+  switch (space) {
+  case ICAP_COLOR_RGB565:
+  case ICAP_COLOR_RGB332: // Camera sends RGB565, capture packs to 8 bits
     writeList(OV2640_rgb, sizeof OV2640_rgb / sizeof OV2640_rgb[0]);
-  } else {
+    break;
+  case ICAP_COLOR_JPEG:
+    writeList(OV2640_jpeg, sizeof OV2640_jpeg / sizeof OV2640_jpeg[0]);
+    break;
+  default: // YUV, or Y8 (camera sends YUV, capture keeps only Y)
     writeList(OV2640_yuv, sizeof OV2640_yuv / sizeof OV2640_yuv[0]);
+    break;
+  }
+}
+
+void Adafruit_iCap_OV2640::setJPEGQuality(uint8_t qs) {
+  if (qs < 2) {
+    qs = 2;
+  } else if (qs > 63) {
+    qs = 63;
   }
+  writeRegister(OV2640_REG_RA_DLMT, OV2640_RA_DLMT_DSP); // Bank select 0
+  writeRegister(OV2640_REG0_QS, qs);
 }
 
 iCap_status Adafruit_iCap_OV2640::config(OV2640_size size,
@@ -532,14 +575,20 @@ iCap_status Adafruit_iCap_OV2640::config(OV2640_size size,
   // RIGGED FOR QQVGA FOR NOW, 30 fps
   uint16_t width = 160;
   uint16_t height = 120;
+  if ((space == ICAP_COLOR_RGB444) || (space == ICAP_COLOR_BAYER)) {
+    return ICAP_STATUS_ERR_PERIPHERAL; // No sensor settings for these
+  }
   iCap_status status = bufferConfig(width, height, space, nbuf, allo);
   if (status == ICAP_STATUS_OK) {
     writeList(OV2640_qqvga, sizeof OV2640_qqvga / sizeof OV2640_qqvga[0]);
+    setColorspace(space); // Select RGB/YUV/JPEG
     if (fps > 0.0) {
       delayMicroseconds((int)(10000000.0 / fps)); // 10 frame settling time
     }
-    dma_change(pixbuf[0], _width * _height);
-    resume(); // Start DMA cycle
+    status = dma_change(pixbuf[0], _width * _height);
+    if (status == ICAP_STATUS_OK) {
+      resume(); // Start DMA cycle
+    }
   }
 
   return status;
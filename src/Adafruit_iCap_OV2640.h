@@ -11,7 +11,8 @@ typedef enum {
 
 typedef iCap_parallel_pins OV2640_pins;
 
-#define OV2640_ADDR 0x30 //< Default I2C address if unspecified
+#define OV2640_ADDR 0x30     //< Default I2C address if unspecified
+#define OV2640_QS_DEFAULT 12 //< Default JPEG quantization scale
 
 /*!
     @brief  Class encapsulating OmniVision OV2640 functionality.
@@ -37,12 +38,14 @@ public:
     @param  pbufsize  Size of passed-in buffer (or 0 if NULL).
     @param  addr      I2C address of camera.
     @param  speed     I2C communication speed to camera.
-    @param  delay_us  Delay in microseconds between register writes.
+    @param  delay_us  Delay in microseconds after each register write
+                      transaction, 0 (default) for none. If camera init
+                      locks up on a particular MCU, try 1000.
   */
   Adafruit_iCap_OV2640(iCap_parallel_pins &pins, iCap_arch *arch = NULL,
                        TwoWire &twi = Wire, uint16_t *pbuf = NULL,
                        uint32_t pbufsize = 0, uint8_t addr = OV2640_ADDR,
-                       uint32_t speed = 100000, uint32_t delay_us = 1000);
+                       uint32_t speed = 100000, uint32_t delay_us = 0);
   ~Adafruit_iCap_OV2640(); // Destructor
 
   /*!
@@ -59,12 +62,16 @@ public:
              background. Really just a one-step wrapper around begin(void)
              and config(...).
     @param   size   Frame size as a OV2640_size enum value.
-    @param   space  ICAP_COLOR_RGB or ICAP_COLOR_YUV.
+    @param   space  ICAP_COLOR_RGB565, ICAP_COLOR_YUV, ICAP_COLOR_JPEG or
+                    the formats reduced from RGB/YUV in capture
+                    (ICAP_COLOR_RGB332, ICAP_COLOR_Y8). RGB444 and Bayer
+                    aren't supported.
     @param   fps    Desired capture framerate, in frames per second, as a
                     float up to 30.0. Actual device frame rate may differ
                     from this, depending on a host's available PWM timing.
-    @param   nbuf   Number of full-image buffers, 1-3. For now, always use
-                    1, multi-buffering isn't handled yet.
+    @param   nbuf   Number of full-image buffers, 1-3. With 2 or 3, use
+                    acquireFrame() and releaseFrame() to process frames
+                    while capture continues.
     @return  Status code. ICAP_STATUS_OK on successful init.
   */
   iCap_status begin(OV2640_size size, iCap_colorspace space = ICAP_COLOR_RGB565,
@@ -73,12 +80,19 @@ public:
   /*!
     @brief   Change frame configuration on an already-running camera.
     @param   size  One of the OV2640_size values (TBD).
-    @param   space  ICAP_COLOR_RGB or ICAP_COLOR_YUV.
+    @param   space  ICAP_COLOR_RGB565, ICAP_COLOR_YUV, ICAP_COLOR_JPEG or
+                    the formats reduced from RGB/YUV in capture
+                    (ICAP_COLOR_RGB332, ICAP_COLOR_Y8). RGB444 and Bayer
+                    aren't supported. JPEG frames vary in length, each
+                    ending at the following VSYNC; the buffer holds the
+                    largest expected (see bitsPerPixel()), and
+                    frameInfo()->bytes gives each one's actual length.
     @param   fps    Desired capture framerate, in frames per second, as a
                     float up to 30.0. Actual device frame rate may differ
                     from this, depending on a host's available PWM timing.
-    @param   nbuf   Number of full-image buffers, 1-3. For now, always use
-                    1, multi-buffering isn't handled yet.
+    @param   nbuf   Number of full-image buffers, 1-3. With 2 or 3, use
+                    acquireFrame() and releaseFrame() to process frames
+                    while capture continues.
     @param   allo   (Re-)allocation behavior. This value is IGNORED if a
                     static pixel buffer was passed to the constructor; it
                     only applies to dynamic allocation. ICAP_REALLOC_NONE
@@ -90,7 +104,8 @@ public:
                     go unused but avoids fragmentation).
     @return  Status code. ICAP_STATUS_OK on successful update, may return
              ICAP_STATUS_ERR_MALLOC if using dynamic allocation and the
-             buffer resize fails.
+             buffer resize fails, or ICAP_STATUS_ERR_PERIPHERAL if the
+             colorspace isn't supported.
     @note    Reallocating the camera buffer is fraught with peril and should
              only be done if you're prepared to handle any resulting error.
              In most cases, code should call the constructor with a static
@@ -106,9 +121,19 @@ public:
 
   /*!
     @brief  Configure camera colorspace.
-    @param  space  ICAP_COLOR_RGB565 or ICAP_COLOR_YUV.
+    @param  space  ICAP_COLOR_RGB565, ICAP_COLOR_YUV or ICAP_COLOR_JPEG
+                   (compressor on, at the default quality).
   */
   void setColorspace(iCap_colorspace space = ICAP_COLOR_RGB565);
+
+  /*!
+    @brief  Set JPEG compression level, when capturing ICAP_COLOR_JPEG.
+            Lower values give higher quality and larger frames; if frames
+            are dropped for overflowing the buffer, raise this.
+    @param  qs  Quantization scale, 2 (best quality) to 63 (smallest
+                frames). Default after config() is OV2640_QS_DEFAULT.
+  */
+  void setJPEGQuality(uint8_t qs = OV2640_QS_DEFAULT);
 };
 
 #endif // end ICAP_FULL_SUPPORT
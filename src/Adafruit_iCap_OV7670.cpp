@@ -127,6 +127,18 @@ static const iCap_parallel_config
     OV7670_yuv[] = {
         // Manual output format, YUV, use full output range
         {OV7670_REG_COM7, OV7670_COM7_YUV},
+        {OV7670_REG_COM15, OV7670_COM15_R00FF}},
+    OV7670_rgb444[] =
+        {
+            // Manual output format, RGB444 (xR GB), full 0-255 range.
+            // RGB444 register only takes effect with COM15 RGB565 set.
+            {OV7670_REG_COM7, OV7670_COM7_RGB},
+            {OV7670_REG_RGB444, OV7670_R444_ENABLE},
+            {OV7670_REG_COM15, OV7670_COM15_RGB565 | OV7670_COM15_R00FF}},
+    OV7670_bayer[] = {
+        // Manual output format, raw Bayer, one byte per pixel
+        {OV7670_REG_COM7, OV7670_COM7_BAYER},
+        {OV7670_REG_RGB444, 0},
         {OV7670_REG_COM15, OV7670_COM15_R00FF}};
 
 iCap_status Adafruit_iCap_OV7670::begin(void) {
@@ -187,6 +199,12 @@ iCap_status Adafruit_iCap_OV7670::config(OV7670_size size,
                                          uint8_t nbuf, iCap_realloc allo) {
   uint16_t width = 640 >> size;
   uint16_t height = 480 >> size;
+  if ((space == ICAP_COLOR_BAYER) && (size != OV7670_SIZE_DIV1)) {
+    return ICAP_STATUS_ERR_PERIPHERAL; // Scaler doesn't apply to raw Bayer
+  }
+  if (space == ICAP_COLOR_JPEG) {
+    return ICAP_STATUS_ERR_PERIPHERAL; // No compressor in this sensor
+  }
   suspend();
   iCap_status status = bufferConfig(width, height, space, nbuf, allo);
   if (status == ICAP_STATUS_OK) {
@@ -213,8 +231,10 @@ iCap_status Adafruit_iCap_OV7670::config(OV7670_size size,
     if (fps > 0.0) {
       delayMicroseconds((int)(10000000.0 / fps)); // 10 frame settling time
     }
-    dma_change(pixbuf[0], _width * _height);
-    resume(); // Start DMA cycle
+    status = dma_change(pixbuf[0], _width * _height);
+    if (status == ICAP_STATUS_OK) {
+      resume(); // Start DMA cycle
+    }
   } else {
     // Stop cam
   }
@@ -223,10 +243,20 @@ iCap_status Adafruit_iCap_OV7670::config(OV7670_size size,
 }
 
 void Adafruit_iCap_OV7670::setColorspace(iCap_colorspace space) {
-  if (space == ICAP_COLOR_RGB565) {
+  switch (space) {
+  case ICAP_COLOR_RGB565:
+  case ICAP_COLOR_RGB332: // Camera sends RGB565, capture packs to 8 bits
     writeList(OV7670_rgb, sizeof OV7670_rgb / sizeof OV7670_rgb[0]);
-  } else {
+    break;
+  case ICAP_COLOR_RGB444: // Camera sends xR GB, capture packs to 12 bits
+    writeList(OV7670_rgb444, sizeof OV7670_rgb444 / sizeof OV7670_rgb444[0]);
+    break;
+  case ICAP_COLOR_BAYER:
+    writeList(OV7670_bayer, sizeof OV7670_bayer / sizeof OV7670_bayer[0]);
+    break;
+  default: // YUV, or Y8 (camera sends YUV, capture keeps only Y)
     writeList(OV7670_yuv, sizeof OV7670_yuv / sizeof OV7670_yuv[0]);
+    break;
   }
 }
 
@@ -14,6 +14,9 @@
 #elif defined(ARDUINO_ARCH_RP2040)
 // Might want to derive this from F_CPU instead
 #define OV7670_XCLK_HZ 12500000 ///< XCLK to camera, 8-24 MHz
+#elif !defined(ARDUINO)
+// Host simulation (arch/host), nominal only; used for setFPS() math
+#define OV7670_XCLK_HZ ICAP_XCLK_HZ ///< XCLK to camera, 8-24 MHz
 #endif
 
 /** Supported sizes (VGA division factor) for OV7670_set_size() */
@@ -69,12 +72,14 @@ public:
     @param  pbufsize  Size of passed-in buffer (or 0 if NULL).
     @param  addr      I2C address of camera.
     @param  speed     I2C communication speed to camera.
-    @param  delay_us  Delay in microseconds between register writes.
+    @param  delay_us  Delay in microseconds after each register write
+                      transaction, 0 (default) for none. If camera init
+                      locks up on a particular MCU, try 1000.
   */
   Adafruit_iCap_OV7670(iCap_parallel_pins &pins, iCap_arch *arch = NULL,
                        TwoWire &twi = Wire, uint16_t *pbuf = NULL,
                        uint32_t pbufsize = 0, uint8_t addr = OV7670_ADDR,
-                       uint32_t speed = 100000, uint32_t delay_us = 1000);
+                       uint32_t speed = 100000, uint32_t delay_us = 0);
   ~Adafruit_iCap_OV7670();
 
   /*!
@@ -95,7 +100,8 @@ public:
                     (640x480), OV7670_SIZE_DIV2 (320x240), OV7670_SIZE_DIV4
                     (160x120), OV7670_SIZE_DIV8 and OV7670_SIZE_DIV16.
                     This argument is required.
-    @param   space  ICAP_COLOR_RGB565 (default) or ICAP_COLOR_YUV.
+    @param   space  ICAP_COLOR_RGB565 (default) or another colorspace,
+                    see setColorspace().
     @param   fps    Desired capture framerate, in frames per second, as a
                     float up to 30.0 (default). Actual device frame rate may
                     differ from this, depending on a host's available PWM
@@ -107,8 +113,9 @@ public:
                     you can call OV7670_set_fps(NULL, fps) at any time
                     before or after begin() and that will return the actual
                     resulting frame rate as a float.
-    @param   nbuf   Number of full-image buffers, 1-3. For now, always use
-                    1, multi-buffering isn't handled yet.
+    @param   nbuf   Number of full-image buffers, 1-3. With 2 or 3, use
+                    acquireFrame() and releaseFrame() to process frames
+                    while capture continues.
     @return  Status code. ICAP_STATUS_OK on successful init.
   */
   iCap_status begin(OV7670_size size, iCap_colorspace space = ICAP_COLOR_RGB565,
@@ -121,7 +128,8 @@ public:
                     (640x480), OV7670_SIZE_DIV2 (320x240), OV7670_SIZE_DIV4
                     (160x120), OV7670_SIZE_DIV8 and OV7670_SIZE_DIV16.
                     This argument is required.
-    @param   space  ICAP_COLOR_RGB565 (default) or ICAP_COLOR_YUV.
+    @param   space  ICAP_COLOR_RGB565 (default) or another colorspace,
+                    see setColorspace().
     @param   fps    Desired capture framerate, in frames per second, as a
                     float up to 30.0 (default). Actual device frame rate may
                     differ from this, depending on a host's available PWM
@@ -133,8 +141,9 @@ public:
                     you can call OV7670_set_fps(NULL, fps) at any time
                     before or after begin() and that will return the actual
                     resulting frame rate as a float.
-    @param   nbuf   Number of full-image buffers, 1-3. For now, always use
-                    1, multi-buffering isn't handled yet.
+    @param   nbuf   Number of full-image buffers, 1-3. With 2 or 3, use
+                    acquireFrame() and releaseFrame() to process frames
+                    while capture continues.
     @param   allo   (Re-)allocation behavior. This value is IGNORED if a
                     static pixel buffer was passed to the constructor; it
                     only applies to dynamic allocation. ICAP_REALLOC_NONE
@@ -146,7 +155,10 @@ public:
                     go unused but avoids fragmentation).
     @return  Status code. ICAP_STATUS_OK on successful update, may return
              ICAP_STATUS_ERR_MALLOC if using dynamic allocation and the
-             buffer resize fails.
+             buffer resize fails, or ICAP_STATUS_ERR_PERIPHERAL if the
+             capture peripheral can't produce the colorspace (or for
+             ICAP_COLOR_BAYER at other than OV7670_SIZE_DIV1, or
+             ICAP_COLOR_JPEG, which needs an in-camera compressor).
   */
   iCap_status config(OV7670_size size,
                      iCap_colorspace space = ICAP_COLOR_RGB565,
@@ -155,7 +167,14 @@ public:
 
   /*!
     @brief  Configure camera colorspace.
-    @param  space  ICAP_COLOR_RGB565 or ICAP_COLOR_YUV.
+    @param  space  ICAP_COLOR_RGB565, ICAP_COLOR_YUV, ICAP_COLOR_RGB444 or
+                   ICAP_COLOR_BAYER (raw BGGR, 8 bits/pixel; VGA only as
+                   the scaler doesn't apply, see demosaicRGB565() and
+                   demosaicY8()) set the sensor output directly.
+                   ICAP_COLOR_Y8 and ICAP_COLOR_RGB332 run the sensor in
+                   YUV or RGB565 and rely on the capture peripheral to
+                   reduce it (RGB332 and RGB444 capture are RP2040 only;
+                   config() returns an error elsewhere).
   */
   void setColorspace(iCap_colorspace space = ICAP_COLOR_RGB565);
 
@@ -0,0 +1,290 @@
+#include <Adafruit_iCap_QOI.h>
+#include <string.h>
+
+// Op tags, see class description
+#define ICAP_QOI_INDEX 0x00
+#define ICAP_QOI_DIFF 0x40
+#define ICAP_QOI_LUMA 0x80
+#define ICAP_QOI_RUN 0xC0
+#define ICAP_QOI_RAW 0xFF
+#define ICAP_QOI_MAX_RUN 63 // 0xC0 to 0xFE
+
+// Index table slot for a pixel
+#define ICAP_QOI_HASH(p) ((((uint32_t)(p) * 40503) >> 10) & 63)
+
+// Sign-extend the low n bits of v, i.e. a difference wrapped to a channel
+// of n bits
+#define ICAP_QOI_WRAP(v, n) ((int8_t)((uint8_t)(v) << (8 - (n))) >> (8 - (n)))
+
+// SETUP --------------------------------------------------------------------
+
+iCap_status Adafruit_iCap_QOI::begin(uint16_t width, uint16_t height,
+                                     iCap_colorspace space) {
+  if (((space != ICAP_COLOR_RGB565) && (space != ICAP_COLOR_YUV)) ||
+      !width || !height) {
+    return ICAP_STATUS_ERR_PERIPHERAL;
+  }
+  _width = width;
+  _height = height;
+  this->space = space;
+  memset(index, 0, sizeof index);
+  last = 0;
+  chroma[0] = chroma[1] = 128;
+  total = 0;
+  return ICAP_STATUS_OK;
+}
+
+uint8_t Adafruit_iCap_QOI::writeHeader(uint8_t *out) {
+  out[0] = 'i';
+  out[1] = 'Q';
+  out[2] = '1';
+  out[3] = '6';
+  out[4] = _width >> 8;
+  out[5] = _width;
+  out[6] = _height >> 8;
+  out[7] = _height;
+  out[8] = space;
+  out[9] = 0;
+  total += ICAP_QOI_HEADER;
+  return ICAP_QOI_HEADER;
+}
+
+iCap_status Adafruit_iCap_QOI::readHeader(const uint8_t *in) {
+  if (memcmp(in, "iQ16", 4) || in[9]) {
+    return ICAP_STATUS_ERR_PERIPHERAL;
+  }
+  return begin((in[4] << 8) | in[5], (in[6] << 8) | in[7],
+               (iCap_colorspace)in[8]);
+}
+
+// ENCODING -----------------------------------------------------------------
+
+// Code one YUV pixel (Y and its U or V, c) against the previous Y and the
+// last U or V, updating both, the run length and the output pointer.
+static inline void iCap_qoi_yuv(uint8_t y, uint8_t c, uint8_t &prev_y,
+                                uint8_t &prev_c, uint8_t &run, uint16_t *table,
+                                uint8_t *&o) {
+  if ((y == prev_y) && (c == prev_c)) {
+    if (++run == ICAP_QOI_MAX_RUN) {
+      *o++ = ICAP_QOI_RUN | (ICAP_QOI_MAX_RUN - 1);
+      run = 0;
+    }
+    return;
+  }
+  if (run) {
+    *o++ = ICAP_QOI_RUN | (run - 1);
+    run = 0;
+  }
+  uint16_t p = (y << 8) | c;
+  uint8_t h = ICAP_QOI_HASH(p);
+  if (table[h] == p) {
+    *o++ = ICAP_QOI_INDEX | h;
+  } else {
+    table[h] = p;
+    int8_t dy = y - prev_y, dc = c - prev_c;
+    if ((uint8_t)(dy + 8) < 16 && (uint8_t)(dc + 2) < 4) {
+      *o++ = ICAP_QOI_DIFF | ((dy + 8) << 2) | (dc + 2);
+    } else if ((uint8_t)(dy + 32) < 64) {
+      o[0] = ICAP_QOI_LUMA | (dy + 32);
+      o[1] = dc;
+      o += 2;
+    } else {
+      o[0] = ICAP_QOI_RAW;
+      o[1] = y;
+      o[2] = c;
+      o += 3;
+    }
+  }
+  prev_y = y;
+  prev_c = c;
+}
+
+uint32_t Adafruit_iCap_QOI::encodeRow(const uint8_t *pixels, uint8_t *out) {
+  uint8_t *o = out;
+  uint16_t *table = index;
+  uint16_t prev = last;
+  uint8_t run = 0;
+
+  if (space == ICAP_COLOR_RGB565) {
+    for (uint16_t x = _width; x--; pixels += 2) {
+      uint16_t p = (pixels[0] << 8) | pixels[1];
+      if (p == prev) {
+        if (++run == ICAP_QOI_MAX_RUN) {
+          *o++ = ICAP_QOI_RUN | (ICAP_QOI_MAX_RUN - 1);
+          run = 0;
+        }
+        continue;
+      }
+      if (run) {
+        *o++ = ICAP_QOI_RUN | (run - 1);
+        run = 0;
+      }
+      uint8_t h = ICAP_QOI_HASH(p);
+      if (table[h] == p) {
+        *o++ = ICAP_QOI_INDEX | h;
+      } else {
+        table[h] = p;
+        int8_t dr = ICAP_QOI_WRAP((p >> 11) - (prev >> 11), 5);
+        int8_t dg = ICAP_QOI_WRAP((p >> 5) - (prev >> 5), 6);
+        int8_t db = ICAP_QOI_WRAP(p - prev, 5);
+        if ((uint8_t)(dr + 2) < 4 && (uint8_t)(dg + 2) < 4 &&
+            (uint8_t)(db + 2) < 4) {
+          *o++ = ICAP_QOI_DIFF | ((dr + 2) << 4) | ((dg + 2) << 2) | (db + 2);
+        } else {
+          int8_t drg = ICAP_QOI_WRAP(dr - (dg >> 1), 5);
+          int8_t dbg = ICAP_QOI_WRAP(db - (dg >> 1), 5);
+          if ((uint8_t)(drg + 8) < 16 && (uint8_t)(dbg + 8) < 16) {
+            o[0] = ICAP_QOI_LUMA | (dg + 32);
+            o[1] = ((drg + 8) << 4) | (dbg + 8);
+            o += 2;
+          } else {
+            o[0] = ICAP_QOI_RAW;
+            o[1] = p >> 8;
+            o[2] = p;
+            o += 3;
+          }
+        }
+      }
+      prev = p;
+    }
+  } else { // YUV
+    // Y is predicted from the previous pixel, U or V from the last of its
+    // kind. Pixel pairs, then any odd one at the end (which has a U).
+    uint8_t py = prev, u = chroma[0], v = chroma[1];
+    uint16_t x = _width;
+    for (; x >= 2; x -= 2, pixels += 4) {
+      iCap_qoi_yuv(pixels[0], pixels[1], py, u, run, table, o);
+      iCap_qoi_yuv(pixels[2], pixels[3], py, v, run, table, o);
+    }
+    if (x) {
+      iCap_qoi_yuv(pixels[0], pixels[1], py, u, run, table, o);
+    }
+    prev = py;
+    chroma[0] = u;
+    chroma[1] = v;
+  }
+
+  if (run) {
+    *o++ = ICAP_QOI_RUN | (run - 1);
+  }
+  last = prev;
+  total += o - out;
+  return o - out;
+}
+
+#if defined(ICAP_FULL_SUPPORT)
+
+iCap_status Adafruit_iCap_QOI::encode(const iCap_view &view, iCap_sink sink,
+                                      void *context, uint8_t *buf) {
+  iCap_status status = begin(view.width, view.height, view.space);
+  if (status != ICAP_STATUS_OK) {
+    return status;
+  }
+  uint8_t header[ICAP_QOI_HEADER];
+  writeHeader(header);
+  if (sink(context, header, ICAP_QOI_HEADER) != ICAP_QOI_HEADER) {
+    return ICAP_STATUS_ERR_WRITE;
+  }
+  const uint8_t *row = view.pixels;
+  for (uint16_t y = 0; y < _height; y++, row += _width * 2) {
+    uint32_t len = encodeRow(row, buf);
+    if (sink(context, buf, len) != len) {
+      return ICAP_STATUS_ERR_WRITE;
+    }
+  }
+  return ICAP_STATUS_OK;
+}
+
+#endif // end ICAP_FULL_SUPPORT
+
+// DECODING -----------------------------------------------------------------
+
+uint32_t Adafruit_iCap_QOI::decodeRow(const uint8_t *in, uint32_t len,
+                                      uint8_t *pixels) {
+  const uint8_t *i = in, *end = in + len;
+  uint16_t *table = index;
+  uint16_t prev = last;
+  uint8_t c[2] = {chroma[0], chroma[1]};
+  bool yuv = (space == ICAP_COLOR_YUV);
+
+  for (uint16_t x = 0; x < _width;) {
+    if (i >= end) {
+      return 0;
+    }
+    uint8_t tag = *i++;
+    if ((tag >= ICAP_QOI_RUN) && (tag != ICAP_QOI_RAW)) {
+      uint8_t n = (tag & 63) + 1;
+      if (n > _width - x) {
+        return 0;
+      }
+      if (yuv) {
+        for (; n--; x++, pixels += 2) {
+          pixels[0] = prev;
+          pixels[1] = c[x & 1];
+        }
+      } else {
+        for (x += n; n--; pixels += 2) {
+          pixels[0] = prev >> 8;
+          pixels[1] = prev;
+        }
+      }
+      continue;
+    }
+
+    uint16_t p;
+    if (tag < ICAP_QOI_DIFF) {
+      p = table[tag];
+    } else if (tag == ICAP_QOI_RAW) {
+      if (end - i < 2) {
+        return 0;
+      }
+      p = (i[0] << 8) | i[1];
+      i += 2;
+    } else if (yuv) {
+      uint8_t y = prev, pc = c[x & 1];
+      if (tag < ICAP_QOI_LUMA) {
+        y += ((tag >> 2) & 15) - 8;
+        pc += (tag & 3) - 2;
+      } else {
+        if (i >= end) {
+          return 0;
+        }
+        y += (tag & 63) - 32;
+        pc += *i++;
+      }
+      p = (y << 8) | pc;
+    } else {
+      int8_t dr, dg, db;
+      if (tag < ICAP_QOI_LUMA) {
+        dr = ((tag >> 4) & 3) - 2;
+        dg = ((tag >> 2) & 3) - 2;
+        db = (tag & 3) - 2;
+      } else {
+        if (i >= end) {
+          return 0;
+        }
+        dg = (tag & 63) - 32;
+        dr = (*i >> 4) - 8 + (dg >> 1);
+        db = (*i++ & 15) - 8 + (dg >> 1);
+      }
+      p = ((((prev >> 11) + dr) & 31) << 11) |
+          ((((prev >> 5) + dg) & 63) << 5) | ((prev + db) & 31);
+    }
+    table[ICAP_QOI_HASH(p)] = p;
+    pixels[0] = p >> 8;
+    pixels[1] = p;
+    pixels += 2;
+    if (yuv) {
+      prev = p >> 8;
+      c[x & 1] = p;
+    } else {
+      prev = p;
+    }
+    x++;
+  }
+
+  last = prev;
+  chroma[0] = c[0];
+  chroma[1] = c[1];
+  return i - in;
+}
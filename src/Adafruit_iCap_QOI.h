@@ -0,0 +1,169 @@
+/*!
+ * @file Adafruit_iCap_QOI.h
+ *
+ * Lossless QOI-style codec for 16-bit Adafruit_ImageCapture frames
+ * (RGB565 and YUV), for archival and debugging where JPEG won't do.
+ *
+ * Adafruit invests time and resources providing this open source code,
+ * please support Adafruit and open-source hardware by purchasing
+ * products from Adafruit!
+ *
+ * MIT license, all text here must be included in any redistribution.
+ */
+
+#pragma once
+
+#include <Adafruit_ImageCapture.h>
+
+#define ICAP_QOI_HEADER 10 ///< Stream header bytes, see writeHeader()
+
+/*!
+    @brief  Lossless encoder and decoder in the manner of QOI ("Quite OK
+            Image" format), with its ops redone for 16-bit big-endian
+            pixels. Each pixel is coded against a prediction -- the
+            previous pixel for RGB565; for YUV the previous Y and the last
+            U or V -- as a run of exact predictions, a hit in a 64-entry
+            table of recent values, a small per-channel difference (1 or 2
+            bytes) or a raw value (3 bytes). Work goes a row at a time into
+            a caller's buffer of maxRowBytes(), so nothing needs holding
+            but that row; rows must be encoded and decoded in order, as
+            each continues from the last. Decoding doesn't need
+            ICAP_FULL_SUPPORT, so an I2C host can expand frames sent by a
+            camera peripheral. The object is about 140 bytes.
+
+            Stream layout: ICAP_QOI_HEADER bytes ("iQ16", width and height
+            big-endian, colorspace, 0), then the rows, as ops of 1 to 3
+            bytes:
+              00iiiiii           Index: table[i]
+              01rrggbb           RGB565 diff: R, G, B by r-2, g-2, b-2
+              01yyyycc           YUV diff: Y by y-8, U or V by c-2
+              10gggggg rrrrbbbb  RGB565 luma: G by g-32 (dg), R by
+                                 r-8+dg/2, B by b-8+dg/2
+              10yyyyyy cccccccc  YUV luma: Y by y-32, U or V by c
+              11nnnnnn           Run: n+1 pixels (1 to 63) as predicted
+              11111111 hi lo     Raw pixel (Y, then U or V for YUV)
+            Differences are from the prediction and wrap within each
+            channel's range. The table is indexed by the pixel's
+            ((p * 40503) >> 10) & 63 and takes every pixel not in a run.
+            Runs end at the end of each row.
+*/
+class Adafruit_iCap_QOI {
+public:
+  /*!
+    @brief  Constructor for Adafruit_iCap_QOI class. Nothing is set up
+            until begin() (or readHeader(), encode()).
+  */
+  Adafruit_iCap_QOI(void) {}
+
+  /*!
+    @brief   Start encoding or decoding a frame: reset the prediction state
+             for a new stream. Follow with writeHeader() and encodeRow()
+             calls, or decodeRow() calls.
+    @param   width   Image width in pixels.
+    @param   height  Image height in pixels.
+    @param   space   Pixel format, ICAP_COLOR_RGB565 or ICAP_COLOR_YUV.
+    @return  ICAP_STATUS_OK on success, ICAP_STATUS_ERR_PERIPHERAL if the
+             format isn't supported or the size is zero.
+  */
+  iCap_status begin(uint16_t width, uint16_t height, iCap_colorspace space);
+
+  /*!
+    @brief   Write the stream header for the frame given to begin().
+    @param   out  Destination, at least ICAP_QOI_HEADER bytes.
+    @return  Number of bytes written (ICAP_QOI_HEADER).
+  */
+  uint8_t writeHeader(uint8_t *out);
+
+  /*!
+    @brief   Start decoding a frame from its stream header, as begin().
+             The size and format are then available from width(),
+             height() and getColorspace().
+    @param   in  Stream header, ICAP_QOI_HEADER bytes.
+    @return  ICAP_STATUS_OK on success, ICAP_STATUS_ERR_PERIPHERAL if the
+             header isn't valid.
+  */
+  iCap_status readHeader(const uint8_t *in);
+
+  /*!
+    @brief   Get worst-case encoded size of one row, for sizing the buffer
+             passed to encodeRow().
+    @param   width  Image width in pixels.
+    @return  Size in bytes (3 per pixel).
+  */
+  static uint32_t maxRowBytes(uint16_t width) { return (uint32_t)width * 3; }
+
+  /*!
+    @brief   Compress the next row of the image.
+    @param   pixels  Row of width() pixels in the format given to begin(),
+                     e.g. camera buffer plus row * width * 2 bytes. Need not
+                     be aligned.
+    @param   out     Destination, at least maxRowBytes() bytes.
+    @return  Number of bytes written to out (at least 1).
+  */
+  uint32_t encodeRow(const uint8_t *pixels, uint8_t *out);
+
+  /*!
+    @brief   Expand the next row of the image.
+    @param   in      Encoded data, starting at the row. May run on past it
+                     (e.g. the whole rest of the stream), only what the row
+                     uses is read.
+    @param   len     Bytes available at in.
+    @param   pixels  Destination for width() pixels.
+    @return  Number of bytes of input used, 0 if the data is malformed or
+             ends within the row (the row is then incomplete, and the
+             stream can't be continued).
+  */
+  uint32_t decodeRow(const uint8_t *in, uint32_t len, uint8_t *pixels);
+
+#if defined(ICAP_FULL_SUPPORT)
+  /*!
+    @brief   Compress a whole image in RAM: begin(), then the header and
+             each row to the sink in turn (one call apiece). The image is
+             left intact.
+    @param   view     Image to compress, e.g. {(uint8_t *)cam.getBuffer(),
+                      cam.width(), cam.height(), cam.getColorspace()}.
+    @param   sink     Function receiving the compressed data.
+    @param   context  Passed through to sink, e.g. a File pointer.
+    @param   buf      Row buffer, at least maxRowBytes(view.width) bytes.
+    @return  ICAP_STATUS_OK on success, ICAP_STATUS_ERR_PERIPHERAL if the
+             format isn't supported, ICAP_STATUS_ERR_WRITE if the sink
+             failed (nothing more is sent after).
+  */
+  iCap_status encode(const iCap_view &view, iCap_sink sink, void *context,
+                     uint8_t *buf);
+#endif // end ICAP_FULL_SUPPORT
+
+  /*!
+    @brief   Get the amount of data encoded since begin(), header included.
+    @return  Size in bytes; the complete stream size once the last row is
+             encoded.
+  */
+  uint32_t bytesWritten(void) { return total; }
+
+  /*!
+    @brief   Get image width given to begin() or read from a header.
+    @return  Width in pixels.
+  */
+  uint16_t width(void) { return _width; }
+
+  /*!
+    @brief   Get image height given to begin() or read from a header.
+    @return  Height in pixels.
+  */
+  uint16_t height(void) { return _height; }
+
+  /*!
+    @brief   Get pixel format given to begin() or read from a header.
+    @return  ICAP_COLOR_RGB565 or ICAP_COLOR_YUV.
+  */
+  iCap_colorspace getColorspace(void) { return space; }
+
+protected:
+  uint16_t index[64];             ///< Recently seen pixels, by hash
+  uint16_t last = 0;              ///< Previous pixel (YUV: its Y)
+  uint8_t chroma[2] = {128, 128}; ///< YUV: last U, last V
+  uint32_t total = 0;             ///< Bytes encoded since begin()
+  uint16_t _width = 0;            ///< Image width in pixels
+  uint16_t _height = 0;           ///< Image height in pixels
+  iCap_colorspace space;          ///< Pixel format
+};
@@ -30,6 +30,7 @@ iCap_status Adafruit_iCap_parallel::begin() {
 #endif
   wire->begin();
   wire->setClock(i2c_speed);
+  config_us = 0;
 
   // Set up parallel capture peripheral & DMA. Camera is initially suspended,
   // calling code resumes cam DMA only after I2C init sequence is sent.
@@ -72,11 +73,35 @@ void Adafruit_iCap_parallel::writeRegister(uint8_t reg, uint8_t value) {
 }
 
 void Adafruit_iCap_parallel::writeList(const iCap_parallel_config *cfg,
-                                       uint16_t len) {
-  for (int i = 0; i < len; i++) {
-    writeRegister(cfg[i].reg, cfg[i].value);
-    delayMicroseconds(i2c_delay_us); // Some cams require, else lockup on init
+                                       uint16_t len,
+                                       const iCap_parallel_pause *pause,
+                                       uint16_t pauses) {
+  uint32_t start = micros();
+  for (uint16_t i = 0; i < len;) {
+    uint16_t stop = (pauses && (pause->after < len)) ? pause->after + 1 : len;
+    uint16_t n = 1; // Registers in this transaction
+    if (i2c_burst) {
+      while ((i + n < stop) && (n < ICAP_I2C_BURST) &&
+             (cfg[i + n].reg == cfg[i].reg + n)) {
+        n++;
+      }
+    }
+    wire->beginTransmission(i2c_address);
+    wire->write(cfg[i].reg);
+    for (uint16_t end = i + n; i < end; i++) {
+      wire->write(cfg[i].value);
+    }
+    wire->endTransmission();
+    if (i2c_delay_us) {
+      delayMicroseconds(i2c_delay_us); // Only if MCU or cam requires
+    }
+    if (pauses && (i == pause->after + 1)) { // Camera acting on last entry
+      delay(pause->ms);
+      pause++;
+      pauses--;
+    }
   }
+  config_us += micros() - start;
 }
 
 #endif // end ICAP_FULL_SUPPORT
@@ -6,6 +6,8 @@
 
 #include <Wire.h>
 
+#define ICAP_I2C_BURST 31 ///< Max registers per burst write (+1 address byte)
+
 /** Pin identifiers for parallel+I2C cameras. */
 typedef struct {
   iCap_pin enable;  ///< Also called PWDN, or set to -1 and tie to GND
@@ -25,6 +27,14 @@ typedef struct {
   uint8_t value; ///< Value to store
 } iCap_parallel_config;
 
+/** Pause within a register list, for a setting the camera needs time to
+    act on (e.g. reset). Kept in a table alongside the list rather than in
+    it, so no register address or value is reserved as a marker. */
+typedef struct {
+  uint16_t after; ///< Index of list entry to pause after
+  uint16_t ms;    ///< Pause in milliseconds
+} iCap_parallel_pause;
+
 /*!
     @brief  Class encapsulating functionality common to image sensors using
             a parallel data interface + I2C for configuration. (This is the
@@ -55,9 +65,11 @@ public:
                       used for I2C communication with camera.
     @param  addr      I2C address of camera.
     @param  speed     I2C speed in Hz (100000 typ.)
-    @param  delay_us  Delay, in microseconds, between I2C commands (some
-                      MCUs and/or cameras may cause lockup without some
-                      delay).
+    @param  delay_us  Delay, in microseconds, after each I2C write
+                      transaction, or 0 for none. Settling time the camera
+                      needs (e.g. after reset) is handled separately; this
+                      is only for MCUs and/or cameras that lock up without
+                      some delay.
   */
   Adafruit_iCap_parallel(iCap_parallel_pins *pins_ptr, iCap_arch *arch,
                          uint16_t *pbuf, uint32_t pbufsize, TwoWire *twi_ptr,
@@ -85,7 +97,7 @@ public:
     @param   height    Image capture height in pixels (must match expected
                        data from camera).
     @param   space     One of the iCap_colorspace enumeration values;
-                       currently has settings for RGB or YUV, 16 bits/pixel.
+                       RGB or YUV (16 bits/pixel) or Y8 (8 bits/pixel).
     @param   nbuf      Number of full-image buffers, 1-3.
     @return  Status code. ICAP_STATUS_OK on successful init.
     @note    Allocation behavior is implicit, NOT passed to this function.
@@ -114,11 +126,44 @@ public:
   void writeRegister(uint8_t reg, uint8_t value);
 
   /*!
-    @brief  Writes a list of settings to the camera over I2C.
-    @param  cfg  Array (pointer-to) of settings to write.
-    @param  len  Length of array.
+    @brief  Writes a list of settings to the camera over I2C. With burst
+            writes enabled (see setBurstWrite()), each run of consecutive
+            register addresses goes in a single transaction, else one
+            transaction per register, each followed by the delay_us given
+            to the constructor. Entries the camera needs longer to act on
+            (e.g. reset) are each given a pause, which also ends any burst.
+    @param  cfg     Array (pointer-to) of settings to write.
+    @param  len     Length of array.
+    @param  pause   Array (pointer-to) of pauses, in list order, or NULL.
+    @param  pauses  Length of pause array.
+  */
+  void writeList(const iCap_parallel_config *cfg, uint16_t len,
+                 const iCap_parallel_pause *pause = NULL,
+                 uint16_t pauses = 0);
+
+  /*!
+    @brief  Enable or disable burst writes in writeList(): the register
+            address sent once, then up to ICAP_I2C_BURST values, stored by
+            the camera at successive addresses (auto-increment). Off by
+            default, and neither supported camera enables it: OmniVision
+            documents SCCB writes to the OV7670 and OV2640 as one register
+            per transaction, with no auto-increment, so on those the burst
+            would all land in its first register. For cameras that do
+            auto-increment, far fewer bytes cross the bus.
+    @param  enable  true to use burst writes, false for one register per
+                    transaction.
+  */
+  void setBurstWrite(bool enable) { i2c_burst = enable; }
+
+  /*!
+    @brief   Get time spent sending register lists (writeList(), including
+             any delay_us and list pauses) since begin(), for measuring
+             startup and reconfiguration cost. Fixed waits elsewhere
+             (power-up, reset, settling after a mode change) aren't
+             included.
+    @return  Time in microseconds.
   */
-  void writeList(const iCap_parallel_config *cfg, uint16_t len);
+  uint32_t configTime(void) { return config_us; }
 
   /*!
     @brief  Pause DMA background capture (if supported by architecture)
@@ -126,6 +171,10 @@ public:
             current frame has finished loading. If DMA background capture
             is not supported, this function has no effect. This is NOT a
             camera sleep function!
+    @note   This waits for the current frame to finish (up to a full
+            frame period). With multi-buffering, waitFrame() or
+            acquireFrame() plus setFrameCallback() avoid this stall, and
+            capture continues while a frame is processed.
   */
   void suspend(void);
 
@@ -152,17 +201,22 @@ protected:
   iCap_status pcc_start(void);
 
   /*!
-    @brief   Change PCC DMA destination and count.
+    @brief   Change PCC DMA destination and count. Transfer size follows
+             the current colorspace setting (see bitsPerPixel()).
     @param   dest        Destination for data received from camera.
     @param   num_pixels  Number of pixels in image.
+    @return  ICAP_STATUS_OK on success, ICAP_STATUS_ERR_PERIPHERAL if the
+             capture peripheral can't produce this colorspace.
   */
-  void dma_change(uint16_t *dest, uint32_t num_pixels);
+  iCap_status dma_change(uint16_t *dest, uint32_t num_pixels);
 
   TwoWire *wire;           ///< Associated I2C instance
   iCap_parallel_pins pins; ///< Pin structure (copied in constructor)
   uint32_t i2c_speed;      ///< I2C bus speed
-  uint32_t i2c_delay_us;   ///< Delay in microseconds between I2C writes
+  uint32_t i2c_delay_us;   ///< Delay in microseconds after I2C writes
+  uint32_t config_us = 0;  ///< Time in writeList() since begin()
   uint8_t i2c_address;     ///< Camera I2C address
+  bool i2c_burst = false;  ///< writeList() uses auto-increment writes
 };
 
 #endif // end ICAP_FULL_SUPPORT
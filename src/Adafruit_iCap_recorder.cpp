@@ -0,0 +1,291 @@
+#include <Adafruit_iCap_recorder.h>
+#include <Arduino.h>
+
+#if defined(ICAP_FULL_SUPPORT)
+
+// AVI layout (all of it little-endian RIFF chunks):
+// RIFF 'AVI '
+//   LIST 'hdrl'
+//     avih        Main header: frame period, count, size...
+//     LIST 'strl'
+//       strh      Stream header: 'vids' 'MJPG', frame rate as scale/rate
+//       strf      BITMAPINFOHEADER
+//   LIST 'movi'   Starts at ICAP_RECORDER_AVI_HEADER - 12
+//     [JUNK]      Padding, so the following frame data is aligned
+//     00dc        One JPEG image, plus a pad byte if odd length
+//     ...
+//   idx1          '00dc', keyframe flag, offset from 'movi', length
+#define ICAP_AVI_MOVI (ICAP_RECORDER_AVI_HEADER - 4) // 'movi' position
+#define ICAP_AVI_KEYFRAME 0x10                      // idx1 flag
+#define ICAP_AVI_HASINDEX 0x10                      // avih flag
+
+Adafruit_iCap_recorder::~Adafruit_iCap_recorder() {
+  if (allocated) {
+    free(index);
+  }
+}
+
+// HEADERS ------------------------------------------------------------------
+
+void Adafruit_iCap_recorder::putFourCC(const char *fourcc) {
+  for (uint8_t i = 0; i < 4; i++) {
+    put(fourcc[i]);
+  }
+}
+
+void Adafruit_iCap_recorder::putHeader(void) {
+  uint16_t w = cam->width(), h = cam->height();
+  uint32_t n = record_stats.frames;
+
+  if (!avi) {
+    putFourCC("iCR1");
+    putLE(w, 2);
+    putLE(h, 2);
+    putLE(cam->getColorspace(), 4); // Colorspace and 3 reserved bytes
+    putLE(n, 4);                    // Frame count
+    putLE(data_end, 4);             // Index position
+    return;
+  }
+
+  // Frame period from the timestamps; nominal 30 fps until there are two
+  uint32_t us = (n > 1) ? (record_stats.elapsed_us + (n - 1) / 2) / (n - 1)
+                        : 0;
+  if (!us) {
+    us = 33333;
+  }
+  uint32_t chunk_max = max_bytes + 8; // Largest 00dc chunk
+
+  putFourCC("RIFF");
+  putLE(data_end + 16 * n, 4); // Size after this: to end of idx1
+  putFourCC("AVI ");
+  putFourCC("LIST");
+  putLE(192, 4); // hdrl list size
+  putFourCC("hdrl");
+  putFourCC("avih");
+  putLE(56, 4);
+  putLE(us, 4);                                 // Microseconds/frame
+  putLE((uint64_t)max_bytes * 1000000 / us, 4); // Max bytes/second
+  putLE(ICAP_RECORDER_ALIGN, 4);                // Padding granularity
+  putLE(ICAP_AVI_HASINDEX, 4);                  // Flags
+  putLE(n, 4);                                  // Total frames
+  putLE(0, 4);                                  // Initial frames
+  putLE(1, 4);                                  // Streams
+  putLE(chunk_max, 4);                          // Suggested buffer
+  putLE(w, 4);                                  // Width
+  putLE(h, 4);                                  // Height
+  for (uint8_t i = 0; i < 4; i++) {
+    putLE(0, 4); // Reserved
+  }
+  putFourCC("LIST");
+  putLE(116, 4); // strl list size
+  putFourCC("strl");
+  putFourCC("strh");
+  putLE(56, 4);
+  putFourCC("vids");
+  putFourCC("MJPG");
+  putLE(0, 4);          // Flags
+  putLE(0, 4);          // Priority, language
+  putLE(0, 4);          // Initial frames
+  putLE(us, 4);         // Scale...
+  putLE(1000000, 4);    // ...over rate is seconds/frame
+  putLE(0, 4);          // Start
+  putLE(n, 4);          // Length in frames
+  putLE(chunk_max, 4);  // Suggested buffer
+  putLE(0xFFFFFFFF, 4); // Quality (default)
+  putLE(0, 4);          // Sample size (varies)
+  putLE(0, 4);          // Frame rectangle: left, top...
+  putLE(w, 2);          // ...right...
+  putLE(h, 2);          // ...bottom
+  putFourCC("strf");
+  putLE(40, 4);
+  putLE(40, 4); // BITMAPINFOHEADER size
+  putLE(w, 4);
+  putLE(h, 4);
+  putLE(1, 2);  // Planes
+  putLE(24, 2); // Bits per pixel once decoded
+  putFourCC("MJPG");
+  putLE((uint32_t)w * h * 3, 4); // Decoded size
+  for (uint8_t i = 0; i < 4; i++) {
+    putLE(0, 4); // Resolution, colors
+  }
+  putFourCC("LIST");
+  putLE(data_end - ICAP_AVI_MOVI, 4); // movi list size
+  putFourCC("movi");
+}
+
+// RECORDING ----------------------------------------------------------------
+
+iCap_status Adafruit_iCap_recorder::begin(Adafruit_ImageCapture *cam,
+                                          iCap_sink sink, iCap_seek seek,
+                                          void *context, uint32_t max_frames,
+                                          iCap_record_entry *index) {
+  end(); // In case one was already going
+  if (!cam->width() || !cam->height()) {
+    return ICAP_STATUS_ERR_PERIPHERAL;
+  }
+  allocated = !index;
+  if (allocated && !(index = (iCap_record_entry *)malloc(
+                         max_frames * sizeof(iCap_record_entry)))) {
+    return ICAP_STATUS_ERR_MALLOC;
+  }
+  this->cam = cam;
+  this->sink = sink;
+  this->seek = seek;
+  this->context = context;
+  this->max_frames = max_frames;
+  this->index = index;
+  memset(&record_stats, 0, sizeof record_stats);
+  max_bytes = 0;
+  avi = (cam->getColorspace() == ICAP_COLOR_JPEG);
+  data_end = avi ? ICAP_RECORDER_AVI_HEADER : ICAP_RECORDER_RAW_HEADER;
+  out_len = 0;
+  total = 0;
+  status = ICAP_STATUS_OK;
+
+  putHeader(); // Totals are all 0 for now
+  if (cam->acquireFrame()) {
+    cam->releaseFrame(); // Discard frame that predates recording
+  }
+  return status;
+}
+
+iCap_status Adafruit_iCap_recorder::update(void) {
+  if (!cam || (status != ICAP_STATUS_OK)) {
+    return status;
+  }
+  if (full()) {
+    return ICAP_STATUS_OK;
+  }
+  uint8_t *frame = (uint8_t *)cam->acquireFrame();
+  if (!frame) {
+    return ICAP_STATUS_OK;
+  }
+  const iCap_frame_info *info = cam->frameInfo();
+  uint32_t bytes = info->bytes, n = record_stats.frames;
+  if (n) {
+    uint32_t gap = info->sequence - last_sequence - 1;
+    if (gap) { // Frames recycled or skipped since the last one written
+      record_stats.skipped += gap;
+      record_stats.stalls++;
+    }
+    record_stats.elapsed_us = info->timestamp_us - first_us;
+  } else {
+    first_us = info->timestamp_us;
+  }
+  last_sequence = info->sequence;
+
+  uint32_t start = micros();
+  // Pad so the frame data starts on an alignment boundary: zeros for raw,
+  // or for AVI a JUNK chunk (at least its 8-byte header) before the 00dc
+  // chunk header.
+  uint32_t pos = total + out_len;
+  if (avi) {
+    uint32_t junk = -(pos + 8) & (ICAP_RECORDER_ALIGN - 1);
+    if (junk) {
+      if (junk < 8) {
+        junk += ICAP_RECORDER_ALIGN;
+      }
+      putFourCC("JUNK");
+      putLE(junk - 8, 4);
+      while (junk-- > 8) {
+        put(0);
+      }
+    }
+    putFourCC("00dc");
+    putLE(bytes, 4);
+  } else {
+    while ((total + out_len) & (ICAP_RECORDER_ALIGN - 1)) {
+      put(0);
+    }
+  }
+  flush(); // Header bytes & padding, then the frame straight from the buffer
+  pos = total + out_len;
+  if (status == ICAP_STATUS_OK) {
+    uint32_t accepted = sink(context, frame, bytes);
+    total += accepted;
+    if (accepted != bytes) {
+      status = ICAP_STATUS_ERR_WRITE;
+    }
+  }
+  cam->releaseFrame();
+  uint32_t elapsed = micros() - start;
+  record_stats.write_us += elapsed;
+  if (elapsed > record_stats.write_max_us) {
+    record_stats.write_max_us = elapsed;
+  }
+
+  if (avi && (bytes & 1)) {
+    put(0); // RIFF chunks are word-aligned
+  }
+  data_end = pos + bytes + (avi & bytes & 1);
+  index[n].offset = pos;
+  index[n].bytes = bytes;
+  index[n].timestamp_us = record_stats.elapsed_us;
+  record_stats.frames++;
+  if (bytes > max_bytes) {
+    max_bytes = bytes;
+  }
+  return status;
+}
+
+iCap_status Adafruit_iCap_recorder::end(void) {
+  if (!cam) {
+    return status;
+  }
+  // Index follows the last frame (and any AVI pad byte) directly. After a
+  // sink failure, neither it nor the header totals are written.
+  if (status == ICAP_STATUS_OK) {
+    uint32_t n = record_stats.frames;
+    if (avi) {
+      putFourCC("idx1");
+      putLE(16 * n, 4);
+    }
+    for (uint32_t i = 0; i < n; i++) {
+      if (avi) { // Offset is to the chunk header, from 'movi'
+        putFourCC("00dc");
+        putLE(ICAP_AVI_KEYFRAME, 4);
+        putLE(index[i].offset - 8 - ICAP_AVI_MOVI, 4);
+        putLE(index[i].bytes, 4);
+      } else {
+        putLE(index[i].offset, 4);
+        putLE(index[i].bytes, 4);
+        putLE(index[i].timestamp_us, 4);
+      }
+    }
+  }
+  while (out_len) {
+    flush(); // (Discards anything left unsent after a failure)
+  }
+
+  // Header again, now with totals, then back to the end
+  uint32_t file_size = total;
+  if (status == ICAP_STATUS_OK) {
+    if (seek(context, 0)) {
+      putHeader();
+      flush();
+      if (!seek(context, file_size)) {
+        status = ICAP_STATUS_ERR_WRITE;
+      }
+    } else {
+      status = ICAP_STATUS_ERR_WRITE;
+    }
+  }
+  total = file_size;
+
+  if (allocated) {
+    free(index);
+    allocated = false;
+  }
+  index = NULL;
+  cam = NULL;
+  return status;
+}
+
+float Adafruit_iCap_recorder::fps(void) {
+  if ((record_stats.frames < 2) || !record_stats.elapsed_us) {
+    return 0.0;
+  }
+  return (record_stats.frames - 1) * 1000000.0 / record_stats.elapsed_us;
+}
+
+#endif // end ICAP_FULL_SUPPORT
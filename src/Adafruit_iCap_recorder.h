@@ -0,0 +1,185 @@
+/*!
+ * @file Adafruit_iCap_recorder.h
+ *
+ * Continuous frame recording (time-lapse, event clips) for
+ * Adafruit_ImageCapture, to any seekable sink: SD card, host file...
+ *
+ * Adafruit invests time and resources providing this open source code,
+ * please support Adafruit and open-source hardware by purchasing
+ * products from Adafruit!
+ *
+ * MIT license, all text here must be included in any redistribution.
+ */
+
+#pragma once
+
+#include <Adafruit_iCap_writer.h>
+
+#if defined(ICAP_FULL_SUPPORT)
+
+#define ICAP_RECORDER_ALIGN 512      ///< Frame data file position multiple
+#define ICAP_RECORDER_RAW_HEADER 20  ///< Raw container header bytes
+#define ICAP_RECORDER_AVI_HEADER 224 ///< AVI header bytes, through 'movi'
+
+/** Reposition a sink (e.g. File seek()) to a byte offset from the start of
+    the file, so the recorder can fill in its header once the totals are
+    known. Same context as the sink; returns true on success. */
+typedef bool (*iCap_seek)(void *context, uint32_t position);
+
+/** One recorded frame, see Adafruit_iCap_recorder::begin() */
+typedef struct {
+  uint32_t offset;       ///< Position of frame data in file
+  uint32_t bytes;        ///< Frame data length
+  uint32_t timestamp_us; ///< VSYNC time, relative to the first frame
+} iCap_record_entry;
+
+/** Recording counters, see Adafruit_iCap_recorder::stats() */
+typedef struct {
+  uint32_t frames;       ///< Frames written
+  uint32_t skipped;      ///< Camera frames not recorded (sequence gaps)
+  uint32_t stalls;       ///< Gaps, i.e. times the writes fell behind
+  uint32_t elapsed_us;   ///< First to last recorded frame's VSYNC
+  uint32_t write_us;     ///< Total time spent writing frames
+  uint32_t write_max_us; ///< Longest single frame write
+} iCap_record_stats;
+
+/*!
+    @brief  Frame recorder. Call update() often (e.g. each pass of loop());
+            each time a new frame has completed, it's acquired, written
+            straight from the camera buffer to the sink, and released.
+            With the camera double- or triple-buffered (nbuf 2 or 3), DMA
+            fills the other buffer(s) meanwhile, so writes overlap capture
+            and the preview can carry on from the same frames. If a write
+            takes longer than the buffers can cover, the camera recycles
+            or skips frames rather than tearing; the sequence gap is
+            counted in stats(). For time-lapse, call update() only at the
+            desired interval (frames passed over then count as skipped).
+            Frame data start on ICAP_RECORDER_ALIGN boundaries, so each is
+            a whole-sector write on SD cards, with no read-modify-write of
+            a partial sector.
+
+            The container depends on the camera's colorspace. JPEG frames
+            go to an AVI file (MJPEG, with an idx1 index and JUNK chunks
+            for alignment), playable as is. Anything else goes to a raw
+            container, all values little-endian: ICAP_RECORDER_RAW_HEADER
+            bytes ("iCR1", width and height 16-bit, colorspace, 3 zero
+            bytes, frame count and index position 32-bit), then the frames,
+            then the index, an iCap_record_entry per frame.
+
+            The header is written again by end() with the totals, hence
+            the seek function. The index is kept in RAM until then, 12
+            bytes per frame up to the limit given to begin(). The object is
+            a little over 512 bytes.
+*/
+class Adafruit_iCap_recorder : protected Adafruit_iCap_writer {
+public:
+  /*!
+    @brief  Constructor for Adafruit_iCap_recorder class. Nothing is set up
+            until begin().
+  */
+  Adafruit_iCap_recorder(void) {}
+  ~Adafruit_iCap_recorder(); // Destructor
+
+  /*!
+    @brief   Start a recording: write the file header. Recording starts
+             with the next frame to complete (any frame already waiting is
+             released). The camera's size and colorspace must not change
+             until end().
+    @param   cam         Camera, preferably with nbuf 2 or 3 (see
+                         bufferConfig()). Single-buffered works, but capture
+                         pauses during each write.
+    @param   sink        Function receiving the file data, e.g.
+                         iCap_print_sink (Arduino File) or
+                         iCap_host_file_sink (stdio FILE on the host).
+    @param   seek        Function repositioning the sink, e.g.
+                         iCap_host_file_seek on the host.
+    @param   context     Passed through to sink and seek, e.g. a File
+                         pointer.
+    @param   max_frames  Most frames to record; update() stops there (see
+                         full()).
+    @param   index       Static buffer of max_frames entries for the index,
+                         or NULL (default) for the library to allocate.
+    @return  ICAP_STATUS_OK on success, ICAP_STATUS_ERR_MALLOC if the index
+             couldn't be allocated, ICAP_STATUS_ERR_PERIPHERAL if the
+             camera has no frame size set, ICAP_STATUS_ERR_WRITE if the
+             sink failed.
+  */
+  iCap_status begin(Adafruit_ImageCapture *cam, iCap_sink sink, iCap_seek seek,
+                    void *context, uint32_t max_frames,
+                    iCap_record_entry *index = NULL);
+
+  /*!
+    @brief   Record the newest frame, if one has completed since the last
+             call; else return at once.
+    @return  ICAP_STATUS_OK if a frame was written, none was waiting, or
+             the recording is full() (the frame is left for other use),
+             ICAP_STATUS_ERR_WRITE if the sink failed (nothing more is
+             written, see end()).
+  */
+  iCap_status update(void);
+
+  /*!
+    @brief   Finish the recording: write the index, then the header again
+             with the totals. Frees the index if the library allocated it.
+             The sink is left at the end of the file, ready to close.
+    @return  ICAP_STATUS_OK on success, ICAP_STATUS_ERR_WRITE if the sink
+             failed at any point in the recording. The index and header
+             totals are then not written, the file is left incomplete.
+  */
+  iCap_status end(void);
+
+  /*!
+    @brief   Test whether the recording has reached the max_frames given
+             to begin(), so update() records nothing more.
+    @return  true if full, else false (also if not recording).
+  */
+  bool full(void) { return cam && (record_stats.frames >= max_frames); }
+
+  /*!
+    @brief   Test whether a recording is in progress (begin() succeeded,
+             end() not yet called).
+    @return  true if recording, else false.
+  */
+  bool recording(void) { return cam != NULL; }
+
+  /*!
+    @brief   Get counters for the current or last recording.
+    @return  Copy of iCap_record_stats structure.
+  */
+  iCap_record_stats stats(void) { return record_stats; }
+
+  /*!
+    @brief   Get sustained frame rate of the current or last recording:
+             frames written over the time they span.
+    @return  Frames per second, 0.0 if fewer than two frames.
+  */
+  float fps(void);
+
+  using Adafruit_iCap_writer::bytesWritten; ///< File size so far
+
+protected:
+  /*!
+    @brief  Append the file header, with the totals recorded so far.
+  */
+  void putHeader(void);
+
+  /*!
+    @brief  Append a four-character code (AVI chunk ID).
+    @param  fourcc  Four characters, e.g. "RIFF".
+  */
+  void putFourCC(const char *fourcc);
+
+  Adafruit_ImageCapture *cam = NULL;   ///< Camera being recorded, or NULL
+  iCap_seek seek = NULL;               ///< Sink reposition function
+  iCap_record_entry *index = NULL;     ///< One per frame recorded
+  uint32_t max_frames = 0;             ///< Capacity of index[]
+  uint32_t max_bytes = 0;              ///< Largest frame recorded
+  uint32_t first_us = 0;               ///< First frame's VSYNC timestamp
+  uint32_t last_sequence = 0;          ///< Last frame's VSYNC count
+  uint32_t data_end = 0;               ///< End of frames, where index goes
+  iCap_record_stats record_stats = {}; ///< Counters
+  bool avi = false;                    ///< AVI (JPEG) or raw container
+  bool allocated = false;              ///< index[] is library-allocated
+};
+
+#endif // end ICAP_FULL_SUPPORT
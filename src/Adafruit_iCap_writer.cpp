@@ -0,0 +1,293 @@
+#include <Adafruit_iCap_writer.h>
+#include <Arduino.h>
+
+#if defined(ICAP_FULL_SUPPORT)
+
+// OUTPUT -------------------------------------------------------------------
+
+void Adafruit_iCap_writer::flush(void) {
+  // Full blocks keep SD writes sector-sized; the final one is whatever's
+  // left. Anything past a full block (part of a pixel) moves to the front.
+  uint16_t len =
+      (out_len >= ICAP_WRITER_OUTBUF) ? ICAP_WRITER_OUTBUF : out_len;
+  if (len && (status == ICAP_STATUS_OK)) {
+    uint32_t accepted = sink(context, out, len);
+    total += accepted;
+    if (accepted != len) {
+      status = ICAP_STATUS_ERR_WRITE;
+    }
+  }
+  out_len -= len;
+  memmove(out, &out[len], out_len);
+}
+
+void Adafruit_iCap_writer::put(uint8_t byte) {
+  out[out_len++] = byte;
+  if (out_len >= ICAP_WRITER_OUTBUF) {
+    flush();
+  }
+}
+
+void Adafruit_iCap_writer::putLE(uint32_t value, uint8_t size) {
+  while (size--) {
+    put(value);
+    value >>= 8;
+  }
+}
+
+void Adafruit_iCap_writer::putDecimal(uint16_t value) {
+  if (value >= 10) {
+    putDecimal(value / 10);
+  }
+  put('0' + value % 10);
+}
+
+// PIXEL CONVERSION ---------------------------------------------------------
+
+// Source-to-file conversions, chosen once per write()
+typedef enum {
+  ICAP_WRITE_RGB565_BMP = 0, // Byte swap to little-endian
+  ICAP_WRITE_YUV_BMP,        // YUV to little-endian RGB565
+  ICAP_WRITE_RGB565_RGB,     // RGB565 to 8-bit R, G, B
+  ICAP_WRITE_YUV_RGB,        // YUV to 8-bit R, G, B
+  ICAP_WRITE_Y8_RGB,         // Gray repeated as R, G, B
+  ICAP_WRITE_RGB565_GRAY,    // RGB565 to luma
+  ICAP_WRITE_YUV_GRAY,       // Y alone
+  ICAP_WRITE_Y8_GRAY,        // Straight copy (8-bit BMP or PGM)
+} iCap_write_mode;
+
+// Walks one file row through the source image, in whatever direction
+// rotation and mirroring call for.
+typedef struct {
+  const uint8_t *pixel; // Current source pixel
+  int32_t step;         // Bytes to the next one
+  int32_t x;            // Its column (YUV needs this to find U and V)
+  int32_t dx;           // Column change per pixel (0 if going vertically)
+} iCap_write_cursor;
+
+// YUV pixel to 8-bit RGB, with the same rounding as YUV2RGB565(): U from
+// the even pixel of the pair, V from the odd one (neutral if none).
+static inline void iCap_write_yuv(const uint8_t *p, int32_t x, uint16_t width,
+                                  int16_t *rgb) {
+  const uint8_t *pair = p - (x & 1) * 2;
+  int32_t y = p[0], u = pair[1] - 128;
+  int32_t v = ((x | 1) < width) ? pair[3] - 128 : 0;
+  rgb[0] = y + ((91881 * v + 32768) >> 16);
+  rgb[1] = y + ((-22554 * u + 32768) >> 16) + ((-46802 * v + 32768) >> 16);
+  rgb[2] = y + ((116130 * u + 32768) >> 16);
+  for (uint8_t c = 0; c < 3; c++) {
+    rgb[c] = (rgb[c] < 0) ? 0 : (rgb[c] > 255) ? 255 : rgb[c];
+  }
+}
+
+// Convert n pixels at the cursor to file format at dst, advancing the
+// cursor.
+static void iCap_write_span(iCap_write_cursor &cursor, uint16_t n,
+                            uint8_t *dst, iCap_write_mode mode,
+                            uint16_t width) {
+  const uint8_t *p = cursor.pixel;
+  int32_t step = cursor.step, x = cursor.x, dx = cursor.dx;
+  int16_t rgb[3];
+  switch (mode) {
+  case ICAP_WRITE_RGB565_BMP:
+    for (; n--; p += step, dst += 2) {
+      dst[0] = p[1];
+      dst[1] = p[0];
+    }
+    break;
+  case ICAP_WRITE_YUV_BMP:
+    for (; n--; p += step, x += dx, dst += 2) {
+      iCap_write_yuv(p, x, width, rgb);
+      uint16_t c = ((rgb[0] & 0xF8) << 8) | ((rgb[1] & 0xFC) << 3) |
+                   (rgb[2] >> 3);
+      dst[0] = c;
+      dst[1] = c >> 8;
+    }
+    break;
+  case ICAP_WRITE_RGB565_RGB:
+    for (; n--; p += step, dst += 3) {
+      uint8_t r = p[0] >> 3, g = ((p[0] & 7) << 3) | (p[1] >> 5);
+      uint8_t b = p[1] & 31;
+      dst[0] = (r << 3) | (r >> 2);
+      dst[1] = (g << 2) | (g >> 4);
+      dst[2] = (b << 3) | (b >> 2);
+    }
+    break;
+  case ICAP_WRITE_YUV_RGB:
+    for (; n--; p += step, x += dx, dst += 3) {
+      iCap_write_yuv(p, x, width, rgb);
+      dst[0] = rgb[0];
+      dst[1] = rgb[1];
+      dst[2] = rgb[2];
+    }
+    break;
+  case ICAP_WRITE_Y8_RGB:
+    for (; n--; p += step, dst += 3) {
+      dst[0] = dst[1] = dst[2] = *p;
+    }
+    break;
+  case ICAP_WRITE_RGB565_GRAY: // Same luma weights as compactY8()
+    for (; n--; p += step) {
+      uint16_t r = p[0] >> 3, g = ((p[0] & 7) << 3) | (p[1] >> 5);
+      uint16_t b = p[1] & 31;
+      *dst++ = (r * 630 + g * 608 + b * 240 + 128) >> 8;
+    }
+    break;
+  default: // Y of YUV, or Y8: first byte of each pixel
+    for (; n--; p += step) {
+      *dst++ = *p;
+    }
+    break;
+  }
+  cursor.pixel = p;
+  cursor.x = x;
+}
+
+// FILE ---------------------------------------------------------------------
+
+iCap_status Adafruit_iCap_writer::write(const iCap_view &view,
+                                        iCap_file_format format,
+                                        iCap_sink sink, void *context,
+                                        iCap_rotation rotation, bool mirror) {
+  this->sink = sink;
+  this->context = context;
+  out_len = 0;
+  total = 0;
+  status = ICAP_STATUS_OK;
+
+  iCap_write_mode mode;
+  uint8_t src_bytes = 2, file_bytes; // Bytes per pixel in & out
+  if (view.space == ICAP_COLOR_RGB565) {
+    mode = (format == ICAP_FILE_BMP)   ? ICAP_WRITE_RGB565_BMP
+           : (format == ICAP_FILE_PPM) ? ICAP_WRITE_RGB565_RGB
+                                       : ICAP_WRITE_RGB565_GRAY;
+  } else if (view.space == ICAP_COLOR_YUV) {
+    mode = (format == ICAP_FILE_BMP)   ? ICAP_WRITE_YUV_BMP
+           : (format == ICAP_FILE_PPM) ? ICAP_WRITE_YUV_RGB
+                                       : ICAP_WRITE_YUV_GRAY;
+  } else if (view.space == ICAP_COLOR_Y8) {
+    mode = (format == ICAP_FILE_PPM) ? ICAP_WRITE_Y8_RGB : ICAP_WRITE_Y8_GRAY;
+    src_bytes = 1;
+  } else {
+    return ICAP_STATUS_ERR_PERIPHERAL;
+  }
+  file_bytes = (format == ICAP_FILE_PPM)   ? 3
+               : (format == ICAP_FILE_PGM) ? 1
+                                           : src_bytes; // BMP: 16- or 8-bit
+
+  uint16_t w = view.width, h = view.height;
+  bool turn = rotation & 1; // 90 or 270, width & height swap
+  uint16_t file_w = turn ? h : w, file_h = turn ? w : h;
+  uint32_t row_bytes = (uint32_t)file_w * file_bytes;
+  uint8_t pad = (format == ICAP_FILE_BMP) ? (-row_bytes & 3) : 0;
+  uint32_t image_bytes = (row_bytes + pad) * file_h;
+
+  if (format == ICAP_FILE_BMP) {
+    bool gray = (file_bytes == 1); // 8-bit with palette, else bitfields
+    uint32_t offset = gray ? 14 + 40 + 256 * 4 : 14 + 56;
+    put('B');
+    put('M');
+    putLE(offset + image_bytes, 4); // File size
+    putLE(0, 4);                    // Creator bytes (ignored)
+    putLE(offset, 4);               // Offset to pixel data
+    putLE(gray ? 40 : 56, 4);       // DIB header size (V3 for bitfields)
+    putLE(file_w, 4);               // Width in pixels
+    putLE(file_h, 4);               // Height in pixels (rows go bottom to top)
+    putLE(1, 2);                    // Planes
+    putLE(gray ? 8 : 16, 2);        // Bits per pixel
+    putLE(gray ? 0 : 3, 4);         // Compression: none, or bitfields
+    putLE(image_bytes, 4);          // Pixel data size, with row padding
+    putLE(2835, 4);                 // Horizontal resolution (72 dpi)
+    putLE(2835, 4);                 // Vertical resolution
+    putLE(gray ? 256 : 0, 4);       // Colors in palette
+    putLE(0, 4);                    // "Important" colors (all)
+    if (gray) {
+      for (uint16_t i = 0; i < 256; i++) { // Gray ramp palette, B G R x
+        putLE(i * 0x010101, 4);
+      }
+    } else {
+      putLE(0xF800, 4); // Red mask
+      putLE(0x07E0, 4); // Green mask
+      putLE(0x001F, 4); // Blue mask
+      putLE(0, 4);      // Alpha mask
+    }
+  } else { // Netpbm binary, maximum value 255
+    put('P');
+    put((format == ICAP_FILE_PPM) ? '6' : '5');
+    put('\n');
+    putDecimal(file_w);
+    put(' ');
+    putDecimal(file_h);
+    put('\n');
+    putDecimal(255);
+    put('\n');
+  }
+
+  for (uint16_t row = 0; (row < file_h) && (status == ICAP_STATUS_OK);
+       row++) {
+    // Where the file row starts in the source, and which way it goes
+    uint16_t y = (format == ICAP_FILE_BMP) ? file_h - 1 - row : row;
+    int32_t sx, sy, dx = 0, dy = 0;
+    switch (rotation) {
+    case ICAP_ROTATE_90: // File row y is source column y, bottom to top
+      sx = y;
+      sy = h - 1;
+      dy = -1;
+      break;
+    case ICAP_ROTATE_180: // Source row from bottom, right to left
+      sx = w - 1;
+      sy = h - 1 - y;
+      dx = -1;
+      break;
+    case ICAP_ROTATE_270: // Source column from right, top to bottom
+      sx = w - 1 - y;
+      sy = 0;
+      dy = 1;
+      break;
+    default:
+      sx = 0;
+      sy = y;
+      dx = 1;
+      break;
+    }
+    if (mirror) { // Start from the other end
+      sx += dx * (file_w - 1);
+      sy += dy * (file_w - 1);
+      dx = -dx;
+      dy = -dy;
+    }
+    iCap_write_cursor cursor = {
+        view.pixels + (sy * w + sx) * src_bytes, (dy * w + dx) * src_bytes,
+        sx, dx};
+
+    // Convert as many pixels as will fill the current block (the last may
+    // spill past it), pass the block on, repeat.
+    for (uint16_t x = 0; x < file_w;) {
+      uint16_t n = (ICAP_WRITER_OUTBUF + file_bytes - 1 - out_len) /
+                   file_bytes;
+      if (n > file_w - x) {
+        n = file_w - x;
+      }
+      iCap_write_span(cursor, n, &out[out_len], mode, w);
+      out_len += n * file_bytes;
+      x += n;
+      if (out_len >= ICAP_WRITER_OUTBUF) {
+        flush();
+      }
+    }
+    for (uint8_t i = 0; i < pad; i++) { // BMP rows are 4-byte multiples
+      put(0);
+    }
+  }
+  flush();
+
+  return status;
+}
+
+#if defined(ARDUINO)
+uint32_t iCap_print_sink(void *context, const uint8_t *data, uint32_t len) {
+  return ((Print *)context)->write(data, len);
+}
+#endif
+
+#endif // end ICAP_FULL_SUPPORT
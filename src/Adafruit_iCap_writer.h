@@ -0,0 +1,128 @@
+/*!
+ * @file Adafruit_iCap_writer.h
+ *
+ * Image file output (BMP, PPM, PGM) for Adafruit_ImageCapture, to any
+ * sink: SD card, host file, network...
+ *
+ * Adafruit invests time and resources providing this open source code,
+ * please support Adafruit and open-source hardware by purchasing
+ * products from Adafruit!
+ *
+ * MIT license, all text here must be included in any redistribution.
+ */
+
+#pragma once
+
+#include <Adafruit_ImageCapture.h>
+
+#if defined(ICAP_FULL_SUPPORT)
+
+#define ICAP_WRITER_OUTBUF 512 ///< Bytes per sink call (last may be fewer)
+
+/** File formats for Adafruit_iCap_writer::write() */
+typedef enum {
+  ICAP_FILE_BMP = 0, ///< Windows BMP: 16-bit RGB565 bitfields, Y8 as 8-bit
+  ICAP_FILE_PPM,     ///< Netpbm binary color (P6), 8 bits per channel
+  ICAP_FILE_PGM,     ///< Netpbm binary grayscale (P5), 8 bits
+} iCap_file_format;
+
+/** Image rotation, clockwise, applied by Adafruit_iCap_writer::write() */
+typedef enum {
+  ICAP_ROTATE_0 = 0, ///< As captured
+  ICAP_ROTATE_90,    ///< Quarter turn clockwise (width & height swap)
+  ICAP_ROTATE_180,   ///< Half turn
+  ICAP_ROTATE_270,   ///< Quarter turn counterclockwise (w & h swap)
+} iCap_rotation;
+
+/*!
+    @brief  Image file writer. Pixels are converted a row span at a time
+            into a bounce buffer and handed to the sink in blocks of
+            ICAP_WRITER_OUTBUF bytes (sector-sized on SD cards), rather
+            than a call per pixel. Rotation and mirroring happen on the
+            way out, so the image in RAM is never modified. The object is
+            a little over 512 bytes.
+*/
+class Adafruit_iCap_writer {
+public:
+  /*!
+    @brief  Constructor for Adafruit_iCap_writer class. Nothing is set up
+            until write().
+  */
+  Adafruit_iCap_writer(void) {}
+
+  /*!
+    @brief   Write an image in RAM as a complete file.
+    @param   view      Image, e.g. {(uint8_t *)cam.getBuffer(), cam.width(),
+                       cam.height(), cam.getColorspace()}. ICAP_COLOR_RGB565,
+                       ICAP_COLOR_YUV (converted to RGB as YUV2RGB565() does,
+                       or Y alone for PGM) or ICAP_COLOR_Y8 (gray).
+    @param   format    File format. Color sources become gray for PGM, gray
+                       sources gray RGB for PPM.
+    @param   sink      Function receiving the file data, e.g.
+                       iCap_print_sink (Arduino File) or iCap_host_file_sink
+                       (stdio FILE on the host).
+    @param   context   Passed through to sink, e.g. a File pointer.
+    @param   rotation  Clockwise rotation of the output.
+    @param   mirror    If true, flip the output left-to-right (after
+                       rotation); with ICAP_ROTATE_180, flips top-to-bottom.
+    @return  ICAP_STATUS_OK on success, ICAP_STATUS_ERR_PERIPHERAL if the
+             source format isn't supported, ICAP_STATUS_ERR_WRITE if the
+             sink failed (nothing more is sent after).
+  */
+  iCap_status write(const iCap_view &view, iCap_file_format format,
+                    iCap_sink sink, void *context,
+                    iCap_rotation rotation = ICAP_ROTATE_0,
+                    bool mirror = false);
+
+  /*!
+    @brief   Get the amount of data passed to the sink by the last write().
+    @return  Size in bytes; the complete file size if write() succeeded.
+  */
+  uint32_t bytesWritten(void) { return total; }
+
+protected:
+  /*!
+    @brief  Append a header byte to the output buffer.
+    @param  byte  Value to append.
+  */
+  void put(uint8_t byte);
+
+  /*!
+    @brief  Append a little-endian value (BMP header field).
+    @param  value  Value to append.
+    @param  size   Number of bytes, 2 or 4.
+  */
+  void putLE(uint32_t value, uint8_t size);
+
+  /*!
+    @brief  Append a value as decimal text (Netpbm header field).
+    @param  value  Value to append.
+  */
+  void putDecimal(uint16_t value);
+
+  /*!
+    @brief  Pass buffered output to the sink: ICAP_WRITER_OUTBUF bytes, or
+            whatever's left at the end of the file.
+  */
+  void flush(void);
+
+  iCap_sink sink = NULL;               ///< Output function
+  void *context = NULL;                ///< Passed to sink
+  uint8_t out[ICAP_WRITER_OUTBUF + 3]; ///< Output buffer (+ pixel spill)
+  uint16_t out_len = 0;                ///< Bytes in out[]
+  uint32_t total = 0;                  ///< Bytes passed to sink
+  iCap_status status = ICAP_STATUS_OK; ///< First error, if any
+};
+
+#if defined(ARDUINO)
+/*!
+  @brief   iCap_sink for any Arduino Print, e.g. an SD library File.
+  @param   context  Print pointer, e.g. &file.
+  @param   data     Data to write.
+  @param   len      Number of bytes.
+  @return  Number of bytes written.
+*/
+uint32_t iCap_print_sink(void *context, const uint8_t *data, uint32_t len);
+#endif
+
+#endif // end ICAP_FULL_SUPPORT
@@ -0,0 +1,332 @@
+// This is the host-native (simulated) parts of camera interfacing. There's
+// no peripheral to configure; instead a thread stands in for the VSYNC and
+// end-of-DMA interrupts, so the rest of the library runs unchanged on a
+// workstation. See arch/host.h.
+
+#if !defined(ARDUINO)
+#include <Adafruit_iCap_parallel.h>
+#include <Arduino.h>
+#include <Wire.h>
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+HostSerial Serial;
+TwoWire Wire;
+
+// ARDUINO CORE STAND-INS --------------------------------------------------
+
+static const auto epoch = std::chrono::steady_clock::now();
+
+uint32_t micros(void) {
+  return std::chrono::duration_cast<std::chrono::microseconds>(
+             std::chrono::steady_clock::now() - epoch)
+      .count();
+}
+
+uint32_t millis(void) { return micros() / 1000; }
+
+void delay(uint32_t ms) {
+  std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+}
+
+void delayMicroseconds(uint32_t us) {
+  std::this_thread::sleep_for(std::chrono::microseconds(us));
+}
+
+void yield(void) { std::this_thread::yield(); }
+
+// Recursive, as a frame callback (running "in interrupt") may itself call
+// functions that disable interrupts, e.g. acquireFrame().
+static std::recursive_mutex irq_lock;
+
+void noInterrupts(void) { irq_lock.lock(); }
+
+void interrupts(void) { irq_lock.unlock(); }
+
+uint32_t iCap_host_file_sink(void *context, const uint8_t *data,
+                             uint32_t len) {
+  return fwrite(data, 1, len, (FILE *)context);
+}
+
+bool iCap_host_file_seek(void *context, uint32_t position) {
+  return !fseek((FILE *)context, position, SEEK_SET);
+}
+
+// SIMULATED CAPTURE -------------------------------------------------------
+
+// Same arrangement as the hardware ports: "interrupt" code runs outside
+// the class context, so pointers are kept (set in pcc_start()). Only a
+// single camera can be active.
+static Adafruit_ImageCapture *capptr = NULL; // Camera buffer, size, etc.
+static iCap_arch *archptr = NULL;            // Frame source settings
+static std::atomic<bool> frameReady(false);  // true at end-of-frame
+static std::atomic<bool> suspended(true);    // Initially stopped
+static std::atomic<bool> running(false);     // Capture thread active
+static std::atomic<uint32_t> dma_count(0);   // Pixels/frame
+static std::thread capture_thread;
+static FILE *source_file = NULL;
+static uint32_t source_frame = 0; // Frame # passed to generator
+static std::vector<uint16_t> src_frame; // 16-bit frame for other formats
+
+// Default frame source: a diagonal gradient that shifts each frame, so
+// consecutive frames differ and tearing would be visible.
+static void test_pattern(uint16_t *dest, uint32_t num_pixels,
+                         uint32_t frame) {
+  for (uint32_t i = 0; i < num_pixels; i++) {
+    dest[i] = __builtin_bswap16((uint16_t)(i + frame * 0x0841));
+  }
+}
+
+// Fill 16-bit frame from file, callback or test pattern.
+static void load_frame16(uint16_t *dest, uint32_t num_pixels) {
+  if (source_file) {
+    uint32_t n = fread(dest, 2, num_pixels, source_file);
+    if (n < num_pixels) { // End of file, loop back to first frame
+      rewind(source_file);
+      n += fread(&dest[n], 2, num_pixels - n, source_file);
+      memset(&dest[n], 0, (num_pixels - n) * 2); // Short file, pad
+    }
+  } else if (archptr->source) {
+    archptr->source(dest, num_pixels, source_frame);
+  } else {
+    test_pattern(dest, num_pixels, source_frame);
+  }
+  source_frame++;
+}
+
+// Default JPEG source: not a decodable image, just the markers the
+// capture path looks for around a payload whose length changes each frame
+// (and can't contain a marker), followed by stale-looking padding.
+static void test_jpeg(uint8_t *dest, uint32_t max_bytes, uint32_t frame) {
+  uint32_t len = max_bytes / 4 + (frame * 37) % (max_bytes / 2 + 1);
+  memset(dest, 0xFF, max_bytes);
+  if (len < 4) {
+    return; // Too small a buffer for even the markers
+  }
+  dest[0] = 0xFF; // SOI
+  dest[1] = 0xD8;
+  for (uint32_t i = 2; i < len - 2; i++) {
+    dest[i] = (i + frame) & 0x7F;
+  }
+  dest[len - 2] = 0xFF; // EOI
+  dest[len - 1] = 0xD9;
+}
+
+// This is the "DMA transfer" and happens outside the interrupt lock, as on
+// hardware. Formats under 16 bits/pixel are made from a 16-bit source
+// frame as the camera and capture peripheral would: Y8 keeps the luma
+// byte of YUV; RGB332, RGB444 and Bayer (BGGR, one channel per pixel,
+// scaled to 8 bits) come from RGB565. JPEG is passed through as bytes.
+static void load_frame(uint16_t *dest, uint32_t num_pixels) {
+  iCap_colorspace space = capptr->getColorspace();
+  if (Adafruit_ImageCapture::bitsPerPixel(space) == 16) {
+    load_frame16(dest, num_pixels);
+    return;
+  }
+  if (space == ICAP_COLOR_JPEG) {
+    uint32_t max_bytes = Adafruit_ImageCapture::frameBytes(
+        capptr->width(), capptr->height(), space);
+    if (source_file || archptr->source) {
+      load_frame16(dest, max_bytes / 2);
+    } else {
+      test_jpeg((uint8_t *)dest, max_bytes, source_frame++);
+    }
+    return;
+  }
+  src_frame.resize(num_pixels);
+  load_frame16(src_frame.data(), num_pixels);
+  const uint8_t *src = (const uint8_t *)src_frame.data();
+  uint8_t *dst = (uint8_t *)dest;
+  uint16_t width = capptr->width();
+  for (uint32_t i = 0; i < num_pixels; i++) {
+    uint16_t rgb = (src[i * 2] << 8) | src[i * 2 + 1];
+    uint8_t r = rgb >> 11, g = (rgb >> 5) & 63, b = rgb & 31;
+    switch (space) {
+    case ICAP_COLOR_Y8:
+      dst[i] = src[i * 2]; // Y is first byte of each big-endian pixel
+      break;
+    case ICAP_COLOR_RGB332:
+      dst[i] = ((r >> 2) << 5) | ((g >> 3) << 2) | (b >> 3);
+      break;
+    case ICAP_COLOR_RGB444: { // 12 bits, most significant nibble first
+      uint16_t p = ((r >> 1) << 8) | ((g >> 2) << 4) | (b >> 1);
+      if (i & 1) {
+        dst[i / 2 * 3 + 1] |= p >> 8;
+        dst[i / 2 * 3 + 2] = p;
+      } else {
+        dst[i / 2 * 3] = p >> 4;
+        dst[i / 2 * 3 + 1] = p << 4;
+      }
+    } break;
+    default: { // Bayer: B G on even rows, G R on odd rows
+      uint16_t x = i % width, y = i / width;
+      if ((x ^ y) & 1) {
+        dst[i] = (g << 2) | (g >> 4);
+      } else if (y & 1) {
+        dst[i] = (r << 3) | (r >> 2);
+      } else {
+        dst[i] = (b << 3) | (b >> 2);
+      }
+    } break;
+    }
+  }
+}
+
+// Stand-in for the VSYNC interrupt. Returns destination for the new frame,
+// or NULL if suspended or no buffer is available (frame skipped).
+static uint16_t *sim_vsync_irq(void) {
+  noInterrupts();
+  uint16_t *dest = suspended ? NULL : capptr->frameStart(micros());
+  frameReady = (dest == NULL); // Nothing loading, don't stall suspend()
+  interrupts();
+  return dest;
+}
+
+// Stand-in for the end-of-DMA interrupt. For JPEG this stands in for the
+// following VSYNC, and the transfer count isn't known (as on SAMD51).
+static void sim_dma_finish_irq(void) {
+  noInterrupts();
+  frameReady = true;
+  if (capptr->getColorspace() == ICAP_COLOR_JPEG) {
+    capptr->frameEnd(0); // Library finds the EOI
+  } else {
+    capptr->frameDone(dma_count); // Publish newest frame
+  }
+  interrupts();
+}
+
+// Stand-in for the VSYNC interrupt arriving while DMA is still busy, as
+// on SAMD51 and RP2040: the transfer is abandoned. For JPEG the library
+// checks what arrived for a whole image; otherwise the frame is discarded.
+static void sim_dma_abort_irq(uint32_t pixels) {
+  noInterrupts();
+  frameReady = true;
+  if (capptr->getColorspace() == ICAP_COLOR_JPEG) {
+    capptr->frameEnd(pixels * 2);
+  } else {
+    capptr->frameAbort(pixels);
+  }
+  interrupts();
+}
+
+void iCap_host_frame(void) {
+  uint16_t *dest = sim_vsync_irq();
+  if (dest) {
+    load_frame(dest, dma_count);
+    sim_dma_finish_irq();
+  }
+}
+
+void iCap_host_short_frame(uint32_t pixels) {
+  uint16_t *dest = sim_vsync_irq();
+  if (dest) {
+    // Whole frame is made (so file and generator sources stay in step),
+    // only the first part of it lands in the buffer.
+    iCap_colorspace space = capptr->getColorspace();
+    uint32_t max_bytes = Adafruit_ImageCapture::frameBytes(
+        capptr->width(), capptr->height(), space);
+    uint32_t bytes =
+        (space == ICAP_COLOR_JPEG)
+            ? pixels * 2
+            : ((uint64_t)pixels * Adafruit_ImageCapture::bitsPerPixel(space) +
+               7) / 8;
+    std::vector<uint16_t> frame((max_bytes + 1) / 2);
+    load_frame(frame.data(), dma_count);
+    memcpy(dest, frame.data(), (bytes < max_bytes) ? bytes : max_bytes);
+    sim_dma_abort_irq(pixels);
+  }
+}
+
+// Capture thread paces frames at the configured rate. The transfer is
+// given 3/4 of the frame period (roughly where VSYNC blanking begins on
+// a real sensor) so application code sees a realistic busy window.
+static void capture_loop(void) {
+  uint32_t period = archptr->frame_us ? archptr->frame_us : 33333;
+  auto next = std::chrono::steady_clock::now();
+  while (running) {
+    auto start = next;
+    next += std::chrono::microseconds(period);
+    uint16_t *dest = sim_vsync_irq();
+    if (dest) {
+      load_frame(dest, dma_count);
+      std::this_thread::sleep_until(start +
+                                    std::chrono::microseconds(period * 3 / 4));
+      sim_dma_finish_irq();
+    }
+    std::this_thread::sleep_until(next);
+  }
+}
+
+void iCap_host_stop(void) {
+  if (running) {
+    running = false;
+    capture_thread.join();
+  }
+  if (source_file) {
+    fclose(source_file);
+    source_file = NULL;
+  }
+}
+
+// Stop the thread at exit if the application didn't, so it's not torn
+// down mid-frame.
+static struct HostCleanup {
+  ~HostCleanup() { iCap_host_stop(); }
+} cleanup;
+
+// This is NOT a sleep function, it just pauses background "DMA".
+
+void Adafruit_iCap_parallel::suspend(void) {
+  if (!suspended) {
+    if (running) {
+      while (!frameReady)
+        yield();      // Wait for current frame to finish loading
+    }
+    suspended = true; // Don't load next frame
+  }
+}
+
+// NOT a wake function, just resumes background "DMA".
+
+void Adafruit_iCap_parallel::resume(void) {
+  frameReady = false;
+  suspended = false; // Resume transfers
+}
+
+// Nothing to clock, but keep the same sequence as hardware.
+iCap_status Adafruit_iCap_parallel::xclk_start(uint32_t freq) {
+  (void)freq;
+  return ICAP_STATUS_OK;
+}
+
+iCap_status Adafruit_iCap_parallel::pcc_start(void) {
+  iCap_host_stop(); // In case of repeated begin()
+  static iCap_arch defaults = {}; // If no arch struct passed
+  capptr = this;
+  archptr = arch ? arch : &defaults;
+  source_frame = 0;
+
+  if (archptr->filename && !(source_file = fopen(archptr->filename, "rb"))) {
+    return ICAP_STATUS_ERR_PERIPHERAL;
+  }
+
+  if (archptr->frame_us != ICAP_HOST_MANUAL) {
+    running = true;
+    capture_thread = std::thread(capture_loop);
+  }
+
+  return ICAP_STATUS_OK;
+}
+
+iCap_status Adafruit_iCap_parallel::dma_change(uint16_t *dest,
+                                               uint32_t num_pixels) {
+  (void)dest; // Destination is chosen per frame by frameStart()
+  dma_count = num_pixels;
+  return ICAP_STATUS_OK;
+}
+
+#endif // end !ARDUINO
@@ -0,0 +1,87 @@
+#pragma once
+
+// Simulated "architecture" for building the library natively on a Linux
+// or macOS workstation (anything that isn't an Arduino build). There's no
+// camera here; a background thread stands in for the VSYNC and DMA
+// interrupts and fills frames from a file, a callback or a test pattern.
+// This lets the capture, buffering and image-processing code be built,
+// profiled and regression-tested off-device. Compile with src/arch/host
+// in the include path (provides Arduino.h and a mock Wire.h) and supply
+// your own main().
+
+#if !defined(ARDUINO)
+
+#define ICAP_XCLK_HZ 12000000 // Nominal only, no clock is generated
+
+typedef int8_t iCap_pin;
+
+/*!
+  @brief  Callback type for generating simulated frames.
+  @param  dest        Destination buffer, big-endian 16-bit pixels (YUV
+                      for ICAP_COLOR_Y8, RGB565 for the other 8- and
+                      12-bit formats, which are derived from this). For
+                      ICAP_COLOR_JPEG, the camera's byte stream: an image
+                      from SOI to EOI, then anything (padding) to fill.
+  @param  num_pixels  Number of pixels to write (JPEG: half the bytes).
+  @param  frame       Frame number, incrementing from 0 (e.g. for motion).
+*/
+typedef void (*iCap_host_source)(uint16_t *dest, uint32_t num_pixels,
+                                 uint32_t frame);
+
+#define ICAP_HOST_MANUAL 0xFFFFFFFF ///< frame_us value: no thread, see below
+
+// Device-specific structure attached to Adafruit_ImageCapture.arch.
+// All fields may be left zero/NULL for a 30 fps test pattern.
+typedef struct {
+  uint32_t frame_us;       ///< Simulated frame period (0 = 33333 us)
+  const char *filename;    ///< Raw big-endian frames to loop, or NULL
+  iCap_host_source source; ///< Frame generator, used if no filename
+} iCap_arch;
+
+/*!
+  @brief  Simulate one complete frame (VSYNC, transfer, end-of-DMA) on the
+          calling thread, right now. For deterministic tests, set frame_us
+          to ICAP_HOST_MANUAL so no capture thread runs, and call this
+          wherever a frame should arrive.
+*/
+void iCap_host_frame(void);
+
+/*!
+  @brief  Simulate a frame cut short, for testing fault handling: VSYNC,
+          a transfer of only some of the frame, then the next VSYNC before
+          end-of-DMA (as with a glitch on PCLK), so the transfer is aborted
+          as on hardware. Like iCap_host_frame(), for ICAP_HOST_MANUAL use.
+  @param  pixels  Pixels transferred before the cut (JPEG: half the bytes,
+                  as with iCap_host_source). The rest of the buffer keeps
+                  whatever it held.
+*/
+void iCap_host_short_frame(uint32_t pixels);
+
+/*!
+  @brief  Stop the simulated capture thread and close any source file.
+          Call before the camera object is destroyed.
+*/
+void iCap_host_stop(void);
+
+/*!
+  @brief   iCap_sink writing to a stdio file, the host's stand-in for an SD
+           card File, so encoder and file writer output can be checked
+           byte-for-byte with ordinary tools.
+  @param   context  FILE pointer, opened for binary writing ("wb").
+  @param   data     Data to write.
+  @param   len      Number of bytes.
+  @return  Number of bytes written.
+*/
+uint32_t iCap_host_file_sink(void *context, const uint8_t *data,
+                             uint32_t len);
+
+/*!
+  @brief   iCap_seek for a stdio file, to go with iCap_host_file_sink (e.g.
+           for Adafruit_iCap_recorder).
+  @param   context   FILE pointer.
+  @param   position  Byte offset from start of file.
+  @return  true on success, false on failure.
+*/
+bool iCap_host_file_seek(void *context, uint32_t position);
+
+#endif // end !ARDUINO
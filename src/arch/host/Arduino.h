@@ -0,0 +1,87 @@
+#pragma once
+
+// Minimal stand-in for the Arduino core, for host-native builds only (see
+// arch/host.h). Covers just what this library and simple test programs
+// use; functions are implemented in arch/host.cpp.
+
+#include <math.h>
+#include <stdarg.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Arduino's min() and max() accept mixed argument types
+template <typename A, typename B>
+static inline auto min(A a, B b) -> decltype(a < b ? a : b) {
+  return a < b ? a : b;
+}
+template <typename A, typename B>
+static inline auto max(A a, B b) -> decltype(a > b ? a : b) {
+  return a > b ? a : b;
+}
+
+#define LOW 0
+#define HIGH 1
+#define INPUT 0
+#define OUTPUT 1
+
+#define PROGMEM
+#define pgm_read_byte(addr) (*(const uint8_t *)(addr))
+#define pgm_read_word(addr) (*(const uint16_t *)(addr))
+
+uint32_t millis(void);
+uint32_t micros(void);
+void delay(uint32_t ms);
+void delayMicroseconds(uint32_t us);
+void yield(void);
+
+// "Interrupts" on the host are the simulated-capture thread. Disabling
+// them takes a (recursive) lock that the thread holds while it's inside
+// frameStart()/frameDone(), so the same critical sections work unchanged.
+void noInterrupts(void);
+void interrupts(void);
+
+// GPIO is a no-op, there's nothing to wiggle
+static inline void pinMode(int pin, int mode) {
+  (void)pin;
+  (void)mode;
+}
+static inline void digitalWrite(int pin, int value) {
+  (void)pin;
+  (void)value;
+}
+
+/*!
+  @brief  Serial console stand-in, prints to stdout. Same print() and
+          println() overloads as Arduino's Print class (base 10 only).
+*/
+class HostSerial {
+public:
+  void begin(uint32_t baud) { (void)baud; }
+  operator bool() { return true; }
+  size_t print(const char *s) { return fputs(s, stdout) >= 0 ? strlen(s) : 0; }
+  size_t print(char c) { return putchar(c) != EOF; }
+  size_t print(int n) { return ::printf("%d", n); }
+  size_t print(unsigned int n) { return ::printf("%u", n); }
+  size_t print(long n) { return ::printf("%ld", n); }
+  size_t print(unsigned long n) { return ::printf("%lu", n); }
+  size_t print(double n, int digits = 2) {
+    return ::printf("%.*f", digits, n);
+  }
+  size_t println(void) { return print('\n'); }
+  template <typename T> size_t println(T value) {
+    return print(value) + println();
+  }
+  size_t println(double n, int digits) { return print(n, digits) + println(); }
+  size_t printf(const char *fmt, ...) {
+    va_list args;
+    va_start(args, fmt);
+    int n = vprintf(fmt, args);
+    va_end(args);
+    return n > 0 ? n : 0;
+  }
+  void flush(void) { fflush(stdout); }
+};
+
+extern HostSerial Serial;
@@ -0,0 +1,103 @@
+#pragma once
+
+// Mock TwoWire for host-native builds (see arch/host.h). Each 7-bit
+// address has a 256-byte register file using the usual camera convention:
+// the first byte of a write sets the register pointer, later bytes are
+// stored with auto-increment, and reads return bytes from the pointer
+// onward. Tests can preload or inspect registers directly, or turn off
+// auto-increment to act like a camera (e.g. SCCB) that stores every byte
+// of a write in the one register.
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#define BUFFER_LENGTH 256 ///< Max bytes per requestFrom()
+
+/*!
+  @brief  Register-file TwoWire stand-in. Not thread-safe; use only from
+          the main thread (same as I2C on device, never from a callback).
+*/
+class TwoWire {
+public:
+  TwoWire() { memset(regs, 0, sizeof regs); }
+  void begin(void) {}
+  void end(void) {}
+  void setClock(uint32_t freq) { clock = freq; }
+  void setSDA(int pin) { (void)pin; }
+  void setSCL(int pin) { (void)pin; }
+
+  void beginTransmission(uint8_t addr) {
+    address = addr & 0x7F;
+    first = true;
+  }
+  size_t write(uint8_t value) {
+    if (first) {
+      pointer[address] = value;
+      first = false;
+    } else {
+      regs[address][pointer[address]] = value;
+      pointer[address] += auto_increment;
+      writes++;
+    }
+    return 1;
+  }
+  size_t write(const uint8_t *data, size_t len) {
+    for (size_t i = 0; i < len; i++)
+      write(data[i]);
+    return len;
+  }
+  uint8_t endTransmission(bool stop = true) {
+    (void)stop;
+    transactions++;
+    return 0;
+  }
+  uint8_t requestFrom(uint8_t addr, uint8_t len, bool stop = true) {
+    (void)stop;
+    address = addr & 0x7F;
+    rx_len = len;
+    return len;
+  }
+  int available(void) { return rx_len; }
+  int read(void) {
+    if (!rx_len)
+      return -1;
+    rx_len--;
+    uint8_t value = regs[address][pointer[address]];
+    pointer[address] += auto_increment;
+    return value;
+  }
+
+  /*!
+    @brief  Preload a register, e.g. a sensor ID the driver checks.
+    @param  addr   7-bit device address.
+    @param  reg    Register number.
+    @param  value  Value to store.
+  */
+  void setRegister(uint8_t addr, uint8_t reg, uint8_t value) {
+    regs[addr & 0x7F][reg] = value;
+  }
+  /*!
+    @brief   Inspect a register as last written by driver code.
+    @param   addr  7-bit device address.
+    @param   reg   Register number.
+    @return  Register value.
+  */
+  uint8_t getRegister(uint8_t addr, uint8_t reg) {
+    return regs[addr & 0x7F][reg];
+  }
+
+  uint32_t clock = 100000;    ///< Last setClock() value
+  uint32_t writes = 0;        ///< Register bytes written, total
+  uint32_t transactions = 0;  ///< endTransmission() calls, total
+  bool auto_increment = true; ///< Register pointer advances per byte
+
+private:
+  uint8_t regs[128][256]; ///< Register file per address
+  uint8_t pointer[128];   ///< Register pointer per address
+  uint8_t address = 0;    ///< Current transaction address
+  uint8_t rx_len = 0;     ///< Bytes left in current read
+  bool first = false;     ///< Next write() byte is register pointer
+};
+
+extern TwoWire Wire;
@@ -0,0 +1,38 @@
+#pragma once
+
+// Plain C equivalents of the Cortex-M4 SIMD intrinsics (CMSIS names) used
+// by the library's DSP code path, so that path can be checked on a host
+// build. Compile the library with -DICAP_DSP_EMULATE to use these instead
+// of the portable code. Far slower than either; for testing only.
+
+#include <stdint.h>
+
+static uint8_t iCap_emu_ge; // APSR.GE flags, bit per byte lane
+
+// Per-halfword unsigned subtract, GE bit pair set where op1 >= op2
+static inline uint32_t __USUB16(uint32_t op1, uint32_t op2) {
+  uint32_t result = 0;
+  iCap_emu_ge = 0;
+  for (uint8_t i = 0; i < 2; i++) {
+    uint16_t a = op1 >> (i * 16), b = op2 >> (i * 16);
+    result |= (uint32_t)(uint16_t)(a - b) << (i * 16);
+    if (a >= b)
+      iCap_emu_ge |= 3 << (i * 2);
+  }
+  return result;
+}
+
+// Per-byte select by GE flags: op1 where set, op2 where clear
+static inline uint32_t __SEL(uint32_t op1, uint32_t op2) {
+  uint32_t result = 0;
+  for (uint8_t i = 0; i < 4; i++) {
+    uint32_t mask = 0xFFu << (i * 8);
+    result |= ((iCap_emu_ge >> i) & 1) ? (op1 & mask) : (op2 & mask);
+  }
+  return result;
+}
+
+// Byte-swap each halfword
+static inline uint32_t __REV16(uint32_t op1) {
+  return ((op1 & 0x00FF00FF) << 8) | ((op1 >> 8) & 0x00FF00FF);
+}
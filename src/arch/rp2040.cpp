@@ -6,9 +6,10 @@
 #include "hardware/pwm.h"
 #include <Adafruit_iCap_parallel.h>
 
-// PIO code in this table is modified at runtime so that PCLK is
+// PIO code in these tables is modified at runtime so that PCLK is
 // configurable (rather than fixed GP## or PIN offset). Data pins
-// must be contiguous but are otherwise configurable.
+// must be contiguous but are otherwise configurable. Every program starts
+// with the HSYNC wait; every other WAIT is on PCLK (see pcc_start()).
 static uint16_t iCap_pio_opcodes[] = {
     // Only monitor PCLK when HSYNC is high. This is more noise-immune
     // than letting it fly.
@@ -18,10 +19,63 @@ static uint16_t iCap_pio_opcodes[] = {
     0b0010000000000000, // WAIT 0 GPIO 0 (mask in PCLK pin before use)
 };
 
-static struct pio_program iCap_pio_program = {
-    .instructions = iCap_pio_opcodes,
-    .length = sizeof iCap_pio_opcodes / sizeof iCap_pio_opcodes[0],
-    .origin = -1,
+// Variant for ICAP_COLOR_Y8 capture: camera outputs YUV, but only the
+// first byte of each pair (the luma) reaches the RX FIFO, the other is
+// clocked past.
+static uint16_t iCap_pio_y8_opcodes[] = {
+    0b0010000010000000, // WAIT 1 GPIO 0 (mask in HSYNC pin before use)
+    0b0010000010000000, // WAIT 1 GPIO 0 (mask in PCLK pin before use)
+    0b0100000000001000, // IN PINS 8 -- 8 bits into RX FIFO
+    0b0010000000000000, // WAIT 0 GPIO 0 (mask in PCLK pin before use)
+    0b0010000010000000, // WAIT 1 GPIO 0 (mask in PCLK pin before use)
+    0b0010000000000000, // WAIT 0 GPIO 0 (mask in PCLK pin before use)
+};
+
+// Variant for ICAP_COLOR_RGB332 capture: camera outputs RGB565 (RRRRRGGG
+// GGGBBBBB) and the top bits of each channel are picked out of the pins
+// via OSR (OUT shifts right, discarding low bits) to make RRRGGGBB.
+static uint16_t iCap_pio_rgb332_opcodes[] = {
+    0b0010000010000000, // WAIT 1 GPIO 0 (mask in HSYNC pin before use)
+    0b0010000010000000, // WAIT 1 GPIO 0 (mask in PCLK pin before use)
+    0b1010000011100000, // MOV OSR, PINS
+    0b0110000001100101, // OUT NULL 5 -- drop R low bits
+    0b0100000011100011, // IN OSR 3 -- R bits 4-2
+    0b0100000000000011, // IN PINS 3 -- G bits 5-3
+    0b0010000000000000, // WAIT 0 GPIO 0 (mask in PCLK pin before use)
+    0b0010000010000000, // WAIT 1 GPIO 0 (mask in PCLK pin before use)
+    0b1010000011100000, // MOV OSR, PINS
+    0b0110000001100011, // OUT NULL 3 -- drop B low bits
+    0b0100000011100010, // IN OSR 2 -- B bits 4-3
+    0b0010000000000000, // WAIT 0 GPIO 0 (mask in PCLK pin before use)
+};
+
+// Variant for ICAP_COLOR_RGB444 capture: camera outputs xxxxRRRR GGGGBBBB
+// and the three nibbles are packed. All INs are 4 bits so the 32-bit
+// autopush always falls on a nibble boundary (an 8-bit IN could straddle
+// it and lose bits).
+static uint16_t iCap_pio_rgb444_opcodes[] = {
+    0b0010000010000000, // WAIT 1 GPIO 0 (mask in HSYNC pin before use)
+    0b0010000010000000, // WAIT 1 GPIO 0 (mask in PCLK pin before use)
+    0b0100000000000100, // IN PINS 4 -- R
+    0b0010000000000000, // WAIT 0 GPIO 0 (mask in PCLK pin before use)
+    0b0010000010000000, // WAIT 1 GPIO 0 (mask in PCLK pin before use)
+    0b1010000011100000, // MOV OSR, PINS
+    0b0110000001100100, // OUT NULL 4
+    0b0100000011100100, // IN OSR 4 -- G
+    0b0100000000000100, // IN PINS 4 -- B
+    0b0010000000000000, // WAIT 0 GPIO 0 (mask in PCLK pin before use)
+};
+
+#define ICAP_PIO_PROGRAM(opcodes)                                              \
+  {.instructions = opcodes,                                                    \
+   .length = sizeof opcodes / sizeof opcodes[0],                               \
+   .origin = -1}
+
+static struct pio_program iCap_pio_programs[] = {
+    ICAP_PIO_PROGRAM(iCap_pio_opcodes),        // RGB565, YUV, Bayer
+    ICAP_PIO_PROGRAM(iCap_pio_y8_opcodes),     // Y8
+    ICAP_PIO_PROGRAM(iCap_pio_rgb332_opcodes), // RGB332
+    ICAP_PIO_PROGRAM(iCap_pio_rgb444_opcodes), // RGB444
 };
 
 // Because interrupts exist outside the class context, but our interrupt
@@ -32,14 +86,36 @@ static Adafruit_ImageCapture *capptr = NULL; // Camera buffer, size, etc.
 static iCap_arch *archptr = NULL;            // DMA settings
 static volatile bool frameReady = false;     // true at end-of-frame
 static volatile bool suspended = true;       // Initially stopped
+static uint32_t dma_count = 0;               // DMA transfers/frame
+static uint32_t dma_pixels = 0;              // Pixels/frame
+static const struct pio_program *pio_prog;   // Program currently loaded
+static uint pio_offset;                      // Its location in PIO memory
+static uint8_t pio_push_bits;                // ISR autopush threshold
+static uint8_t pio_data_pin;                 // Data bit 0 GPIO
+
+// (Re)initialize the state machine for the loaded PIO program. Each DMA
+// transfer is one ISR push of 'push_bits' (8, 16 or 32).
+static void iCap_pio_init(uint8_t push_bits) {
+  pio_sm_config c = pio_get_default_sm_config();
+  c.pinctrl = 0; // SDK fails to set this
+  sm_config_set_wrap(&c, pio_offset, pio_offset + pio_prog->length - 1);
+
+  sm_config_set_in_pins(&c, pio_data_pin);
+  sm_config_set_in_shift(&c, false, true, push_bits); // ISR to FIFO
+  sm_config_set_out_shift(&c, true, false, 32); // OSR right, for bit picks
+  sm_config_set_fifo_join(&c, PIO_FIFO_JOIN_RX);
+
+  pio_sm_init(archptr->pio, archptr->sm, pio_offset, &c);
+  pio_push_bits = push_bits;
+}
 
 // This is NOT a sleep function, it just pauses background DMA.
 
 void Adafruit_iCap_parallel::suspend(void) {
   if (!suspended) {
-    while (!frameReady)
-      ;               // Wait for current frame to finish loading
     suspended = true; // Don't load next frame (camera runs, DMA stops)
+    while (!frameReady)
+      ; // Wait for current frame to finish loading (JPEG: next VSYNC)
   }
 }
 
@@ -52,29 +128,62 @@ void Adafruit_iCap_parallel::resume(void) {
 
 // INTERRUPT HANDLING AND RELATED CODE -------------------------------------
 
-// To do: use the arch state variable to detect when a VSYNC IRQ occurs
-// before the last DMA transfer is complete (suggesting one or more pixels
-// dropped, likely bad PCLK signal). If that happens, abort the DMA
-// transfer and return, skip frames and don't begin next DMA until abort
-// has completed (this is what state var is for, to detect if in this
-// holding pattern).
-
-// Pin interrupt on VSYNC calls this to start DMA transfer (unless suspended).
+// Pin interrupt on VSYNC calls this to start DMA transfer (unless
+// suspended). Destination buffer is selected anew each frame, rotating
+// when multi-buffered. A transfer still running is ended first, even
+// when suspended: for JPEG, that's how every frame finishes.
 static void iCap_vsync_irq(uint gpio, uint32_t events) {
+  uint32_t now = micros();
+  int ch = archptr->dma_channel;
+  if (dma_channel_is_busy(ch)) {
+    // Abort the transfer (with IRQ masked, else abort may signal
+    // completion -- RP2040-E13).
+    uint32_t remaining = dma_channel_hw_addr(ch)->transfer_count;
+    dma_channel_set_irq0_enabled(ch, false);
+    dma_channel_abort(ch);
+    dma_channel_acknowledge_irq0(ch);
+    dma_channel_set_irq0_enabled(ch, true);
+    if (capptr->getColorspace() == ICAP_COLOR_JPEG) {
+      // Variable-length frame, transfers are bytes
+      capptr->frameEnd(dma_count - remaining);
+    } else {
+      // VSYNC occurred before the last DMA transfer completed, suggesting
+      // one or more pixels dropped (likely bad PCLK signal). Carry on
+      // with the new frame as normal.
+      capptr->frameAbort((uint64_t)(dma_count - remaining) * dma_pixels /
+                         dma_count);
+    }
+    frameReady = true;
+  }
   if (!suspended) {
-    frameReady = false;
-    // Clear PIO FIFOs and start DMA transfer
-    pio_sm_clear_fifos(archptr->pio, archptr->sm);
-    dma_channel_start(archptr->dma_channel);
+    uint16_t *dest = capptr->frameStart(now);
+    if (dest) { // NULL if no buffer available, skip frame
+      frameReady = false;
+      // Clear PIO FIFOs, set DMA destination and start transfer. The
+      // state machine may have stalled or been cut off partway through a
+      // pixel or byte pair (full FIFO while suspended or with no buffer
+      // free, or an aborted frame). Restart clears the ISR and counters,
+      // but not the program counter, so also jump to the program start;
+      // else two-bytes-per-loop formats (Y8, RGB332, RGB444) would stay
+      // on the wrong byte of each pair from then on.
+      pio_sm_clear_fifos(archptr->pio, archptr->sm);
+      pio_sm_restart(archptr->pio, archptr->sm);
+      pio_sm_exec(archptr->pio, archptr->sm, pio_encode_jmp(pio_offset));
+      dma_channel_set_write_addr(ch, dest, true);
+    } else {
+      frameReady = true; // Nothing loading, don't stall suspend()
+    }
   }
 }
 
 static void iCap_dma_finish_irq() {
-  // DMA transfer completed. Set up (but do not trigger) next one.
+  // DMA transfer completed. Next one is set up and triggered on VSYNC.
   frameReady = true;
-  // Channel MUST be reconfigured each time (to reset the dest address).
-  dma_channel_set_write_addr(archptr->dma_channel,
-                             (uint8_t *)(capptr->getBuffer()), false);
+  if (capptr->getColorspace() == ICAP_COLOR_JPEG) {
+    capptr->frameEnd(dma_count); // Buffer full, complete only if EOI's in
+  } else {
+    capptr->frameDone(dma_pixels); // Publish newest frame
+  }
   dma_hw->ints0 = 1u << archptr->dma_channel; // Clear IRQ
 }
 
@@ -132,28 +241,29 @@ iCap_status Adafruit_iCap_parallel::pcc_start(void) {
   // PIO periph to use is currently specified by the user in the arch struct,
   // but I suppose this could be written to use whatever PIO has resources.
 
-  // Mask the GPIO pin used PCLK into the PIO opcodes -- see notes at top
-  iCap_pio_opcodes[0] |= (pins.hsync & 31);
-  iCap_pio_opcodes[1] |= (pins.pclk & 31);
-  iCap_pio_opcodes[3] |= (pins.pclk & 31);
+  // Mask the GPIO pins used for HSYNC and PCLK into the PIO opcodes --
+  // see notes at top
+  for (uint8_t p = 0; p < 4; p++) {
+    uint16_t *op = (uint16_t *)iCap_pio_programs[p].instructions;
+    op[0] |= (pins.hsync & 31);
+    for (uint8_t i = 1; i < iCap_pio_programs[p].length; i++) {
+      if ((op[i] & 0xE000) == 0x2000) // WAIT
+        op[i] |= (pins.pclk & 31);
+    }
+  }
 
-  // Here's where resource check & switch between pio0/1 might go
-  uint offset = pio_add_program(arch->pio, &iCap_pio_program);
+  // Here's where resource check & switch between pio0/1 might go.
+  // Only one program is loaded at a time; dma_change() swaps as needed.
+  pio_prog = &iCap_pio_programs[0];
+  pio_offset = pio_add_program(arch->pio, pio_prog);
   arch->sm = pio_claim_unused_sm(arch->pio, true); // 0-3
 
   // host->pins->data[0] is data bit 0. PIO code requires all 8 data be
   // contiguous.
   pio_sm_set_consecutive_pindirs(arch->pio, arch->sm, pins.data[0], 8, false);
 
-  pio_sm_config c = pio_get_default_sm_config();
-  c.pinctrl = 0; // SDK fails to set this
-  sm_config_set_wrap(&c, offset, offset + iCap_pio_program.length - 1);
-
-  sm_config_set_in_pins(&c, pins.data[0]);
-  sm_config_set_in_shift(&c, false, true, 16); // 1 pixel (16b) ISR to FIFO
-  sm_config_set_fifo_join(&c, PIO_FIFO_JOIN_RX);
-
-  pio_sm_init(arch->pio, arch->sm, offset, &c);
+  pio_data_pin = pins.data[0];
+  iCap_pio_init(16); // 16-bit until dma_change() says otherwise
   pio_sm_set_enabled(arch->pio, arch->sm, true);
 
   // SET UP DMA ------------------------------------------------------------
@@ -192,9 +302,55 @@ iCap_status Adafruit_iCap_parallel::pcc_start(void) {
 // Changing resolution also requires stopping DMA temporarily...
 // wait for frame to finish, do realloc/cam config, then restart.
 // That'll go in Adafruit_iCap_parallel.cpp
-void Adafruit_iCap_parallel::dma_change(uint16_t *dest, uint32_t num_pixels) {
+// PIO program and ISR push size (= DMA transfer size) follow colorspace.
+// The 8-bit formats push every pixel; RGB444 pushes 32 bits (8 nibbles),
+// byte-swapped by DMA regardless of arch->bswap so the packed nibbles land
+// in order (frame bytes must then be a multiple of 4, as with any size
+// the OV7670 supports).
+iCap_status Adafruit_iCap_parallel::dma_change(uint16_t *dest,
+                                               uint32_t num_pixels) {
+  uint8_t program = 0, push_bits = 8;
+  switch (colorspace) {
+  case ICAP_COLOR_RGB565:
+  case ICAP_COLOR_YUV:
+    push_bits = 16;
+    break;
+  case ICAP_COLOR_Y8:
+    program = 1;
+    break;
+  case ICAP_COLOR_RGB332:
+    program = 2;
+    break;
+  case ICAP_COLOR_RGB444:
+    program = 3;
+    push_bits = 32;
+    break;
+  default: // Bayer, 1 byte/pixel as-is, or JPEG byte stream
+    break;
+  }
+  const struct pio_program *prog = &iCap_pio_programs[program];
+  if ((prog != pio_prog) || (push_bits != pio_push_bits)) {
+    pio_sm_set_enabled(archptr->pio, archptr->sm, false);
+    if (prog != pio_prog) {
+      pio_remove_program(archptr->pio, pio_prog, pio_offset);
+      pio_prog = prog;
+      pio_offset = pio_add_program(archptr->pio, pio_prog);
+    }
+    iCap_pio_init(push_bits);
+    pio_sm_set_enabled(archptr->pio, archptr->sm, true);
+    channel_config_set_transfer_data_size(
+        &archptr->dma_config, (push_bits == 8)    ? DMA_SIZE_8
+                              : (push_bits == 16) ? DMA_SIZE_16
+                                                  : DMA_SIZE_32);
+    channel_config_set_bswap(&archptr->dma_config,
+                             (push_bits == 32) || archptr->bswap);
+    dma_channel_set_config(archptr->dma_channel, &archptr->dma_config, false);
+  }
+  dma_pixels = num_pixels; // Saved for frame metadata
+  dma_count = num_pixels * bitsPerPixel(colorspace) / push_bits;
   dma_channel_set_write_addr(archptr->dma_channel, dest, false);
-  dma_channel_set_trans_count(archptr->dma_channel, num_pixels, false);
+  dma_channel_set_trans_count(archptr->dma_channel, dma_count, false);
+  return ICAP_STATUS_OK;
 }
 
 #endif // end ARDUINO_ARCH_RP2040
@@ -9,15 +9,20 @@
 #include <wiring_private.h> // pinPeripheral() function
 
 // Because interrupts exist outside the class context, but our interrupt
-// needs to access to an active ZeroDMA object, a separate ZeroDMA pointer
-// is kept (initialized in the begin() function). This does mean that only
-// a single OV7670 can be active (probably no big deal, as there's only a
-// single parallel capture peripheral).
+// needs to access to an active ZeroDMA object and the camera buffers, a
+// separate ZeroDMA instance and object pointer are kept (the latter is
+// initialized in pcc_start()). This does mean that only a single OV7670
+// can be active (probably no big deal, as there's only a single parallel
+// capture peripheral).
 
 static Adafruit_ZeroDMA dma;
-static DmacDescriptor *descriptor;       ///< DMA descriptor
-static volatile bool frameReady = false; ///< true at end-of-frame
-static volatile bool suspended = true;   ///< Start in suspended state
+static DmacDescriptor *descriptor;           ///< DMA descriptor
+static Adafruit_ImageCapture *capptr = NULL; ///< Camera buffer, size, etc.
+static uint32_t dma_beats = 0;               ///< 32-bit transfers per frame
+static uint8_t beat_pixels = 2;              ///< Pixels per 32-bit beat
+static volatile bool dma_busy = false;       ///< true while DMA active
+static volatile bool frameReady = false;     ///< true at end-of-frame
+static volatile bool suspended = true;       ///< Start in suspended state
 
 // Since ZeroDMA suspend/resume functions don't yet work, these functions
 // use static vars to indicate whether to trigger DMA transfers or hold off
@@ -26,9 +31,9 @@ static volatile bool suspended = true;   ///< Start in suspended state
 // This is NOT a sleep function, it just pauses background DMA.
 
 void Adafruit_iCap_parallel::suspend(void) {
-  while (!frameReady)
-    ;               // Wait for current frame to finish loading
   suspended = true; // Don't load next frame (camera runs, DMA stops)
+  while (!frameReady)
+    ; // Wait for current frame to finish loading (JPEG: next VSYNC)
 }
 
 // NOT a wake function, just resumes background DMA.
@@ -40,16 +45,51 @@ void Adafruit_iCap_parallel::resume(void) {
 
 // INTERRUPT HANDLING AND RELATED CODE -------------------------------------
 
-// Pin interrupt on VSYNC calls this to start DMA transfer (unless suspended).
+// Pin interrupt on VSYNC calls this to start DMA transfer (unless
+// suspended). Destination buffer is selected anew each frame, rotating
+// when multi-buffered. A transfer still running is ended first, even
+// when suspended: for JPEG, that's how every frame finishes.
 static void startFrame(void) {
+  uint32_t now = micros();
+  if (dma_busy) {
+    // ZeroDMA doesn't expose the remaining count of an aborted job, so
+    // the amount transferred is reported as 0 (unknown).
+    dma.abort();
+    dma_busy = false;
+    if (capptr->getColorspace() == ICAP_COLOR_JPEG) {
+      capptr->frameEnd(0); // Variable-length frame, library finds EOI
+    } else {
+      // VSYNC occurred before the last DMA transfer completed, suggesting
+      // one or more pixels dropped (likely bad PCLK signal). Carry on with
+      // the new frame as normal (PCC clears its own state on VSYNC).
+      capptr->frameAbort(0);
+    }
+    frameReady = true;
+  }
   if (!suspended) {
-    frameReady = false;
-    (void)dma.startJob();
+    uint16_t *dest = capptr->frameStart(now);
+    if (dest) { // NULL if no buffer available, skip frame
+      frameReady = false;
+      dma_busy = true;
+      dma.changeDescriptor(descriptor, (void *)(&PCC->RHR.reg), (void *)dest,
+                           dma_beats);
+      (void)dma.startJob();
+    } else {
+      frameReady = true; // Nothing loading, don't stall suspend()
+    }
   }
 }
 
 // End-of-DMA-transfer callback
-static void dmaCallback(Adafruit_ZeroDMA *dma) { frameReady = true; }
+static void dmaCallback(Adafruit_ZeroDMA *dma) {
+  dma_busy = false;
+  frameReady = true;
+  if (capptr->getColorspace() == ICAP_COLOR_JPEG) {
+    capptr->frameEnd(dma_beats); // Buffer full, complete only if EOI's in
+  } else {
+    capptr->frameDone(dma_beats * beat_pixels); // Publish newest frame
+  }
+}
 
 // XCLK clock out setup. For self-clocking cameras, don't call this function,
 // e.g. Adafruit_iCap_parallel.begin() checks the value of the xlck pin and
@@ -190,6 +230,8 @@ iCap_status Adafruit_iCap_parallel::xclk_start(uint32_t freq) {
 // Start parallel capture peripheral
 iCap_status Adafruit_iCap_parallel::pcc_start(void) {
 
+  capptr = this; // Save object pointer for interrupts
+
   PCC->MR.bit.PCEN = 0; // Make sure PCC is disabled before setting MR reg
 
   PCC->IDR.reg = 0b1111;       // Disable all PCC interrupts
@@ -245,9 +287,38 @@ iCap_status Adafruit_iCap_parallel::pcc_start(void) {
   return ICAP_STATUS_OK;
 }
 
-void Adafruit_iCap_parallel::dma_change(uint16_t *dest, uint32_t num_pixels) {
+// PCC packs camera bytes in order, four per 32-bit beat. ICAP_COLOR_Y8
+// uses PCC half-sampling to keep only the even-index bytes (luma) of the
+// camera's YUV output; Bayer is one byte per pixel as-is. PCC can't repack
+// bits within bytes, so RGB332 and RGB444 capture aren't supported here.
+// JPEG is moved a byte per beat instead, as a frame's length needn't be a
+// multiple of 4 and PCC discards a partial word at VSYNC.
+iCap_status Adafruit_iCap_parallel::dma_change(uint16_t *dest,
+                                               uint32_t num_pixels) {
+  if ((colorspace == ICAP_COLOR_RGB332) || (colorspace == ICAP_COLOR_RGB444)) {
+    return ICAP_STATUS_ERR_PERIPHERAL;
+  }
+  bool jpeg = (colorspace == ICAP_COLOR_JPEG);
+  uint8_t px = 32 / bitsPerPixel(colorspace);
+  bool halfs = (colorspace == ICAP_COLOR_Y8);
+  uint8_t dsize = jpeg ? 0x0 : 0x2; // 1 or 4 data per RHR read
+  if ((px != beat_pixels) || (halfs != PCC->MR.bit.HALFS) ||
+      (dsize != PCC->MR.bit.DSIZE)) {
+    PCC->MR.bit.PCEN = 0; // MR can only be changed while disabled
+    PCC->MR.bit.HALFS = halfs;
+    PCC->MR.bit.FRSTS = 0; // Even samples
+    PCC->MR.bit.DSIZE = dsize;
+    PCC->MR.bit.PCEN = 1;
+    descriptor->BTCTRL.bit.BEATSIZE =
+        jpeg ? DMA_BEAT_SIZE_BYTE : DMA_BEAT_SIZE_WORD;
+    beat_pixels = px;
+  }
+  // Saved for startFrame(), dest may rotate
+  dma_beats = jpeg ? (num_pixels * bitsPerPixel(colorspace) + 7) / 8
+                   : num_pixels / px;
   dma.changeDescriptor(descriptor, (void *)(&PCC->RHR.reg), (void *)dest,
-                       num_pixels / 2);
+                       dma_beats);
+  return ICAP_STATUS_OK;
 }
 
 #endif // end __SAMD51__